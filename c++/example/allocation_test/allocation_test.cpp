@@ -0,0 +1,147 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+//
+// *********     Allocation Test Example      *********
+//
+// This example checks that the transactions of a control loop allocate no memory once they run.
+// Every malloc(), calloc() and realloc() of the program and the libraries it uses is counted,
+// operator new included, which allocates with malloc(). A read, a write, a Sync Write and a Sync Read
+// and Fast Sync Read go to emulated Mercurys for a few cycles to warm up, after which
+// the same cycles must not allocate at all. The example exits with 1 when they do.
+//
+// Usage : ./allocation_test
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+
+#include "mercury_sdk.h"                                   // Uses Mercury SDK library
+
+using namespace mercury;
+
+#define ADDR_GOAL_POSITION      ServoEmulator::ADDR_GOAL_POSITION
+#define ADDR_PRESENT_POSITION   ServoEmulator::ADDR_PRESENT_POSITION
+#define SERVO_COUNT             4
+#define WARM_UP_CYCLES          10
+#define TEST_CYCLES             1000
+
+static std::atomic<long> allocation_count(0);
+
+// the allocator of the C library under its own names, which the wrappers below forward to
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+// the program defines the allocation functions, so they take the place of those of the C library
+// for the SDK and the C++ library as well
+extern "C" void *malloc(size_t size) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, size_t size) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(p, size);
+}
+
+// One cycle of a control loop, returns false when a transaction fails
+static bool runCycle(PacketHandler *ph, PortHandler *port, GroupSyncWrite *sync_write, GroupSyncRead *sync_read,
+                     GroupSyncRead *fast_sync_read, int cycle)
+{
+  bool is_ok = true;
+  uint8_t  error = 0;
+  uint32_t position = 0;
+
+  for (uint8_t id = 1; id <= SERVO_COUNT; id++)
+  {
+    uint32_t goal = 0x00FDFFFF + (uint32_t)cycle * SERVO_COUNT + id;   // FF FF FD, so some packets are stuffed
+    uint8_t data[4] = { MCY_LOBYTE(MCY_LOWORD(goal)), MCY_HIBYTE(MCY_LOWORD(goal)),
+                        MCY_LOBYTE(MCY_HIWORD(goal)), MCY_HIBYTE(MCY_HIWORD(goal)) };
+    sync_write->changeParam(id, data);
+  }
+  is_ok &= (sync_write->txPacket() == COMM_SUCCESS);
+  is_ok &= (sync_read->txRxPacket() == COMM_SUCCESS);
+  is_ok &= (fast_sync_read->txRxPacket() == COMM_SUCCESS);
+
+  is_ok &= (ph->write4ByteTxRx(port, 1, ADDR_GOAL_POSITION, (uint32_t)cycle, &error) == COMM_SUCCESS);
+  is_ok &= (ph->read4ByteTxRx(port, 1, ADDR_PRESENT_POSITION, &position, &error) == COMM_SUCCESS);
+  is_ok &= (position == (uint32_t)cycle);
+
+  return is_ok;
+}
+
+int main()
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  PortHandlerEmulator port("emulator", PortHandlerEmulator::CLOCK_VIRTUAL);
+  for (uint8_t id = 1; id <= SERVO_COUNT; id++)
+    port.getBus()->addServo(id)->getControlTable()[ServoEmulator::ADDR_CONTROL_ENABLE] = 1;
+  port.openPort();
+
+  GroupSyncWrite groupSyncWrite(&port, packetHandler, ADDR_GOAL_POSITION, 4);
+  GroupSyncRead groupSyncRead(&port, packetHandler, ADDR_PRESENT_POSITION, 4);
+  GroupSyncRead groupFastSyncRead(&port, packetHandler, ADDR_PRESENT_POSITION, 4);
+  groupFastSyncRead.setFastRead(true);
+
+  uint8_t data[4] = { 0, 0, 0, 0 };
+  for (uint8_t id = 1; id <= SERVO_COUNT; id++)
+  {
+    groupSyncWrite.addParam(id, data);
+    groupSyncRead.addParam(id);
+    groupFastSyncRead.addParam(id);
+  }
+
+  // the first cycles size the buffers of the groups, the parser and the emulator
+  for (int cycle = 0; cycle < WARM_UP_CYCLES; cycle++)
+  {
+    if (runCycle(packetHandler, &port, &groupSyncWrite, &groupSyncRead, &groupFastSyncRead, cycle) == false)
+    {
+      printf("A transaction failed while warming up\n");
+      return 1;
+    }
+  }
+
+  // the groups and the emulator allocate while they are set up, which shows the count works
+  long count_before = allocation_count.load();
+  if (count_before == 0)
+  {
+    printf("The allocations of the SDK are not counted\n");
+    return 1;
+  }
+
+  bool is_ok = true;
+  for (int cycle = WARM_UP_CYCLES; cycle < WARM_UP_CYCLES + TEST_CYCLES; cycle++)
+    is_ok &= runCycle(packetHandler, &port, &groupSyncWrite, &groupSyncRead, &groupFastSyncRead, cycle);
+  long count = allocation_count.load() - count_before;
+
+  printf("%d cycles: %ld allocations\n", TEST_CYCLES, count);
+  if (is_ok == false)
+  {
+    printf("A transaction failed\n");
+    return 1;
+  }
+  return (count == 0) ? 0 : 1;
+}
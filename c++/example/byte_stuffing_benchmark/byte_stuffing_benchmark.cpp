@@ -0,0 +1,170 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+//
+// *********     Byte Stuffing Benchmark Example      *********
+//
+// This example measures ByteStuffing::find(), stuff() and unstuff() against memcpy() and against
+// the byte at a time loops used where SSE2 is missing, on parameters of a short and of a full packet.
+// The patterns go from random data to all 0xFF, the worst case of a scan which stops at every 0xFF,
+// and FF FF FD repeated, where every third byte has to be stuffed.
+// The results of the SDK are first checked against the byte at a time loops, so the example also fails when they differ.
+//
+// The last column is the wire time of the parameter at BAUDRATE. When the SSE2 code takes a small part of it,
+// a wider AVX2 scan could only shave that part.
+//
+// Usage : ./byte_stuffing_benchmark [MB]
+//   MB  bytes to run through each function for each case, in megabytes (default: 16)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mercury_sdk.h"                                   // Uses Mercury SDK library
+
+using namespace mercury;
+
+#define BAUDRATE                4500000
+#define PATTERN_COUNT           4
+#define SIZE_COUNT              2
+#define FUNCTION_COUNT          6
+
+static const char *pattern_name[PATTERN_COUNT]   = { "random", "zero", "all FF", "FF FF FD" };
+static const uint32_t size[SIZE_COUNT]           = { 64, PortHandler::TX_PACKET_LENGTH_ * 3 / 4 };   // 3/4: room for the stuffing
+static const char *function_name[FUNCTION_COUNT] = { "memcpy", "find", "stuff", "stuff 1x", "unstuff", "unstuff 1x" };
+
+static uint8_t data[PortHandler::TX_PACKET_LENGTH_];
+static uint8_t stuffed[PortHandler::TX_PACKET_LENGTH_];
+static uint8_t output[PortHandler::TX_PACKET_LENGTH_];
+
+static bool isHeaderEnd(const uint8_t *bytes)
+{
+  return bytes[0] == 0xFD && bytes[-1] == 0xFF && bytes[-2] == 0xFF;
+}
+
+// The byte at a time stuffing, as ByteStuffing does without SSE2
+static uint32_t stuffBytewise(const uint8_t *in, uint32_t length, uint8_t *out)
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < length; i++)
+  {
+    out[n++] = in[i];
+    if (i >= 2 && isHeaderEnd(in + i))
+      out[n++] = 0xFD;
+  }
+  return n;
+}
+
+static uint32_t unstuffBytewise(const uint8_t *in, uint32_t length, uint8_t *out)
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < length; i++)
+  {
+    if (i < 3 || in[i] != 0xFD || isHeaderEnd(in + i - 1) == false)
+      out[n++] = in[i];
+  }
+  return n;
+}
+
+static void fill(int pattern, uint32_t length)
+{
+  static const uint8_t header[3] = { 0xFF, 0xFF, 0xFD };
+
+  for (uint32_t i = 0; i < length; i++)
+  {
+    switch (pattern)
+    {
+      case 0:  data[i] = (uint8_t)rand(); break;
+      case 1:  data[i] = 0x00;            break;
+      case 2:  data[i] = 0xFF;            break;
+      default: data[i] = header[i % 3];   break;
+    }
+  }
+}
+
+static uint32_t run(int function, uint32_t length, uint32_t stuffed_length)
+{
+  switch (function)
+  {
+    case 0:  memcpy(output, data, length); return length;
+    case 1:  return ByteStuffing::find(data, length);
+    case 2:  return ByteStuffing::stuff(data, length, output);
+    case 3:  return stuffBytewise(data, length, output);
+    case 4:  return ByteStuffing::unstuff(stuffed, 0, stuffed_length, output);
+    default: return unstuffBytewise(stuffed, stuffed_length, output);
+  }
+}
+
+// Returns the time per call in nsec
+static double measure(int function, uint32_t length, uint32_t stuffed_length, uint64_t total_bytes)
+{
+  uint64_t count = total_bytes / length;
+  uint64_t sum = 0;
+
+  int64_t start = MonotonicClock::getTime();
+  for (uint64_t n = 0; n < count; n++)
+    sum += run(function, length, stuffed_length) + 1;
+  int64_t time = MonotonicClock::getTime() - start;
+
+  // the results are used, so that the compiler can't leave out a call
+  if (sum != count * (run(function, length, stuffed_length) + 1))
+    printf("(unstable) ");
+  return (double)time / (double)count;
+}
+
+int main(int argc, char *argv[])
+{
+  uint64_t total_bytes = 16 * 1024 * 1024;
+  if (argc > 1)
+    total_bytes = (uint64_t)atoi(argv[1]) * 1024 * 1024;
+
+  srand(1);
+
+  printf("%-9s %6s", "pattern", "bytes");
+  for (int f = 0; f < FUNCTION_COUNT; f++)
+    printf(" %10s", function_name[f]);
+  printf(" %10s\n", "wire");
+  printf("%-9s %6s", "", "");
+  for (int f = 0; f <= FUNCTION_COUNT; f++)
+    printf(" %10s", "ns");
+  printf("\n");
+
+  for (int p = 0; p < PATTERN_COUNT; p++)
+  {
+    for (int s = 0; s < SIZE_COUNT; s++)
+    {
+      fill(p, size[s]);
+
+      // the SDK has to match the byte at a time loops before it is timed
+      uint32_t stuffed_length = stuffBytewise(data, size[s], stuffed);
+      if (ByteStuffing::stuff(data, size[s], output) != stuffed_length || memcmp(output, stuffed, stuffed_length) != 0 ||
+          ByteStuffing::count(data, size[s]) != stuffed_length - size[s] ||
+          ByteStuffing::unstuff(stuffed, 0, stuffed_length, output) != size[s] || memcmp(output, data, size[s]) != 0)
+      {
+        printf("ByteStuffing gives a wrong result for the %s pattern\n", pattern_name[p]);
+        return 1;
+      }
+
+      printf("%-9s %6d", pattern_name[p], size[s]);
+      for (int f = 0; f < FUNCTION_COUNT; f++)
+        printf(" %10.1f", measure(f, size[s], stuffed_length, total_bytes));
+      printf(" %10.0f\n", (double)stuffed_length * 10.0 * 1e9 / BAUDRATE);   // 10: start, 8 data and stop bits
+    }
+  }
+
+  return 0;
+}
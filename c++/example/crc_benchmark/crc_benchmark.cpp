@@ -0,0 +1,101 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+//
+// *********     CRC Benchmark Example      *********
+//
+// This example measures the CRC-16 of Protocol 2.0 packets with each engine of Crc16, on packets
+// from the size of a short status packet up to the size of the packet buffers (TX_PACKET_LENGTH_).
+// The engines are first checked against each other, so the example also fails when one of them is wrong.
+//
+// Usage : ./crc_benchmark [MB]
+//   MB  bytes to run through each engine for each packet size, in megabytes (default: 16)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mercury_sdk.h"                                   // Uses Mercury SDK library
+
+using namespace mercury;
+
+#define PACKET_SIZE_COUNT       8
+
+static const uint16_t packet_size[PACKET_SIZE_COUNT] = { 8, 16, 32, 64, 128, 256, 512, PortHandler::TX_PACKET_LENGTH_ };
+
+static const Crc16::Engine engine[3]    = { Crc16::ENGINE_TABLE, Crc16::ENGINE_SLICE8, Crc16::ENGINE_CLMUL };
+static const char *engine_name[3]       = { "table", "slice-by-8", "clmul" };
+
+// Returns the time per packet in nsec, every packet continues the CRC of the one before as a stream of packets would
+static double measure(Crc16::Engine engine, const uint8_t *packet, uint16_t size, uint64_t total_bytes)
+{
+  uint64_t count = total_bytes / size;
+  if (count == 0)
+    count = 1;
+
+  uint16_t crc_accum = 0;
+  int64_t start = MonotonicClock::getTime();
+  for (uint64_t n = 0; n < count; n++)
+    crc_accum = Crc16::update(engine, crc_accum, packet, size);
+  int64_t time = MonotonicClock::getTime() - start;
+
+  return (double)time / (double)count;
+}
+
+int main(int argc, char *argv[])
+{
+  uint64_t total_bytes = 16 * 1024 * 1024;
+  if (argc > 1)
+    total_bytes = (uint64_t)atoi(argv[1]) * 1024 * 1024;
+
+  uint8_t packet[PortHandler::TX_PACKET_LENGTH_];
+  srand(1);
+  for (int i = 0; i < PortHandler::TX_PACKET_LENGTH_; i++)
+    packet[i] = (uint8_t)rand();
+
+  // every engine has to give the CRC of the table, whatever the length and the start
+  for (uint16_t size = 0; size <= PortHandler::TX_PACKET_LENGTH_; size++)
+  {
+    uint16_t expected = Crc16::update(Crc16::ENGINE_TABLE, 0x1234, packet, size);
+    for (int e = 1; e < 3; e++)
+    {
+      if (Crc16::update(engine[e], 0x1234, packet, size) != expected)
+      {
+        printf("The %s engine gives a wrong CRC for %d bytes\n", engine_name[e], size);
+        return 1;
+      }
+    }
+  }
+
+  printf("Crc16::update() uses the %s engine on this processor\n", engine_name[Crc16::getEngine()]);
+  printf("%8s", "bytes");
+  for (int e = 0; e < 3; e++)
+    printf("  %10s ns  %7s", engine_name[e], "MB/s");
+  printf("\n");
+
+  for (int s = 0; s < PACKET_SIZE_COUNT; s++)
+  {
+    printf("%8d", packet_size[s]);
+    for (int e = 0; e < 3; e++)
+    {
+      double nsec = measure(engine[e], packet, packet_size[s], total_bytes);
+      printf("  %13.1f  %7.0f", nsec, (double)packet_size[s] * 1000.0 / nsec);
+    }
+    printf("\n");
+  }
+
+  return 0;
+}
@@ -0,0 +1,571 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+//
+// *********     Emulator Test Example      *********
+//
+// This example runs the SDK against emulated Mercurys and checks every result, so that it can be
+// run as a test without hardware. Each check which fails is printed, and the example exits with 1.
+//
+// Usage : ./emulator_test
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+#include "mercury_sdk.h"                                   // Uses Mercury SDK library
+
+using namespace mercury;
+
+#define ADDR_GOAL_POSITION      ServoEmulator::ADDR_GOAL_POSITION
+#define ADDR_PRESENT_POSITION   ServoEmulator::ADDR_PRESENT_POSITION
+#define TEST_TIMEOUT            20      // sec, a test which hangs ends the example
+#define ASYNC_THREAD_COUNT      4
+#define ADDR_SHARED             0x70    // free area of the control table
+#define SHARED_LENGTH           128
+
+static int check_count   = 0;
+static int failure_count = 0;
+
+static void check(bool condition, const char *name)
+{
+  check_count++;
+  if (condition == false)
+  {
+    failure_count++;
+    printf("FAIL: %s\n", name);
+  }
+}
+
+static PortHandlerEmulator *openBus(PortHandlerEmulator::ClockMode clock_mode, int servo_count)
+{
+  PortHandlerEmulator *port = new PortHandlerEmulator("emulator", clock_mode);
+  for (int id = 1; id <= servo_count; id++)
+    port->getBus()->addServo(id)->getControlTable()[ServoEmulator::ADDR_CONTROL_ENABLE] = 1;
+  port->openPort();
+  return port;
+}
+
+// Writes a goal, reads it back as the present position and pings a Mercury which isn't on the bus
+static Task<> runTransactions(CoPacketHandler *co_ph, PortHandler *port, uint8_t id, uint32_t goal, int *finished)
+{
+  uint8_t  error = 0;
+  uint32_t position = 0;
+
+  check(co_await co_ph->write4ByteTxRx(port, id, ADDR_GOAL_POSITION, goal, &error) == COMM_SUCCESS, "coroutine write");
+  check(co_await co_ph->read4ByteTxRx(port, id, ADDR_PRESENT_POSITION, &position, &error) == COMM_SUCCESS, "coroutine read");
+  check(position == goal, "coroutine read data");
+  check(co_await co_ph->ping(port, id + 100) == COMM_RX_TIMEOUT, "coroutine ping of a missing Mercury");
+  (*finished)++;
+}
+
+static void testCoroutines(PortHandlerEmulator::ClockMode clock_mode)
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  EventLoop loop;
+  CoPacketHandler coPacketHandler(&loop, packetHandler);
+
+  PortHandlerEmulator *port[2] = { openBus(clock_mode, 2), openBus(clock_mode, 2) };
+  int finished = 0;
+
+  // two transactions share each port and take turns, the ports run side by side
+  for (int p = 0; p < 2; p++)
+  {
+    for (uint8_t id = 1; id <= 2; id++)
+      runTransactions(&coPacketHandler, port[p], id, 0x00FDFFFF + id, &finished).spawn();
+  }
+  loop.run();
+
+  check(finished == 4, "every coroutine finished");
+  delete port[0];
+  delete port[1];
+}
+
+// Goal positions which hold FF FF FD, so that every packet which carries them is byte stuffed
+static uint32_t getGoal(int cycle, uint8_t id)
+{
+  if (cycle % 2 == 0)
+    return 0xFDFFFF00 | id;
+  return 0x00FDFFFF | ((uint32_t)id << 24);
+}
+
+static void setGoal(uint8_t *data, uint32_t goal)
+{
+  data[0] = MCY_LOBYTE(MCY_LOWORD(goal));
+  data[1] = MCY_HIBYTE(MCY_LOWORD(goal));
+  data[2] = MCY_LOBYTE(MCY_HIWORD(goal));
+  data[3] = MCY_HIBYTE(MCY_HIWORD(goal));
+}
+
+static void testSyncRead(bool is_fast_read)
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  PortHandlerEmulator *port = openBus(PortHandlerEmulator::CLOCK_VIRTUAL, 3);
+
+  GroupSyncWrite groupSyncWrite(port, packetHandler, ADDR_GOAL_POSITION, 4);
+  GroupSyncRead groupSyncRead(port, packetHandler, ADDR_PRESENT_POSITION, 4);
+  groupSyncRead.setFastRead(is_fast_read);
+
+  uint8_t data[4];
+  for (uint8_t id = 1; id <= 3; id++)
+  {
+    setGoal(data, 0);
+    groupSyncWrite.addParam(id, data);
+    groupSyncRead.addParam(id);
+  }
+
+  bool is_read = true;
+  for (int cycle = 0; cycle < 100; cycle++)
+  {
+    for (uint8_t id = 1; id <= 3; id++)
+    {
+      setGoal(data, getGoal(cycle, id));
+      groupSyncWrite.changeParam(id, data);
+    }
+    check(groupSyncWrite.txPacket() == COMM_SUCCESS, "sync write");
+    check(groupSyncRead.txRxPacket() == COMM_SUCCESS, "sync read");
+
+    for (uint8_t id = 1; id <= 3; id++)
+    {
+      if (groupSyncRead.isAvailable(id, ADDR_PRESENT_POSITION, 4) == false ||
+          groupSyncRead.getData(id, ADDR_PRESENT_POSITION, 4) != getGoal(cycle, id))
+        is_read = false;
+    }
+  }
+  check(is_read, "sync read data");
+
+  // a Mercury which doesn't answer fails the read, and with Fast Sync Read the packet which the others share
+  groupSyncRead.addParam(9);
+  check(groupSyncRead.txRxPacket() != COMM_SUCCESS, "sync read with a missing Mercury");
+  check(groupSyncRead.getResult(9) != COMM_SUCCESS, "result of the missing Mercury");
+  check(groupSyncRead.isAvailable(9, ADDR_PRESENT_POSITION, 4) == false, "data of the missing Mercury");
+  if (is_fast_read == false)
+  {
+    check(groupSyncRead.getResult(9) == COMM_RX_TIMEOUT, "timeout of the missing Mercury");
+    check(groupSyncRead.getResult(3) == COMM_SUCCESS, "result of the Mercury before the missing one");
+  }
+
+  // the others still answer once it is gone
+  groupSyncRead.removeParam(9);
+  check(groupSyncRead.txRxPacket() == COMM_SUCCESS, "sync read after the missing Mercury is removed");
+
+  // the status packets follow the instruction packet, even when the mode changes in between
+  check(groupSyncRead.txPacket() == COMM_SUCCESS, "sync read before the mode changes");
+  groupSyncRead.setFastRead(!is_fast_read);
+  check(groupSyncRead.rxPacket() == COMM_SUCCESS, "sync read after the mode changes");
+
+  // the status packets of a list which changed after the instruction packet are dropped
+  check(groupSyncRead.txPacket() == COMM_SUCCESS, "sync read before the list changes");
+  groupSyncRead.removeParam(1);
+  check(groupSyncRead.rxPacket() == COMM_NOT_AVAILABLE, "sync read after the list changes");
+  check(groupSyncRead.getResult(2) == COMM_NOT_AVAILABLE, "result of a list which changed");
+  check(groupSyncRead.txRxPacket() == COMM_SUCCESS, "sync read of the changed list");
+  check(groupSyncRead.getData(2, ADDR_PRESENT_POSITION, 4) == getGoal(99, 2), "sync read data of the changed list");
+
+  delete port;
+}
+
+static void testBulkRead(bool is_fast_read)
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  PortHandlerEmulator *port = openBus(PortHandlerEmulator::CLOCK_VIRTUAL, 3);
+
+  GroupBulkWrite groupBulkWrite(port, packetHandler);
+  GroupBulkRead groupBulkRead(port, packetHandler);
+  groupBulkRead.setFastRead(is_fast_read);
+
+  // each Mercury is read at another address and length
+  groupBulkRead.addParam(1, ADDR_PRESENT_POSITION, 4);
+  groupBulkRead.addParam(2, ADDR_GOAL_POSITION, 4);
+  groupBulkRead.addParam(3, ServoEmulator::ADDR_MODEL_NUMBER, 2);
+
+  uint8_t data[4];
+  bool is_read = true;
+  for (int cycle = 0; cycle < 100; cycle++)
+  {
+    for (uint8_t id = 1; id <= 2; id++)
+    {
+      setGoal(data, getGoal(cycle, id));
+      if (cycle == 0)
+        groupBulkWrite.addParam(id, ADDR_GOAL_POSITION, 4, data);
+      else
+        groupBulkWrite.changeParam(id, ADDR_GOAL_POSITION, 4, data);
+    }
+    check(groupBulkWrite.txPacket() == COMM_SUCCESS, "bulk write");
+    check(groupBulkRead.txRxPacket() == COMM_SUCCESS, "bulk read");
+
+    if (groupBulkRead.getData(1, ADDR_PRESENT_POSITION, 4) != getGoal(cycle, 1) ||
+        groupBulkRead.getData(2, ADDR_GOAL_POSITION, 4) != getGoal(cycle, 2) ||
+        groupBulkRead.getData(3, ServoEmulator::ADDR_MODEL_NUMBER, 2) != ServoEmulator::DEFAULT_MODEL_NUMBER_)
+      is_read = false;
+  }
+  check(is_read, "bulk read data");
+
+  groupBulkRead.addParam(9, ADDR_PRESENT_POSITION, 4);
+  check(groupBulkRead.txRxPacket() != COMM_SUCCESS, "bulk read with a missing Mercury");
+  check(groupBulkRead.isAvailable(9, ADDR_PRESENT_POSITION, 4) == false, "data of the missing Mercury");
+  if (is_fast_read == false)
+  {
+    check(groupBulkRead.getResult(9) == COMM_RX_TIMEOUT, "timeout of the missing Mercury");
+    check(groupBulkRead.getResult(3) == COMM_SUCCESS, "result of the Mercury before the missing one");
+  }
+
+  groupBulkRead.removeParam(9);
+  check(groupBulkRead.txRxPacket() == COMM_SUCCESS, "bulk read after the missing Mercury is removed");
+
+  check(groupBulkRead.txPacket() == COMM_SUCCESS, "bulk read before the mode changes");
+  groupBulkRead.setFastRead(!is_fast_read);
+  check(groupBulkRead.rxPacket() == COMM_SUCCESS, "bulk read after the mode changes");
+
+  check(groupBulkRead.txPacket() == COMM_SUCCESS, "bulk read before the list changes");
+  groupBulkRead.removeParam(1);
+  check(groupBulkRead.rxPacket() == COMM_NOT_AVAILABLE, "bulk read after the list changes");
+  check(groupBulkRead.getResult(2) == COMM_NOT_AVAILABLE, "result of a list which changed");
+  check(groupBulkRead.txRxPacket() == COMM_SUCCESS, "bulk read of the changed list");
+  check(groupBulkRead.getData(2, ADDR_GOAL_POSITION, 4) == getGoal(99, 2), "bulk read data of the changed list");
+
+  delete port;
+}
+
+// Writes goals to one Mercury through the engine and reads them back, from a thread of its own
+static void runAsync(AsyncPacketHandler *async_ph, uint8_t id, int *failures)
+{
+  AsyncRequest request;
+  uint8_t data[4];
+
+  for (int cycle = 0; cycle < 200; cycle++)
+  {
+    setGoal(data, getGoal(cycle, id));
+    if (async_ph->writeAsync(&request, id, ADDR_GOAL_POSITION, 4, data) != COMM_SUCCESS || request.wait() != COMM_SUCCESS)
+      (*failures)++;
+    if (async_ph->readAsync(&request, id, ADDR_PRESENT_POSITION, 4) != COMM_SUCCESS || request.wait() != COMM_SUCCESS ||
+        request.getValue() != getGoal(cycle, id))
+      (*failures)++;
+  }
+}
+
+// Pings until the engine refuses, every request it accepted has to be done, run or not
+static void runUntilStopped(AsyncPacketHandler *async_ph, int *accepted, int *failures)
+{
+  AsyncRequest request;
+
+  while (async_ph->pingAsync(&request, 1) == COMM_SUCCESS)
+  {
+    (*accepted)++;
+    int result = request.wait();
+    if (result != COMM_SUCCESS && result != COMM_NOT_AVAILABLE)
+      (*failures)++;
+  }
+}
+
+static void testAsync()
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  PortHandlerEmulator *port = openBus(PortHandlerEmulator::CLOCK_VIRTUAL, ASYNC_THREAD_COUNT);
+  PortIoEngine engine(port, packetHandler);
+  AsyncPacketHandler asyncPacketHandler(&engine);
+  engine.start();
+
+  std::vector<std::thread> threads;
+  int failures[ASYNC_THREAD_COUNT] = { 0 };
+  int accepted[ASYNC_THREAD_COUNT] = { 0 };
+
+  for (int t = 0; t < ASYNC_THREAD_COUNT; t++)
+    threads.push_back(std::thread(runAsync, &asyncPacketHandler, (uint8_t)(t + 1), &failures[t]));
+  for (int t = 0; t < ASYNC_THREAD_COUNT; t++)
+  {
+    threads[t].join();
+    check(failures[t] == 0, "async transactions from several threads");
+  }
+  threads.clear();
+
+  AsyncRequest request;
+  check(asyncPacketHandler.pingAsync(&request, 9) == COMM_SUCCESS && request.wait() == COMM_RX_TIMEOUT, "async ping of a missing Mercury");
+
+  // the engine stops while the threads keep submitting, which must leave no request waiting forever
+  for (int t = 0; t < ASYNC_THREAD_COUNT; t++)
+  {
+    failures[t] = 0;
+    threads.push_back(std::thread(runUntilStopped, &asyncPacketHandler, &accepted[t], &failures[t]));
+  }
+  usleep(5000);
+  engine.stop();
+  for (int t = 0; t < ASYNC_THREAD_COUNT; t++)
+  {
+    threads[t].join();
+    check(accepted[t] > 0 && failures[t] == 0, "async requests while the engine stops");
+  }
+  check(asyncPacketHandler.pingAsync(&request, 1) == COMM_NOT_AVAILABLE, "async request after the engine stopped");
+
+  delete port;
+}
+
+// Fills a block of the free area of the control table with a pattern of the cycle and the ID
+static void setBlock(uint8_t *data, int cycle, uint8_t id)
+{
+  for (int s = 0; s < SHARED_LENGTH; s++)
+    data[s] = (uint8_t)(cycle * 7 + id * 31 + s);
+}
+
+// Writes blocks to one Mercury through the engine and reads them back, the port is taken in turns with testSharedPort()
+static void runShared(AsyncPacketHandler *async_ph, uint8_t id, int *failures)
+{
+  AsyncRequest request;
+  uint8_t data[SHARED_LENGTH];
+  uint8_t read[SHARED_LENGTH];
+
+  for (int cycle = 0; cycle < 2000; cycle++)
+  {
+    int result;
+    setBlock(data, cycle, id);
+    while ((result = async_ph->writeAsync(&request, id, ADDR_SHARED, SHARED_LENGTH, data)) == COMM_SUCCESS &&
+           (result = request.wait()) == COMM_PORT_BUSY)
+      std::this_thread::yield();
+    if (result != COMM_SUCCESS)
+      (*failures)++;
+    while ((result = async_ph->readAsync(&request, id, ADDR_SHARED, SHARED_LENGTH, read)) == COMM_SUCCESS &&
+           (result = request.wait()) == COMM_PORT_BUSY)
+      std::this_thread::yield();
+    if (result != COMM_SUCCESS || memcmp(read, data, SHARED_LENGTH) != 0)
+      (*failures)++;
+  }
+}
+
+// Blocking calls on a port the engine runs, each one either has the port to itself or gets COMM_PORT_BUSY
+static void testSharedPort()
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  PortHandlerEmulator *port = openBus(PortHandlerEmulator::CLOCK_VIRTUAL, 2);
+  PortIoEngine engine(port, packetHandler);
+  AsyncPacketHandler asyncPacketHandler(&engine);
+  engine.start();
+
+  int async_failures = 0;
+  int failures = 0;
+  uint8_t data[SHARED_LENGTH];
+  uint8_t read[SHARED_LENGTH];
+  std::thread thread(runShared, &asyncPacketHandler, (uint8_t)1, &async_failures);
+
+  for (int cycle = 0; cycle < 2000; cycle++)
+  {
+    int result;
+    setBlock(data, cycle, 2);
+    while ((result = packetHandler->writeTxRx(port, 2, ADDR_SHARED, SHARED_LENGTH, data)) == COMM_PORT_BUSY)
+      std::this_thread::yield();
+    if (result != COMM_SUCCESS)
+      failures++;
+    while ((result = packetHandler->readTxRx(port, 2, ADDR_SHARED, SHARED_LENGTH, read)) == COMM_PORT_BUSY)
+      std::this_thread::yield();
+    if (result != COMM_SUCCESS || memcmp(read, data, SHARED_LENGTH) != 0)
+      failures++;
+  }
+
+  thread.join();
+  check(failures == 0, "blocking calls on a port the engine runs");
+  check(async_failures == 0, "engine transactions beside blocking calls");
+
+  engine.stop();
+  delete port;
+}
+
+// Three ports with four Mercurys each, cycled by one BusManager, which owns the ports
+static void testBusManager()
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  BusManager busManager(packetHandler, ADDR_PRESENT_POSITION, 4, ADDR_GOAL_POSITION, 4);
+
+  PortHandlerEmulator *port[3];
+  for (int bus = 0; bus < 3; bus++)
+  {
+    port[bus] = new PortHandlerEmulator("emulator");
+    for (uint8_t id = 1; id <= 4; id++)
+      port[bus]->getBus()->addServo(bus * 4 + id)->getControlTable()[ServoEmulator::ADDR_CONTROL_ENABLE] = 1;
+    port[bus]->openPort();
+    busManager.addPort(port[bus]);
+  }
+
+  check(busManager.scan() == COMM_SUCCESS, "bus manager scan");
+  bool is_found = true;
+  for (uint8_t id = 1; id <= 12; id++)
+  {
+    if (busManager.getBus(id) != (id - 1) / 4)
+      is_found = false;
+  }
+  check(is_found, "bus of each Mercury");
+
+  uint8_t data[4];
+  bool is_read = true;
+  for (int cycle = 0; cycle < 100; cycle++)
+  {
+    for (uint8_t id = 1; id <= 12; id++)
+    {
+      setGoal(data, getGoal(cycle, id));
+      busManager.setData(id, data);
+    }
+    check(busManager.writeReadAll() == COMM_SUCCESS, "bus manager cycle");
+
+    for (uint8_t id = 1; id <= 12; id++)
+    {
+      if (busManager.getData(id, ADDR_PRESENT_POSITION, 4) != getGoal(cycle, id))
+        is_read = false;
+    }
+  }
+  check(is_read, "bus manager data");
+
+  // a Mercury lost from its bus fails only its own bus
+  port[1]->getBus()->removeServo(6);
+  check(busManager.writeReadAll() != COMM_SUCCESS, "bus manager cycle with a missing Mercury");
+  check(busManager.getBusResult(0) == COMM_SUCCESS && busManager.getBusResult(2) == COMM_SUCCESS, "buses without the missing Mercury");
+  check(busManager.getResult(6) != COMM_SUCCESS, "result of the missing Mercury");
+}
+
+// The transactions which are recorded and replayed, with their results and data appended to the log
+static void runLogged(PortHandler *port, std::vector<uint32_t> *log)
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  GroupSyncRead groupSyncRead(port, packetHandler, ADDR_PRESENT_POSITION, 4);
+  groupSyncRead.addParam(1);
+  groupSyncRead.addParam(2);
+
+  for (int cycle = 0; cycle < 20; cycle++)
+  {
+    uint8_t error = 0;
+    log->push_back(packetHandler->write4ByteTxRx(port, 1, ADDR_GOAL_POSITION, getGoal(cycle, 1), &error));
+    groupSyncRead.setFastRead(cycle % 2 == 1);
+    log->push_back(groupSyncRead.txRxPacket());
+    log->push_back(groupSyncRead.getData(1, ADDR_PRESENT_POSITION, 4));
+    log->push_back(packetHandler->ping(port, 9, &error));
+  }
+}
+
+static Task<> runLoggedCoroutine(CoPacketHandler *co_ph, PortHandler *port, std::vector<uint32_t> *log)
+{
+  for (int cycle = 0; cycle < 20; cycle++)
+  {
+    uint32_t position = 0;
+    log->push_back(co_await co_ph->write4ByteTxRx(port, 2, ADDR_GOAL_POSITION, getGoal(cycle, 2)));
+    log->push_back(co_await co_ph->read4ByteTxRx(port, 2, ADDR_PRESENT_POSITION, &position));
+    log->push_back(position);
+    log->push_back(co_await co_ph->ping(port, 9));
+  }
+}
+
+// Records the emulated bus with the TrafficRecorder and answers the same transactions from the capture
+static void testReplay()
+{
+  PacketHandler *packetHandler = PacketHandler::getPacketHandler();
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/emulator_test_%d.capture", (int)getpid());
+
+  TrafficRecorder recorder;
+  check(recorder.open(path, 1 << 20), "recorder open");
+
+  // channel 0 holds blocking transactions, channel 1 coroutines
+  std::vector<uint32_t> recorded[2];
+  PortHandlerEmulator *port = openBus(PortHandlerEmulator::CLOCK_VIRTUAL, 2);
+  port->setRecorder(&recorder, 0);
+  runLogged(port, &recorded[0]);
+  {
+    EventLoop loop;
+    CoPacketHandler coPacketHandler(&loop, packetHandler);
+    port->setRecorder(&recorder, 1);
+    runLoggedCoroutine(&coPacketHandler, port, &recorded[1]).spawn();
+    loop.run();
+  }
+  delete port;
+
+  // channel 2 holds a status packet with a wrong CRC, and one which is read in two chunks
+  uint8_t ping[10] = { 0xFF, 0xFF, 0xFD, 0x00, 1, 3, 0, INST_PING, 0, 0 };
+  uint8_t status[14] = { 0xFF, 0xFF, 0xFD, 0x00, 1, 7, 0, INST_STATUS, 0, 0x30, 0x04, 0x26, 0, 0 };
+  uint16_t crc = Crc16::update(0, ping, 8);
+  ping[8] = MCY_LOBYTE(crc);
+  ping[9] = MCY_HIBYTE(crc);
+  crc = Crc16::update(0, status, 12);
+  status[12] = MCY_LOBYTE(crc) ^ 0x01;
+  status[13] = MCY_HIBYTE(crc);
+  recorder.record(TrafficRecorder::DIRECTION_TX, 2, 0, ping, sizeof(ping));
+  recorder.record(TrafficRecorder::DIRECTION_RX, 2, 200000, status, sizeof(status));
+  status[12] = MCY_LOBYTE(crc);
+  recorder.record(TrafficRecorder::DIRECTION_TX, 2, 1000000, ping, sizeof(ping));
+  recorder.record(TrafficRecorder::DIRECTION_RX, 2, 1200000, status, 6);
+  recorder.record(TrafficRecorder::DIRECTION_RX, 2, 1300000, status + 6, sizeof(status) - 6);
+  recorder.close();
+
+  for (int mode = PortHandlerReplay::REPLAY_TIMED; mode <= PortHandlerReplay::REPLAY_FAST; mode++)
+  {
+    PortHandlerReplay replay("replay", (PortHandlerReplay::ReplayMode)mode);
+    check(replay.loadCapture(path, 0), "capture load");
+    replay.openPort();
+
+    std::vector<uint32_t> replayed;
+    runLogged(&replay, &replayed);
+    check(replayed == recorded[0], "replayed results and data");
+    check(replay.getMismatchCount() == 0 && replay.getSkippedCount() == 0, "replayed writes match the capture");
+    check(replay.getPosition() == replay.getExchangeCount(), "replay reaches the end of the capture");
+
+    // a write which isn't in the capture is left unanswered
+    replay.rewind();
+    check(packetHandler->ping(&replay, 3) == COMM_RX_TIMEOUT, "replay of a write missing from the capture");
+    check(replay.getMismatchCount() == 1, "mismatch count");
+  }
+
+  {
+    PortHandlerReplay replay("replay", PortHandlerReplay::REPLAY_FAST);
+    check(replay.loadCapture(path, 1), "capture load");
+    replay.openPort();
+
+    EventLoop loop;
+    CoPacketHandler coPacketHandler(&loop, packetHandler);
+    std::vector<uint32_t> replayed;
+    runLoggedCoroutine(&coPacketHandler, &replay, &replayed).spawn();
+    loop.run();
+    check(replayed == recorded[1], "replayed coroutine results and data");
+  }
+
+  {
+    PortHandlerReplay replay("replay");
+    check(replay.loadCapture(path, 2), "capture load");
+    replay.openPort();
+
+    uint16_t model_number = 0;
+    check(packetHandler->ping(&replay, 1, &model_number) == COMM_RX_CORRUPT, "replay of a corrupt status packet");
+    check(packetHandler->ping(&replay, 1, &model_number) == COMM_SUCCESS && model_number == 0x0430, "replay of a split status packet");
+  }
+
+  unlink(path);
+}
+
+int main()
+{
+  alarm(TEST_TIMEOUT);
+
+  testCoroutines(PortHandlerEmulator::CLOCK_REAL);
+  testCoroutines(PortHandlerEmulator::CLOCK_VIRTUAL);
+  testSyncRead(false);
+  testSyncRead(true);
+  testBulkRead(false);
+  testBulkRead(true);
+  testAsync();
+  testSharedPort();
+  testBusManager();
+  testReplay();
+
+  printf("%d checks, %d failed\n", check_count, failure_count);
+  return (failure_count == 0) ? 0 : 1;
+}
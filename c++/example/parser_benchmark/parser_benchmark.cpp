@@ -0,0 +1,204 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+//
+// *********     Parser Benchmark Example      *********
+//
+// This example measures the throughput of StatusPacketParser on a stream of status packets, as it comes from a port.
+// Between the packets lie runs of noise, every fourth packet carries data which needs byte stuffing
+// and every sixteenth one has a wrong CRC. The stream is fed in chunks of several sizes, down to a byte at a time.
+// Every packet is first checked against the one which was sent, so the example also fails when the parser is wrong.
+//
+// Usage : ./parser_benchmark [MB]
+//   MB  bytes of stream to parse for each chunk size, in megabytes (default: 16)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "mercury_sdk.h"                                   // Uses Mercury SDK library
+
+using namespace mercury;
+
+#define PACKET_COUNT            256
+#define MAX_DATA_LENGTH         64
+#define MAX_NOISE_LENGTH        8
+#define CHUNK_SIZE_COUNT        5
+
+static const int chunk_size[CHUNK_SIZE_COUNT] = { 1, 8, 64, 512, 1 << 30 };
+
+struct SentPacket
+{
+  uint8_t  id;
+  uint8_t  data[MAX_DATA_LENGTH];
+  uint16_t data_length;
+  bool     is_corrupt;
+};
+
+static std::vector<SentPacket> sent;
+static std::vector<uint8_t> stream;
+
+// Appends a status packet with the data, stuffed and framed as a Mercury sends it
+static void appendPacket(const SentPacket &packet)
+{
+  uint8_t body[1 + MAX_DATA_LENGTH];
+  body[0] = 0x00;   // error
+  memcpy(body + 1, packet.data, packet.data_length);
+
+  size_t start = stream.size();
+  uint8_t head[8] = { 0xFF, 0xFF, 0xFD, 0x00, packet.id, 0, 0, INST_STATUS };
+  stream.insert(stream.end(), head, head + 8);
+
+  // the stuffing sees the instruction before the data, as on the wire
+  uint8_t stuffed[2 + (1 + MAX_DATA_LENGTH) * 4 / 3 + 2];
+  uint8_t unstuffed[2 + 1 + MAX_DATA_LENGTH];
+  unstuffed[0] = packet.id;
+  unstuffed[1] = INST_STATUS;
+  memcpy(unstuffed + 2, body, 1 + packet.data_length);
+  uint32_t stuffed_length = ByteStuffing::stuff(unstuffed, 2 + 1 + packet.data_length, stuffed) - 2;
+  stream.insert(stream.end(), stuffed + 2, stuffed + 2 + stuffed_length);
+
+  uint16_t length = (uint16_t)(1 + stuffed_length + 2);   // INST, ERROR and data, CRC16_L CRC16_H
+  stream[start + 5] = MCY_LOBYTE(length);
+  stream[start + 6] = MCY_HIBYTE(length);
+
+  uint16_t crc = Crc16::update(0, &stream[start], (uint16_t)(stream.size() - start));
+  if (packet.is_corrupt)
+    crc ^= 0x0001;
+  stream.push_back(MCY_LOBYTE(crc));
+  stream.push_back(MCY_HIBYTE(crc));
+}
+
+static void makeStream()
+{
+  srand(1);
+  for (int p = 0; p < PACKET_COUNT; p++)
+  {
+    // noise never holds 0xFF, so it can't start a header
+    int noise_length = rand() % (MAX_NOISE_LENGTH + 1);
+    for (int n = 0; n < noise_length; n++)
+      stream.push_back((uint8_t)(rand() % 0xFF));
+
+    SentPacket packet;
+    packet.id          = (uint8_t)(1 + p % 252);
+    packet.data_length = (uint16_t)(1 + rand() % MAX_DATA_LENGTH);
+    packet.is_corrupt  = (p % 16 == 15);
+    for (int i = 0; i < packet.data_length; i++)
+      packet.data[i] = (p % 4 == 0) ? ((i % 3 == 2) ? 0xFD : 0xFF) : (uint8_t)rand();
+
+    appendPacket(packet);
+    sent.push_back(packet);
+  }
+}
+
+// Feeds the stream in chunks, returns the number of packets and of CRC errors, and checks them when check is set
+static bool parseStream(StatusPacketParser *parser, int chunk, bool check, int *packet_count, int *crc_error_count)
+{
+  int length = (int)stream.size();
+  int p = 0;
+
+  for (int offset = 0; offset < length; offset += chunk)
+  {
+    const uint8_t *data = &stream[offset];
+    int remaining = (chunk < length - offset) ? chunk : length - offset;
+
+    while (remaining > 0)
+    {
+      int consumed = 0;
+      int result = parser->parse(data, remaining, &consumed);
+      data      += consumed;
+      remaining -= consumed;
+
+      if (result == StatusPacketParser::PARSE_INCOMPLETE)
+        continue;
+
+      // the CRC error of a packet is only found at its end, so it is counted like a packet
+      if (check)
+      {
+        const SentPacket &packet = sent[p];
+        if ((result == StatusPacketParser::PARSE_CRC_ERROR) != packet.is_corrupt || parser->getId() != packet.id)
+          return false;
+        if (packet.is_corrupt == false &&
+            (parser->getParameterLength() != packet.data_length || memcmp(parser->getParameter(), packet.data, packet.data_length) != 0))
+          return false;
+      }
+      p++;
+      if (result == StatusPacketParser::PARSE_PACKET)
+        (*packet_count)++;
+      else
+        (*crc_error_count)++;
+    }
+  }
+
+  return (check == false || p == PACKET_COUNT);
+}
+
+int main(int argc, char *argv[])
+{
+  uint64_t total_bytes = 16 * 1024 * 1024;
+  if (argc > 1)
+    total_bytes = (uint64_t)atoi(argv[1]) * 1024 * 1024;
+
+  makeStream();
+
+  uint8_t packet[PortHandler::RX_PACKET_LENGTH_];
+  StatusPacketParser parser(packet, sizeof(packet));
+
+  for (int c = 0; c < CHUNK_SIZE_COUNT; c++)
+  {
+    int packet_count = 0;
+    int crc_error_count = 0;
+
+    parser.reset();
+    if (parseStream(&parser, chunk_size[c], true, &packet_count, &crc_error_count) == false)
+    {
+      printf("The parser gives a wrong packet with chunks of %d bytes\n", chunk_size[c]);
+      return 1;
+    }
+  }
+
+  printf("%d status packets in %d bytes, of which %d bytes are noise\n",
+         PACKET_COUNT, (int)stream.size(), (int)parser.getSkippedLength());
+  printf("%10s %10s %10s %10s\n", "chunk", "MB/s", "ns/packet", "ns/chunk");
+
+  uint64_t repeat = total_bytes / stream.size() + 1;
+  for (int c = 0; c < CHUNK_SIZE_COUNT; c++)
+  {
+    int packet_count = 0;
+    int crc_error_count = 0;
+
+    int64_t start = MonotonicClock::getTime();
+    for (uint64_t r = 0; r < repeat; r++)
+      parseStream(&parser, chunk_size[c], false, &packet_count, &crc_error_count);
+    int64_t time = MonotonicClock::getTime() - start;
+
+    uint64_t bytes = repeat * stream.size();
+    uint64_t chunks = repeat * ((stream.size() + chunk_size[c] - 1) / chunk_size[c]);
+    if (packet_count + crc_error_count != (int)(repeat * PACKET_COUNT))
+      printf("Lost packets with chunks of %d bytes\n", chunk_size[c]);
+
+    if (chunk_size[c] >= (int)stream.size())
+      printf("%10s", "all");
+    else
+      printf("%10d", chunk_size[c]);
+    printf(" %10.0f %10.1f %10.1f\n", (double)bytes * 1000.0 / (double)time, (double)time / (double)(repeat * PACKET_COUNT),
+           (double)time / (double)chunks);
+  }
+
+  return 0;
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+//
+// *********     virtual_bus Tool      *********
+//
+// This tool emulates Mercurys on a pseudo terminal, so that the examples and applications
+// can be run through the unmodified Linux port handler without hardware.
+//
+// Usage : ./virtual_bus [-t] [ID ...]
+//   -t  send the status packets at the time of a real bus (baudrate and return delay)
+//   ID  Mercury IDs on the bus (default: 1)
+//
+// The tool prints the path of the port, e.g. /dev/pts/3, to be used as DEVICENAME.
+//
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mercury_sdk.h"                                   // Uses Mercury SDK library
+
+int main(int argc, char *argv[])
+{
+  mercury::VirtualBus virtualBus;
+  int servo_count = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-t") == 0)
+    {
+      virtualBus.setTiming(true);
+    }
+    else if (virtualBus.getBus()->addServo((uint8_t)atoi(argv[i])) != 0)
+    {
+      servo_count++;
+    }
+    else
+    {
+      printf("Invalid or repeated Mercury ID : %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (servo_count == 0)
+  {
+    virtualBus.getBus()->addServo(1);
+    servo_count = 1;
+  }
+
+  // Block the signals which end the tool, so that the bus thread doesn't take them
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  if (virtualBus.open() == false || virtualBus.start() == false)
+  {
+    printf("Failed to open a pseudo terminal!\n");
+    return 1;
+  }
+
+  printf("%s\n", virtualBus.getPortName());
+  printf("Virtual bus with %d Mercury on %s, press Ctrl-C to quit!\n", servo_count, virtualBus.getPortName());
+  fflush(stdout);
+
+  int signal_number;
+  sigwait(&signals, &signal_number);
+
+  virtualBus.close();
+  printf("%u instruction packets executed\n", virtualBus.getPacketCount());
+
+  return 0;
+}
@@ -0,0 +1,228 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_ASYNCPACKETHANDLER_H_
+#define INCLUDE_MERCURY_SDK_ASYNCPACKETHANDLER_H_
+
+#include "port_io_engine.h"
+#include "group_sync_read.h"
+#include "group_sync_write.h"
+
+namespace mercury
+{
+
+class AsyncPacketHandler;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for one asynchronous transaction of AsyncPacketHandler and the future of its result
+/// @description The request is owned by the caller and can be used again once it is done, so asynchronous calls allocate nothing.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC AsyncRequest : public IoTransaction
+{
+  friend class AsyncPacketHandler;
+
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The type of the function which is called on the I/O thread when a request is done
+  /// @description The request can't be submitted again before the callback returns.
+  /// @description A request which the engine stopped before running is done on the submitting thread instead.
+  ////////////////////////////////////////////////////////////////////////////////
+  typedef void (*Callback)(AsyncRequest *request, void *user_data);
+
+ private:
+  enum Kind
+  {
+    KIND_READ,
+    KIND_WRITE,
+    KIND_PING,
+    KIND_SYNC_READ,
+    KIND_SYNC_WRITE
+  };
+
+  AsyncPacketHandler *handler_;
+  std::atomic<bool>   is_done_;
+  Callback  callback_;
+  void     *user_data_;
+
+  Kind      kind_;
+  uint8_t   id_;
+  uint16_t  address_;
+  uint16_t  length_;
+  uint8_t  *data_;
+  uint8_t   value_[4];                  // data of a 1, 2 or 4 byte access which has no buffer of the caller
+  uint8_t   error_;
+  uint16_t  model_number_;
+  GroupSyncRead  *sync_read_;
+  GroupSyncWrite *sync_write_;
+
+ public:
+  AsyncRequest();
+
+  int     execute(PortHandler *port, PacketHandler *ph);
+  void    onComplete();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether the request is done, without waiting
+  /// @description A request which has never been submitted is done.
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isDone() { return is_done_.load(std::memory_order_acquire); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that waits until the request is done
+  /// @param msec Longest time to wait in milliseconds, a negative value waits until the request is done
+  /// @return COMM_RX_WAITING
+  /// @return   when the time ran out
+  /// @return or the communication result of the request
+  ////////////////////////////////////////////////////////////////////////////////
+  int     wait(double msec = -1);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the error byte of the status packet of a read, write or ping
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t getError() { return error_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the value of a 1, 2 or 4 byte read, or the model number of a ping
+  ////////////////////////////////////////////////////////////////////////////////
+  uint32_t getValue();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that submits PacketHandler transactions to the I/O thread of a PortIoEngine and returns at once
+/// @description The result is collected later with AsyncRequest::wait(), or handed to a callback on the I/O thread,
+/// @description so the application can compute while the instruction and status packets travel on the bus.
+/// @description A request submitted while PortIoEngine::stop() runs is done with COMM_NOT_AVAILABLE, so no wait is left hanging.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC AsyncPacketHandler
+{
+  friend class AsyncRequest;
+
+ private:
+  PortIoEngine *engine_;
+
+  // requests are waited for on one condition, which the I/O thread only signals while someone waits
+  std::mutex              mutex_;
+  std::condition_variable condition_;
+  std::atomic<int>        waiting_count_;
+
+  int     claim(AsyncRequest *request);
+  void    submit(AsyncRequest *request, AsyncRequest::Callback callback, void *user_data);
+  int     wait(AsyncRequest *request, double msec);
+  void    notify();
+
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the handler for an engine
+  /// @param engine PortIoEngine which runs the requests, started with PortIoEngine::start()
+  ////////////////////////////////////////////////////////////////////////////////
+  AsyncPacketHandler(PortIoEngine *engine);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts reading data from a Dynamixel
+  /// @description The function submits PacketHandler::readTxRx() to the I/O thread.
+  /// @param request Request which is done
+  /// @param id Dynamixel ID
+  /// @param address Address of the data for read
+  /// @param length Length of the data for read
+  /// @param data Buffer for the data, which has to stay valid until the request is done, or NULL for a 1, 2 or 4 byte read collected with AsyncRequest::getValue()
+  /// @param callback Function called on the I/O thread when the request is done, or NULL
+  /// @param user_data Argument of the callback
+  /// @return COMM_PORT_BUSY
+  /// @return   when the request isn't done yet
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the engine isn't running
+  /// @return COMM_TX_ERROR
+  /// @return   when there is no buffer for a read of more than 4 bytes
+  /// @return or COMM_SUCCESS
+  ////////////////////////////////////////////////////////////////////////////////
+  int     readAsync     (AsyncRequest *request, uint8_t id, uint16_t address, uint16_t length, uint8_t *data = 0,
+                         AsyncRequest::Callback callback = 0, void *user_data = 0);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts writing data to a Dynamixel
+  /// @description The function submits PacketHandler::writeTxRx() to the I/O thread.
+  /// @description Data of up to 4 bytes is copied into the request, longer data has to stay valid until the request is done.
+  /// @param request Request which is done
+  /// @param id Dynamixel ID
+  /// @param address Address of the data for write
+  /// @param length Length of the data for write
+  /// @param data Data for write
+  /// @param callback Function called on the I/O thread when the request is done, or NULL
+  /// @param user_data Argument of the callback
+  /// @return COMM_PORT_BUSY
+  /// @return   when the request isn't done yet
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the engine isn't running
+  /// @return or COMM_SUCCESS
+  ////////////////////////////////////////////////////////////////////////////////
+  int     writeAsync    (AsyncRequest *request, uint8_t id, uint16_t address, uint16_t length, uint8_t *data,
+                         AsyncRequest::Callback callback = 0, void *user_data = 0);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts pinging a Dynamixel
+  /// @description The function submits PacketHandler::ping() to the I/O thread, the model number is collected with AsyncRequest::getValue().
+  /// @param request Request which is done
+  /// @param id Dynamixel ID
+  /// @param callback Function called on the I/O thread when the request is done, or NULL
+  /// @param user_data Argument of the callback
+  /// @return COMM_PORT_BUSY
+  /// @return   when the request isn't done yet
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the engine isn't running
+  /// @return or COMM_SUCCESS
+  ////////////////////////////////////////////////////////////////////////////////
+  int     pingAsync     (AsyncRequest *request, uint8_t id,
+                         AsyncRequest::Callback callback = 0, void *user_data = 0);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts a Sync Read
+  /// @description The function submits GroupSyncRead::txRxPacket() to the I/O thread. The group has to be bound to the port of the engine
+  /// @description and left alone until the request is done, its data is then read with GroupSyncRead::getData() as usual.
+  /// @param request Request which is done
+  /// @param group Sync Read group
+  /// @param callback Function called on the I/O thread when the request is done, or NULL
+  /// @param user_data Argument of the callback
+  /// @return COMM_PORT_BUSY
+  /// @return   when the request isn't done yet
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the engine isn't running
+  /// @return or COMM_SUCCESS
+  ////////////////////////////////////////////////////////////////////////////////
+  int     syncReadAsync (AsyncRequest *request, GroupSyncRead *group,
+                         AsyncRequest::Callback callback = 0, void *user_data = 0);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts a Sync Write
+  /// @description The function submits GroupSyncWrite::txPacket() to the I/O thread. The group has to be bound to the port of the engine
+  /// @description and left alone until the request is done.
+  /// @param request Request which is done
+  /// @param group Sync Write group
+  /// @param callback Function called on the I/O thread when the request is done, or NULL
+  /// @param user_data Argument of the callback
+  /// @return COMM_PORT_BUSY
+  /// @return   when the request isn't done yet
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the engine isn't running
+  /// @return or COMM_SUCCESS
+  ////////////////////////////////////////////////////////////////////////////////
+  int     syncWriteAsync(AsyncRequest *request, GroupSyncWrite *group,
+                         AsyncRequest::Callback callback = 0, void *user_data = 0);
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_ASYNCPACKETHANDLER_H_ */
@@ -0,0 +1,150 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_BUSEMULATOR_H_
+#define INCLUDE_MERCURY_SDK_BUSEMULATOR_H_
+
+#include <vector>
+
+#include "servo_emulator.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for a Protocol 2.0 bus of emulated Mercurys
+/// @description The bus takes the bytes the host writes, executes every complete instruction packet on its servos
+/// @description and returns their status packets, each with the delay after which it starts on the bus.
+/// @description It supports ping, read, write, reg write, action, factory reset, reboot, clear, sync read / write,
+/// @description bulk read / write and fast sync / bulk read. It keeps no time itself, so the same bytes always give the same answers.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC BusEmulator
+{
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief A status packet sent by the bus
+  ////////////////////////////////////////////////////////////////////////////////
+  struct Response
+  {
+    uint32_t  offset;   ///< index of the first byte in BusEmulator::getResponseData()
+    uint32_t  length;   ///< number of bytes
+    double    delay;    ///< usec from the end of the previous bytes on the bus until the first byte
+  };
+
+  BusEmulator();
+  ~BusEmulator();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that connects a new Mercury to the bus
+  /// @param id Mercury ID
+  /// @param model_number Model number returned by a ping
+  /// @return the Mercury, owned by the bus
+  /// @return or 0 when a Mercury with the ID is already connected
+  ////////////////////////////////////////////////////////////////////////////////
+  ServoEmulator *addServo(uint8_t id, uint16_t model_number = ServoEmulator::DEFAULT_MODEL_NUMBER_);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that disconnects a Mercury from the bus and deletes it
+  /// @param id Mercury ID
+  ////////////////////////////////////////////////////////////////////////////////
+  void    removeServo(uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns a Mercury connected to the bus
+  /// @param id Mercury ID
+  /// @return the Mercury
+  /// @return or 0 when no Mercury has the ID
+  ////////////////////////////////////////////////////////////////////////////////
+  ServoEmulator *getServo(uint8_t id) { return servos_[id]; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets the baudrate the host transmits at
+  /// @description Mercurys set to another baudrate don't see the instruction packets.
+  /// @param baudrate Baudrate
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setBaudRate(int baudrate) { baudrate_ = baudrate; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the baudrate the host transmits at
+  /// @return Baudrate
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getBaudRate() { return baudrate_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that passes bytes written by the host to the bus
+  /// @description A packet may be split across calls. Bytes which are not part of a packet with a valid CRC are skipped.
+  /// @description The status packets are appended to the responses.
+  /// @param data Bytes written by the host
+  /// @param length Number of bytes
+  /// @return Number of instruction packets executed
+  ////////////////////////////////////////////////////////////////////////////////
+  int     receive(const uint8_t *data, int length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that discards the bytes of an incomplete instruction packet
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clearPort() { rx_data_.clear(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of status packets waiting to be taken
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getResponseCount() { return (int)responses_.size(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns a status packet waiting to be taken
+  /// @param index Index from 0 to BusEmulator::getResponseCount() - 1, in the order the packets are sent
+  ////////////////////////////////////////////////////////////////////////////////
+  const Response &getResponse(int index) { return responses_[index]; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the bytes of the status packets waiting to be taken
+  ////////////////////////////////////////////////////////////////////////////////
+  const uint8_t *getResponseData() { return tx_data_.data(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that discards the status packets once they were taken
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clearResponses();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of instruction packets which had a wrong CRC
+  ////////////////////////////////////////////////////////////////////////////////
+  uint32_t getCrcErrorCount() { return crc_error_count_; }
+
+ private:
+  void    execute(uint8_t id, uint8_t instruction, const uint8_t *param, uint16_t length);
+  void    executeSingle(ServoEmulator *servo, uint8_t instruction, const uint8_t *param, uint16_t length, bool is_broadcast);
+  void    executeFastRead(const uint8_t *param, uint16_t length, bool is_bulk);
+  bool    isListening(uint8_t id);
+  void    addStatus(uint8_t id, double delay, uint8_t error, const uint8_t *data, uint16_t length);
+  void    addPacket(uint8_t id, double delay, const uint8_t *body, uint32_t length, uint32_t sent_length);
+  void    updateIds();
+
+  ServoEmulator  *servos_[256];
+  int             baudrate_;
+  uint32_t        crc_error_count_;
+
+  std::vector<uint8_t>  rx_data_;     ///< bytes written by the host which are not executed yet
+  std::vector<uint8_t>  param_;       ///< unstuffed instruction and parameters of the packet being executed
+  std::vector<uint8_t>  body_;        ///< unstuffed body of the status packet being built
+  std::vector<uint8_t>  tx_data_;     ///< status packets waiting to be taken
+  std::vector<Response> responses_;
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_BUSEMULATOR_H_ */
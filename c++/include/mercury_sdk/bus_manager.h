@@ -0,0 +1,221 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_BUSMANAGER_H_
+#define INCLUDE_MERCURY_SDK_BUSMANAGER_H_
+
+#include <vector>
+
+#include "port_io_engine.h"
+#include "group_sync_read.h"
+#include "group_sync_write.h"
+
+#define BUS_MANAGER_NO_BUS      -1      // bus of an ID which is on no bus
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that drives several ports as one bus of servos
+/// @description Each servo ID lives on one of the ports. A cycle runs Sync Write and Sync Read on every port at the same time,
+/// @description each port on its own PortIoEngine, and returns when all of them are done.
+/// @description The cycle takes as long as the port with the most servos, and the data is read back by ID wherever the servo is.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC BusManager
+{
+ private:
+  enum Mode
+  {
+    MODE_READ,
+    MODE_WRITE,
+    MODE_WRITE_READ,
+    MODE_SCAN
+  };
+
+  class Bus;
+
+  class BusTransaction : public IoTransaction
+  {
+   public:
+    Bus  *bus_;
+    Mode  mode_;
+
+    int   execute(PortHandler *port, PacketHandler *ph);
+  };
+
+  class Bus
+  {
+   public:
+    PortHandler    *port_;
+    PortIoEngine   *engine_;
+    GroupSyncRead  *sync_read_;
+    GroupSyncWrite *sync_write_;
+    BusTransaction  transaction_;
+    int             servo_count_;     // IDs in the Sync Read list
+    int             write_count_;     // IDs in the Sync Write list
+    std::vector<uint8_t> scan_list_;    // IDs found by the last scan
+  };
+
+  PacketHandler *ph_;
+  uint16_t read_address_;
+  uint16_t read_length_;
+  uint16_t write_address_;
+  uint16_t write_length_;
+  bool     is_fast_read_;
+
+  std::vector<Bus *> buses_;
+  int      id_to_bus_[256];
+  bool     is_written_[256];            // whether the ID is in the Sync Write list of its bus
+  IoQueue  completion_queue_;
+
+  int     runCycle(Mode mode);
+
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the manager with the data which every cycle reads and writes
+  /// @param ph PacketHandler instance
+  /// @param read_address Address of the data for Sync Read
+  /// @param read_length Length of the data for Sync Read, 0 for no reading
+  /// @param write_address Address of the data for Sync Write
+  /// @param write_length Length of the data for Sync Write, 0 for no writing
+  ////////////////////////////////////////////////////////////////////////////////
+  BusManager(PacketHandler *ph, uint16_t read_address, uint16_t read_length, uint16_t write_address, uint16_t write_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that stops the I/O threads, and closes and deletes the ports
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual ~BusManager();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that adds an open port, which the manager owns from then on
+  /// @param port PortHandler instance from PortHandler::getPortHandler()
+  /// @return The index of the bus
+  ////////////////////////////////////////////////////////////////////////////////
+  int     addPort(PortHandler *port);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that finds the servos on every port at the same time with PacketHandler::broadcastPing()
+  /// @description Every ID found is added to the bus it answered on, unless it is on a bus already.
+  /// @return COMM_SUCCESS
+  /// @return   when every port could be scanned
+  /// @return or the communication result of the first port which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  int     scan();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that adds a servo on a given bus
+  /// @param id Mercury ID
+  /// @param bus Index of the bus
+  /// @return false
+  /// @return   when the ID is on a bus already or the bus doesn't exist
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    addServo(uint8_t id, int bus);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that removes a servo from its bus
+  /// @param id Mercury ID
+  ////////////////////////////////////////////////////////////////////////////////
+  void    removeServo(uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the bus of a servo
+  /// @return BUS_MANAGER_NO_BUS
+  /// @return   when the ID is on no bus
+  /// @return or the index of the bus
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getBus(uint8_t id) { return id_to_bus_[id]; }
+
+  int     getBusCount() { return (int)buses_.size(); }
+  PortHandler *getPortHandler(int bus) { return buses_[bus]->port_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that selects between Sync Read and Fast Sync Read on every bus
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setFastRead(bool enable);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets the data which the next cycle writes to a servo
+  /// @description A servo whose data has never been set is not written.
+  /// @param id Mercury ID
+  /// @param data Data for write, of the write length
+  /// @return false
+  /// @return   when the ID is on no bus or there is no writing
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    setData(uint8_t id, uint8_t *data);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that runs Sync Read on every bus at the same time
+  /// @return COMM_SUCCESS
+  /// @return   when every servo answered
+  /// @return or the communication result of the first bus which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  int     readAll();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that runs Sync Write on every bus at the same time
+  /// @return COMM_SUCCESS
+  /// @return   when every bus transmitted its packet
+  /// @return or the communication result of the first bus which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  int     writeAll();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that runs Sync Write and then Sync Read on every bus at the same time
+  /// @return COMM_SUCCESS
+  /// @return   when every bus transmitted its packet and every servo answered
+  /// @return or the communication result of the first bus which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  int     writeReadAll();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the communication result of a bus in the last cycle
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getBusResult(int bus) { return buses_[bus]->transaction_.getResult(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the communication result of a servo in the last read
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the ID is on no bus or there is no reading
+  /// @return or the result of GroupSyncRead::getResult()
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getResult(uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether there are available data of a servo from the last read
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isAvailable(uint8_t id, uint16_t address, uint16_t data_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that gets the data of a servo from the last read
+  /// @return data value, or 0 when the data isn't available
+  ////////////////////////////////////////////////////////////////////////////////
+  uint32_t getData(uint8_t id, uint16_t address, uint16_t data_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that gets the error byte of a servo from the last read
+  /// @return true
+  /// @return   when the servo returned a specific error byte
+  /// @return or false
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    getError(uint8_t id, uint8_t *error);
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_BUSMANAGER_H_ */
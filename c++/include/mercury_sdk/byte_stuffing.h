@@ -0,0 +1,77 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_BYTESTUFFING_H_
+#define INCLUDE_MERCURY_SDK_BYTESTUFFING_H_
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for the byte stuffing of Protocol 2.0 packets
+/// @description A packet which carries FF FF FD after its instruction gets an extra 0xFD after it,
+/// @description so that the bytes can't be taken for a header. The sequences are searched 16 bytes at a time
+/// @description with SSE2 on x86-64, and a byte at a time elsewhere.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC ByteStuffing
+{
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that finds the first FF FF FD in a block of bytes
+  /// @param data Bytes to search
+  /// @param length Number of bytes
+  /// @return Offset of the first FF FF FD which lies entirely in the block
+  /// @return or length when there is none
+  ////////////////////////////////////////////////////////////////////////////////
+  static uint32_t find(const uint8_t *data, uint32_t length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that counts the FF FF FD in a block of bytes
+  /// @param data Bytes to search
+  /// @param length Number of bytes
+  /// @return Number of bytes stuffing would add
+  ////////////////////////////////////////////////////////////////////////////////
+  static uint32_t count(const uint8_t *data, uint32_t length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that copies a block of bytes and adds the stuffing
+  /// @description Blocks of 16 bytes without FF FF FD are copied in one go.
+  /// @param data Bytes to copy
+  /// @param length Number of bytes
+  /// @param stuffed Buffer for length + length / 3 bytes at most, it must not overlap data
+  /// @return Number of bytes written in stuffed
+  ////////////////////////////////////////////////////////////////////////////////
+  static uint32_t stuff(const uint8_t *data, uint32_t length, uint8_t *stuffed);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that copies a block of received bytes and removes the stuffing
+  /// @description Each 0xFD which follows FF FF FD is left out. The bytes before begin are not copied,
+  /// @description they are only looked at as the FF FF FD before the first bytes copied.
+  /// @param data Bytes to copy
+  /// @param begin Offset of the first byte to copy
+  /// @param length Number of bytes in data
+  /// @param unstuffed Buffer for length - begin bytes at most, it must not overlap data
+  /// @return Number of bytes written in unstuffed
+  ////////////////////////////////////////////////////////////////////////////////
+  static uint32_t unstuff(const uint8_t *data, uint32_t begin, uint32_t length, uint8_t *unstuffed);
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_BYTESTUFFING_H_ */
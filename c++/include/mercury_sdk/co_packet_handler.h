@@ -0,0 +1,505 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_COPACKETHANDLER_H_
+#define INCLUDE_MERCURY_SDK_COPACKETHANDLER_H_
+
+#include "event_loop.h"
+#include "packet_handler.h"
+#include "group_sync_read.h"
+#include "group_sync_write.h"
+#include "transaction_metrics.h"
+
+// the coroutines are compiled into the application, so the library itself builds without C++20
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <exception>
+#include <new>
+#include <stddef.h>
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that keeps the frames of finished coroutines for the next ones of the same size class
+/// @description Every transaction is a coroutine, so once the frames of a cycle have been allocated, later cycles allocate nothing.
+////////////////////////////////////////////////////////////////////////////////
+class CoroutineFrameCache
+{
+ private:
+  static const size_t CLASS_SIZE  = 128;    // bytes
+  static const size_t CLASS_COUNT = 16;     // larger frames are not kept
+
+  struct Block
+  {
+    Block *next;
+  };
+
+  // the frames kept by one thread, given back when the thread exits
+  struct FreeLists
+  {
+    Block *lists[CLASS_COUNT] = { 0 };
+
+    ~FreeLists()
+    {
+      for (size_t index = 0; index < CLASS_COUNT; index++)
+      {
+        while (lists[index] != 0)
+        {
+          Block *block = lists[index];
+          lists[index] = block->next;
+          ::operator delete(block);
+        }
+      }
+    }
+  };
+
+  static Block **getFreeLists()
+  {
+    static thread_local FreeLists free_lists;
+    return free_lists.lists;
+  }
+
+ public:
+  static void *allocate(size_t size)
+  {
+    size_t index = (size - 1) / CLASS_SIZE;
+    if (index >= CLASS_COUNT)
+      return ::operator new(size);
+
+    Block **free_lists = getFreeLists();
+    Block *block = free_lists[index];
+    if (block == 0)
+      return ::operator new((index + 1) * CLASS_SIZE);
+
+    free_lists[index] = block->next;
+    return block;
+  }
+
+  static void release(void *frame, size_t size)
+  {
+    size_t index = (size - 1) / CLASS_SIZE;
+    if (index >= CLASS_COUNT)
+    {
+      ::operator delete(frame);
+      return;
+    }
+
+    Block **free_lists = getFreeLists();
+    Block *block = (Block *)frame;
+    block->next = free_lists[index];
+    free_lists[index] = block;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The part of the promise of Task which doesn't depend on the result type
+////////////////////////////////////////////////////////////////////////////////
+class TaskPromiseBase
+{
+ public:
+  std::coroutine_handle<> continuation_;    // coroutine which awaits the task
+  bool is_detached_;                        // whether the task frees itself when it finishes
+
+  TaskPromiseBase() : is_detached_(false) { }
+
+  // the task finishes by resuming the coroutine which awaits it
+  class FinalAwaiter
+  {
+   public:
+    bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+    {
+      TaskPromiseBase &promise = handle.promise();
+      std::coroutine_handle<> next = promise.continuation_ ? promise.continuation_ : std::noop_coroutine();
+      if (promise.is_detached_)
+        handle.destroy();
+      return next;
+    }
+
+    void await_resume() noexcept { }
+  };
+
+  std::suspend_always initial_suspend() noexcept { return std::suspend_always(); }
+  FinalAwaiter final_suspend() noexcept { return FinalAwaiter(); }
+  void unhandled_exception() noexcept { std::terminate(); }
+
+  static void *operator new(size_t size) { return CoroutineFrameCache::allocate(size); }
+  static void operator delete(void *frame, size_t size) { CoroutineFrameCache::release(frame, size); }
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase
+{
+ public:
+  T value_;
+
+  void return_value(T value) { value_ = value; }
+  T getResult() { return value_; }
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+ public:
+  void return_void() { }
+  void getResult() { }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for a coroutine which is started by co_await, or by Task::spawn() at the top
+/// @description The coroutine doesn't run until then. The task which awaits it is resumed with its result when it finishes.
+////////////////////////////////////////////////////////////////////////////////
+template <typename T = void>
+class Task
+{
+ public:
+  class promise_type : public TaskPromise<T>
+  {
+   public:
+    Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+  };
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) { }
+
+ public:
+  Task(Task &&other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  ~Task()
+  {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  bool await_ready() { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller)
+  {
+    handle_.promise().continuation_ = caller;
+    return handle_;
+  }
+
+  T await_resume() { return handle_.promise().getResult(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts the task on its own
+  /// @description The task runs at once until its first wait, EventLoop::run() drives the rest,
+  /// @description and its frame is freed when it finishes. The Task object is empty afterwards.
+  ////////////////////////////////////////////////////////////////////////////////
+  void spawn()
+  {
+    std::coroutine_handle<promise_type> handle = handle_;
+    handle_ = nullptr;
+    handle.promise().is_detached_ = true;
+    handle.resume();
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The awaitable which takes a port with EventLoop::lockPort()
+////////////////////////////////////////////////////////////////////////////////
+class PortLockAwaiter : public EventLoop::Waiter
+{
+ private:
+  EventLoop   *loop_;
+  PortHandler *port_;
+  std::coroutine_handle<> handle_;
+
+ public:
+  PortLockAwaiter(EventLoop *loop, PortHandler *port) : loop_(loop), port_(port) { }
+
+  bool await_ready() { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle)
+  {
+    handle_ = handle;
+    return loop_->lockPort(port_, this) == false;
+  }
+
+  void await_resume() { }
+  void resume() { handle_.resume(); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The awaitable which waits for bytes or the packet timeout with EventLoop::waitPort()
+////////////////////////////////////////////////////////////////////////////////
+class PortWaitAwaiter : public EventLoop::Waiter
+{
+ private:
+  EventLoop   *loop_;
+  PortHandler *port_;
+  std::coroutine_handle<> handle_;
+
+ public:
+  PortWaitAwaiter(EventLoop *loop, PortHandler *port) : loop_(loop), port_(port) { }
+
+  bool await_ready() { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle)
+  {
+    handle_ = handle;
+    return loop_->waitPort(port_, this);
+  }
+
+  void await_resume() { }
+  void resume() { handle_.resume(); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that gives a port taken with PortLockAwaiter back when it goes out of scope
+////////////////////////////////////////////////////////////////////////////////
+class PortLock
+{
+ private:
+  EventLoop   *loop_;
+  PortHandler *port_;
+
+ public:
+  PortLock(EventLoop *loop, PortHandler *port) : loop_(loop), port_(port) { }
+  ~PortLock() { loop_->unlockPort(port_); }
+
+  PortLock(const PortLock &) = delete;
+  PortLock &operator=(const PortLock &) = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for the transactions of PacketHandler as coroutines, driven by an EventLoop
+/// @description Each function returns a Task which is awaited, e.g. result = co_await co_ph.read4ByteTxRx(port, id, address, &data);
+/// @description While one transaction waits for its status packet, the loop runs the transactions of the other ports.
+/// @description Transactions on the same port take turns in the order they were started.
+/// @description The results are those of the blocking functions of PacketHandler with the same names.
+////////////////////////////////////////////////////////////////////////////////
+class CoPacketHandler
+{
+ private:
+  EventLoop     *loop_;
+  PacketHandler *ph_;
+
+  // receives the status packet of id into the packet buffer of the port, skipping packets of other IDs,
+  // and copies length bytes of its parameters to data before the port is released
+  Task<int> rxStatus(PortHandler *port, uint8_t id, uint8_t *error, uint8_t *data, uint16_t length)
+  {
+    int result;
+    port->setResponderId(id);
+
+    do
+    {
+      StatusPacketParser parser(port->getRxPacket(), PortHandler::RX_PACKET_LENGTH_);
+      while ((result = ph_->rxPacketNoWait(port, &parser)) == COMM_RX_WAITING)
+        co_await PortWaitAwaiter(loop_, port);
+
+      if (result == COMM_SUCCESS && parser.getId() == id)
+      {
+        if (error != 0)
+          *error = parser.getError();
+        for (uint16_t s = 0; s < length; s++)
+          data[s] = parser.getParameter()[s];
+        break;
+      }
+    } while (result == COMM_SUCCESS);
+
+    if (port->getMetrics() != 0)
+    {
+      port->getMetrics()->endStatus(id, result);
+      port->getMetrics()->endTransaction(result);
+    }
+    port->is_using_ = false;
+    co_return result;
+  }
+
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the handler
+  /// @param loop EventLoop which drives the transactions
+  /// @param ph PacketHandler instance
+  ////////////////////////////////////////////////////////////////////////////////
+  CoPacketHandler(EventLoop *loop, PacketHandler *ph) : loop_(loop), ph_(ph) { }
+
+  EventLoop     *getEventLoop()     { return loop_; }
+  PacketHandler *getPacketHandler() { return ph_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The coroutine that pings Mercury and takes its model number
+  /// @param port PortHandler instance
+  /// @param id Mercury ID
+  /// @param model_number Model number, or NULL
+  /// @param error Mercury hardware error, or NULL
+  /// @return communication results of PacketHandler::ping()
+  ////////////////////////////////////////////////////////////////////////////////
+  Task<int> ping(PortHandler *port, uint8_t id, uint16_t *model_number = 0, uint8_t *error = 0)
+  {
+    co_await PortLockAwaiter(loop_, port);
+    PortLock lock(loop_, port);
+
+    int result = ph_->pingTx(port, id);
+    if (result != COMM_SUCCESS)
+      co_return result;
+
+    uint8_t model[2] = {0};
+    result = co_await rxStatus(port, id, error, model, 2);
+    if (result == COMM_SUCCESS && model_number != 0)
+      *model_number = MCY_MAKEWORD(model[0], model[1]);
+
+    co_return result;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The coroutine that reads data from Mercury
+  /// @param port PortHandler instance
+  /// @param id Mercury ID
+  /// @param address Address of the data for read
+  /// @param length Length of the data for read
+  /// @param data Data extracted from the packet
+  /// @param error Mercury hardware error, or NULL
+  /// @return communication results of PacketHandler::readTxRx()
+  ////////////////////////////////////////////////////////////////////////////////
+  Task<int> readTxRx(PortHandler *port, uint8_t id, uint16_t address, uint16_t length, uint8_t *data, uint8_t *error = 0)
+  {
+    co_await PortLockAwaiter(loop_, port);
+    PortLock lock(loop_, port);
+
+    int result = ph_->readTx(port, id, address, length);
+    if (result != COMM_SUCCESS)
+      co_return result;
+
+    co_return co_await rxStatus(port, id, error, data, length);
+  }
+
+  Task<int> read1ByteTxRx(PortHandler *port, uint8_t id, uint16_t address, uint8_t *data, uint8_t *error = 0)
+  {
+    uint8_t data_read[1] = {0};
+    int result = co_await readTxRx(port, id, address, 1, data_read, error);
+    if (result == COMM_SUCCESS)
+      *data = data_read[0];
+    co_return result;
+  }
+
+  Task<int> read2ByteTxRx(PortHandler *port, uint8_t id, uint16_t address, uint16_t *data, uint8_t *error = 0)
+  {
+    uint8_t data_read[2] = {0};
+    int result = co_await readTxRx(port, id, address, 2, data_read, error);
+    if (result == COMM_SUCCESS)
+      *data = MCY_MAKEWORD(data_read[0], data_read[1]);
+    co_return result;
+  }
+
+  Task<int> read4ByteTxRx(PortHandler *port, uint8_t id, uint16_t address, uint32_t *data, uint8_t *error = 0)
+  {
+    uint8_t data_read[4] = {0};
+    int result = co_await readTxRx(port, id, address, 4, data_read, error);
+    if (result == COMM_SUCCESS)
+      *data = MCY_MAKEDWORD(MCY_MAKEWORD(data_read[0], data_read[1]), MCY_MAKEWORD(data_read[2], data_read[3]));
+    co_return result;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The coroutine that writes data to Mercury and receives its status packet
+  /// @param port PortHandler instance
+  /// @param id Mercury ID
+  /// @param address Address of the data for write
+  /// @param length Length of the data for write
+  /// @param data Data for write
+  /// @param error Mercury hardware error, or NULL
+  /// @return communication results of PacketHandler::writeTxRx()
+  ////////////////////////////////////////////////////////////////////////////////
+  Task<int> writeTxRx(PortHandler *port, uint8_t id, uint16_t address, uint16_t length, uint8_t *data, uint8_t *error = 0)
+  {
+    co_await PortLockAwaiter(loop_, port);
+    PortLock lock(loop_, port);
+
+    int result = ph_->writeTx(port, id, address, length, data);
+    if (result != COMM_SUCCESS)
+      co_return result;
+
+    co_return co_await rxStatus(port, id, error, 0, 0);
+  }
+
+  Task<int> write1ByteTxRx(PortHandler *port, uint8_t id, uint16_t address, uint8_t data, uint8_t *error = 0)
+  {
+    uint8_t data_write[1] = { data };
+    co_return co_await writeTxRx(port, id, address, 1, data_write, error);
+  }
+
+  Task<int> write2ByteTxRx(PortHandler *port, uint8_t id, uint16_t address, uint16_t data, uint8_t *error = 0)
+  {
+    uint8_t data_write[2] = { MCY_LOBYTE(data), MCY_HIBYTE(data) };
+    co_return co_await writeTxRx(port, id, address, 2, data_write, error);
+  }
+
+  Task<int> write4ByteTxRx(PortHandler *port, uint8_t id, uint16_t address, uint32_t data, uint8_t *error = 0)
+  {
+    uint8_t data_write[4] = { MCY_LOBYTE(MCY_LOWORD(data)), MCY_HIBYTE(MCY_LOWORD(data)), MCY_LOBYTE(MCY_HIWORD(data)), MCY_HIBYTE(MCY_HIWORD(data)) };
+    co_return co_await writeTxRx(port, id, address, 4, data_write, error);
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The coroutine that transmits the Sync Write instruction packet of a group
+  /// @description The packet is only transmitted, the coroutine waits for nothing but its turn on the port.
+  /// @param group Sync Write group
+  /// @return communication results of GroupSyncWrite::txPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  Task<int> syncWrite(GroupSyncWrite *group)
+  {
+    PortHandler *port = group->getPortHandler();
+    co_await PortLockAwaiter(loop_, port);
+    PortLock lock(loop_, port);
+
+    co_return group->txPacket();
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The coroutine that transmits the Sync Read instruction packet of a group and receives the status packets
+  /// @description The coroutine waits until all the status bytes asked for have arrived, or the packet timeout expires,
+  /// @description and then parses them with GroupSyncRead::rxPacket(). Byte stuffing in the status packets may leave it
+  /// @description a few byte times to wait for in GroupSyncRead::rxPacket().
+  /// @param group Sync Read group
+  /// @return communication results of GroupSyncRead::txRxPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  Task<int> syncRead(GroupSyncRead *group)
+  {
+    PortHandler *port = group->getPortHandler();
+    co_await PortLockAwaiter(loop_, port);
+    PortLock lock(loop_, port);
+
+    int result = group->txPacket();
+    if (result != COMM_SUCCESS)
+      co_return result;
+
+    while (port->getRxLength() < group->getRxLength() && port->isPacketTimeout() == false)
+    {
+      if (port->fillRxBuffer() > 0)
+        continue;
+      co_await PortWaitAwaiter(loop_, port);
+    }
+
+    co_return group->rxPacket();
+  }
+};
+
+}
+
+#endif /* __cpp_impl_coroutine */
+
+
+#endif /* INCLUDE_MERCURY_SDK_COPACKETHANDLER_H_ */
@@ -0,0 +1,80 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_CRC16_H_
+#define INCLUDE_MERCURY_SDK_CRC16_H_
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for the CRC-16 (polynomial 0x8005) which protects Protocol 2.0 packets
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC Crc16
+{
+ public:
+  enum Engine
+  {
+    ENGINE_TABLE    = 0,  ///< one table lookup per byte
+    ENGINE_SLICE8   = 1,  ///< eight table lookups per eight bytes
+    ENGINE_CLMUL    = 2   ///< carry-less multiplication folding 16 bytes at a time (x86-64 with PCLMULQDQ and SSSE3)
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that continues a CRC over a block of bytes
+  /// @description Calling the function on consecutive blocks gives the same result as calling it once on their concatenation.
+  /// @description The block is handed to the fastest engine the processor supports, chosen on the first call.
+  /// @param crc_accum CRC of the preceding bytes (0 for the start of a packet)
+  /// @param data_blk_ptr Bytes to add to the CRC
+  /// @param data_blk_size Number of bytes
+  /// @return CRC of the preceding bytes followed by the block
+  ////////////////////////////////////////////////////////////////////////////////
+  static uint16_t update(uint16_t crc_accum, const uint8_t *data_blk_ptr, uint16_t data_blk_size);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that continues a CRC over a block of bytes with the given engine
+  /// @description An engine which the processor doesn't support falls back to ENGINE_SLICE8.
+  /// @param engine Engine to use
+  /// @param crc_accum CRC of the preceding bytes (0 for the start of a packet)
+  /// @param data_blk_ptr Bytes to add to the CRC
+  /// @param data_blk_size Number of bytes
+  /// @return CRC of the preceding bytes followed by the block
+  ////////////////////////////////////////////////////////////////////////////////
+  static uint16_t update(Engine engine, uint16_t crc_accum, const uint8_t *data_blk_ptr, uint16_t data_blk_size);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the engine used by Crc16::update() for long blocks
+  /// @return ENGINE_CLMUL when the processor supports it, or ENGINE_SLICE8
+  ////////////////////////////////////////////////////////////////////////////////
+  static Engine   getEngine();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that continues a CRC over a run of zero bytes
+  /// @description The CRC starts from 0 and has no final xor, so it is linear: the CRC of a packet in which some bytes
+  /// @description changed is the old CRC xor the CRC of the changed bits, continued over the bytes after them with this function.
+  /// @param crc_accum CRC of the preceding bytes
+  /// @param zero_count Number of zero bytes
+  /// @return CRC of the preceding bytes followed by zero_count zero bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  static uint16_t extend(uint16_t crc_accum, uint32_t zero_count);
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_CRC16_H_ */
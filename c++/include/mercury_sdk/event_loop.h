@@ -0,0 +1,159 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_EVENTLOOP_H_
+#define INCLUDE_MERCURY_SDK_EVENTLOOP_H_
+
+#include <vector>
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that drives the transactions of many ports from one thread
+/// @description Transactions wait for their port with EventLoop::waitPort() instead of sleeping in PortHandler::waitPort().
+/// @description EventLoop::run() waits for all ports at once with epoll, and for the earliest packet timeout with a timerfd,
+/// @description then resumes the transactions whose port has bytes or whose timeout has expired.
+/// @description The loop is not thread safe, every function is called from the thread which runs it.
+/// @description Ports without a descriptor (PortHandler::getPortDescriptor() returns -1) are polled on every pass instead.
+/// @description Ports with a clock of their own (PortHandler::isClockVirtual()) are moved on by PortHandler::waitPort(),
+/// @description which doesn't block, and their transactions are resumed on the next pass.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC EventLoop
+{
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The base class for whatever waits in the loop, e.g. a suspended coroutine
+  /// @description The waiter is linked into the loop by itself and has to stay alive until it is resumed.
+  ////////////////////////////////////////////////////////////////////////////////
+  class WINDECLSPEC Waiter
+  {
+    friend class EventLoop;
+
+   private:
+    Waiter *next_;
+
+   public:
+    Waiter() : next_(0) { }
+    virtual ~Waiter() { }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    /// @brief The function that is called by EventLoop::run() when the wait is over
+    ////////////////////////////////////////////////////////////////////////////////
+    virtual void resume() = 0;
+  };
+
+ private:
+  struct PortEntry
+  {
+    PortHandler *port;
+    int          descriptor;
+    bool         is_locked;
+    Waiter      *lock_head;     // waiters for the lock, in order
+    Waiter      *lock_tail;
+    Waiter      *reader;        // waiter for bytes or the packet timeout
+    int64_t      deadline;
+  };
+
+  int     epoll_fd_;
+  int     timer_fd_;
+  int64_t timer_deadline_;      // deadline the timer is armed for, 0 when disarmed
+
+  std::vector<PortEntry *> ports_;
+
+  Waiter *ready_head_;          // waiters to resume on this pass
+  Waiter *ready_tail_;
+  int     reader_count_;
+  bool    is_stopped_;
+
+  PortEntry *getEntry(PortHandler *port);
+  void    wake(PortEntry *entry);
+  void    armTimer(int64_t deadline);
+
+ public:
+  EventLoop();
+  virtual ~EventLoop();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that adds an open port to the loop
+  /// @description Ports are also added when they are first used. A port which is closed and opened again
+  /// @description has to be removed and added again, since its descriptor changes.
+  /// @param port PortHandler instance
+  /// @return false
+  /// @return   when the descriptor of the port can't be watched
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    addPort(PortHandler *port);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that removes a port which no transaction uses from the loop
+  /// @param port PortHandler instance
+  ////////////////////////////////////////////////////////////////////////////////
+  void    removePort(PortHandler *port);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that takes the port for one transaction
+  /// @description Transactions which find the port taken are queued, and resumed in order as it is given back.
+  /// @param port PortHandler instance
+  /// @param waiter Waiter to resume when the port is taken later
+  /// @return true
+  /// @return   when the port is taken at once, the waiter isn't used then
+  /// @return or false
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    lockPort(PortHandler *port, Waiter *waiter);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that gives the port back, to the next transaction in the queue if there is one
+  /// @param port PortHandler instance
+  ////////////////////////////////////////////////////////////////////////////////
+  void    unlockPort(PortHandler *port);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that waits for bytes on the port
+  /// @description The waiter is resumed when bytes are able to be read from the port,
+  /// @description or when the packet timeout set by PortHandler::setPacketTimeout() expires, whichever comes first.
+  /// @param port PortHandler instance
+  /// @param waiter Waiter to resume
+  /// @return false
+  /// @return   when the port is waited for already or can't be added
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    waitPort(PortHandler *port, Waiter *waiter);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that resumes a waiter on the next pass of the loop
+  /// @param waiter Waiter to resume
+  ////////////////////////////////////////////////////////////////////////////////
+  void    post(Waiter *waiter);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that runs the loop
+  /// @description The function returns when nothing is left to wait for, or when EventLoop::stop() is called.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    run();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that makes EventLoop::run() return after the current pass
+  ////////////////////////////////////////////////////////////////////////////////
+  void    stop() { is_stopped_ = true; }
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_EVENTLOOP_H_ */
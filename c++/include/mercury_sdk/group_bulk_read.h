@@ -0,0 +1,173 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file The file for Mercury Bulk Read
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MERCURY_SDK_INCLUDE_MERCURY_SDK_GROUPBULKREAD_H_
+#define MERCURY_SDK_INCLUDE_MERCURY_SDK_GROUPBULKREAD_H_
+
+
+#include "port_handler.h"
+#include "packet_handler.h"
+#include "group_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for reading multiple Mercury data from different addresses with different lengths at once
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC GroupBulkRead : public GroupHandler
+{
+protected:
+    std::vector<uint16_t> address_list_;    // start address of each slot
+    std::vector<uint8_t> error_list_;       // error of each slot
+    std::vector<uint8_t> param_list_;       // ID(1) + ADDR(2) + LENGTH(2) of each slot, the Bulk Read parameter as it was last sent
+
+    // per slot, for PacketHandler::bulkReadRx()
+    std::vector<uint8_t *> rx_data_list_;
+    std::vector<uint8_t *> rx_error_list_;
+    std::vector<int> rx_result_list_;
+
+    bool is_fast_read_;
+    bool is_fast_read_sent_;                // mode of the last instruction packet, which its status packets follow
+
+    void makeParam();
+    int  dropRx();
+
+public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that Initializes instance for Bulk Read
+  /// @param port PortHandler instance
+  /// @param ph PacketHandler instance
+  ////////////////////////////////////////////////////////////////////////////////
+  GroupBulkRead(PortHandler *port, PacketHandler *ph);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that calls clearParam function to clear the parameter list for Bulk Read
+  ////////////////////////////////////////////////////////////////////////////////
+  ~GroupBulkRead() { clearParam(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that adds id, start_address, data_length to the Bulk Read list
+  /// @param id Mercury ID
+  /// @param start_address Address of the data for read
+  /// @param data_length Length of the data for read
+  /// @return false
+  /// @return   when the ID exists already in the list
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    addParam    (uint8_t id, uint16_t start_address, uint16_t data_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that removes id from the Bulk Read list
+  /// @param id Mercury ID
+  ////////////////////////////////////////////////////////////////////////////////
+  void    removeParam (uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that clears the Bulk Read list
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clearParam  ();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that selects between Bulk Read and Fast Bulk Read
+  /// @description With Fast Bulk Read the Mercurys answer together in one status packet with a single header and CRC.
+  /// @param enable true for INST_FAST_BULK_READ, false for INST_BULK_READ
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setFastRead (bool enable) { is_fast_read_ = enable; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether Fast Bulk Read is used
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isFastRead  () { return is_fast_read_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits the Bulk Read instruction packet which might be constructed by GroupBulkRead::addParam function
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the list for Bulk Read is empty
+  /// @return or the other communication results which come from PacketHandler::bulkReadTx
+  ////////////////////////////////////////////////////////////////////////////////
+  int     txPacket();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that receives the packets which might be come from the Mercurys
+  /// @description All status packets are received in one pass by PacketHandler::bulkReadRx(),
+  /// @description a Mercury which fails does not stop the data of the others from being received.
+  /// @description The status packets are read as the last GroupBulkRead::txPacket sent them for, Fast or not.
+  /// @description When the list changed after GroupBulkRead::txPacket, the status packets of the list which was sent are received and dropped.
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the list for Bulk Read is empty
+  /// @return   when the list changed after the instruction packet was sent
+  /// @return COMM_SUCCESS
+  /// @return   when there is packet recieved from every Mercury
+  /// @return or the communication result of the first Mercury which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  int     rxPacket();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits and receives the packets which might be come from the Mercurys
+  /// @return communication results which come from GroupBulkRead::txPacket or GroupBulkRead::rxPacket
+  ////////////////////////////////////////////////////////////////////////////////
+  int     txRxPacket();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether there are available data which might be received by GroupBulkRead::rxPacket or GroupBulkRead::txRxPacket
+  /// @param id Mercury ID
+  /// @param address Address of the data for read
+  /// @param data_length Length of the data for read
+  /// @return false
+  /// @return   when there are no data available for the ID
+  /// @return   when the address is out of the range read from the ID
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool        isAvailable (uint8_t id, uint16_t address, uint16_t data_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the communication result of one Mercury in the last GroupBulkRead::rxPacket
+  /// @param id Mercury ID
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the ID is not in the list or nothing has been received since the list changed
+  /// @return or the communication result for the ID
+  ////////////////////////////////////////////////////////////////////////////////
+  int         getResult   (uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that gets the data which might be received by GroupBulkRead::rxPacket or GroupBulkRead::txRxPacket
+  /// @param id Mercury ID
+  /// @param address Address of the data for read
+  /// @param data_length Length of the data for read
+  /// @return data value
+  ////////////////////////////////////////////////////////////////////////////////
+  uint32_t    getData     (uint8_t id, uint16_t address, uint16_t data_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that gets the error which might be received by GroupBulkRead::rxPacket or GroupBulkRead::txRxPacket
+  /// @param id Mercury ID
+  /// @param error error of Mercury
+  /// @return true
+  /// @return   when Mercury returned specific error byte
+  /// @return or false
+  ////////////////////////////////////////////////////////////////////////////////
+  bool        getError    (uint8_t id, uint8_t* error);
+};
+
+}
+
+
+#endif /* MERCURY_SDK_INCLUDE_MERCURY_SDK_GROUPBULKREAD_H_ */
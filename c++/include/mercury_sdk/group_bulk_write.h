@@ -0,0 +1,97 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+////////////////////////////////////////////////////////////////////////////////
+/// @file The file for Mercury Bulk Write
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MERCURY_SDK_INCLUDE_MERCURY_SDK_GROUPBULKWRITE_H_
+#define MERCURY_SDK_INCLUDE_MERCURY_SDK_GROUPBULKWRITE_H_
+
+
+#include "port_handler.h"
+#include "packet_handler.h"
+#include "group_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for writing multiple Mercury data to different addresses with different lengths at once
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC GroupBulkWrite : public GroupHandler
+{
+public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that Initializes instance for Bulk Write
+  /// @param port PortHandler instance
+  /// @param ph PacketHandler instance
+  ////////////////////////////////////////////////////////////////////////////////
+  GroupBulkWrite(PortHandler *port, PacketHandler *ph);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that calls clearParam function to clear the parameter list for Bulk Write
+  ////////////////////////////////////////////////////////////////////////////////
+  ~GroupBulkWrite() { clearParam(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that adds id, start_address, data_length to the Bulk Write list
+  /// @param id Mercury ID
+  /// @param start_address Address of the data for write
+  /// @param data_length Length of the data for write
+  /// @param data Data for write
+  /// @return false
+  /// @return   when the ID exists already in the list
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    addParam    (uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that removes id from the Bulk Write list
+  /// @param id Mercury ID
+  ////////////////////////////////////////////////////////////////////////////////
+  void    removeParam (uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that changes the address, length and data for write of id in the Bulk Write list
+  /// @param id Mercury ID
+  /// @param start_address Address of the data for write
+  /// @param data_length Length of the data for write
+  /// @param data Data for write
+  /// @return false
+  /// @return   when the ID doesn't exist in the list
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    changeParam (uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that clears the Bulk Write list
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clearParam  ();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits the Bulk Write instruction packet which might be constructed by GroupBulkWrite::addParam function
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the list for Bulk Write is empty
+  /// @return or the other communication results which come from PacketHandler::bulkWriteTxOnly
+  ////////////////////////////////////////////////////////////////////////////////
+  int     txPacket();
+};
+
+}
+
+
+#endif /* MERCURY_SDK_INCLUDE_MERCURY_SDK_GROUPBULKWRITE_H_ */
@@ -23,11 +23,13 @@
 #define MERCURY_SDK_INCLUDE_MERCURY_SDK_GROUPHANDLER_H
 
 
-#include <map>
 #include <vector>
 #include "port_handler.h"
 #include "packet_handler.h"
 
+#define GROUP_NO_SLOT           0xFF    // id_to_slot_ value of an ID which is not in the list
+#define GROUP_DATA_ALIGNMENT    64      // data_ starts on a cache line
+
 namespace mercury
 {
 
@@ -35,6 +37,7 @@ class WINDECLSPEC GroupHandler
 {
 public:
     GroupHandler(PortHandler *port, PacketHandler *ph);
+    virtual ~GroupHandler();
 
     PortHandler *getPortHandler() { return port_; }
     PacketHandler *getPacketHandler() { return ph_; }
@@ -43,12 +46,35 @@ protected:
     PortHandler *port_;
     PacketHandler *ph_;
 
-    std::vector<uint8_t> id_list_;
-    std::map<uint8_t, uint8_t *> data_list_;     // <id, data>
+    std::vector<uint8_t> id_list_;          // IDs in slot order
+
+    // the data of every ID lives in one contiguous buffer, each ID owns a slot in it
+    uint8_t id_to_slot_[256];               // <id, slot>, GROUP_NO_SLOT when the ID is not in the list
+    std::vector<uint32_t> slot_offset_;     // offset of the data of each slot in data_
+    std::vector<uint16_t> slot_length_;     // length of the data of each slot
+    uint8_t *data_;
+    uint32_t data_size_;
+
+    // bytes kept free before and after the slots, so a group can frame its packet around them
+    uint16_t frame_head_;
+    uint16_t frame_tail_;
 
     bool is_param_changed_;
 
-    uint8_t *param_;
+    // returns the slot of the ID, or -1 when the ID is not in the list
+    int      findSlot    (uint8_t id) { return (id_to_slot_[id] == GROUP_NO_SLOT) ? -1 : id_to_slot_[id]; }
+    uint8_t *getSlotData (int slot)   { return data_ + slot_offset_[slot]; }
+    uint8_t *getFrame    ()           { return data_ - frame_head_; }
+
+    // adds a zeroed slot of length bytes after the others, false when the ID exists already
+    bool     addSlot     (uint8_t id, uint16_t length);
+    // removes the slot of the ID and moves the following slots down, returns the removed slot or -1
+    int      removeSlot  (uint8_t id);
+    void     clearSlots  ();
+
+private:
+    uint8_t *data_buffer_;                  // allocation data_ is aligned in
+    uint32_t data_capacity_;
 };
 
 }
@@ -36,14 +36,24 @@ namespace mercury
 class WINDECLSPEC GroupSyncRead : public GroupHandler
 {
 protected:
-    std::map<uint8_t, uint8_t *> error_list_; // <id, error>
+    std::vector<uint8_t> error_list_;       // error of each slot
 
-    bool last_result_;
+    // per slot, for PacketHandler::syncReadRx()
+    std::vector<uint8_t *> rx_data_list_;
+    std::vector<uint8_t *> rx_error_list_;
+    std::vector<int> rx_result_list_;
+
+    bool is_fast_read_;
+    bool is_fast_read_sent_;                // mode of the last instruction packet, which its status packets follow
 
     uint16_t start_address_;
     uint16_t data_length_;
 
+    PreparedPacket prepared_;               // Sync Read instruction packet, framed again only when the list changes
+    std::vector<uint8_t> prepared_id_list_; // IDs prepared_ was framed with, which its status packets answer
+
     void makeParam();
+    int  dropRx();
 
 public:
   ////////////////////////////////////////////////////////////////////////////////
@@ -81,23 +91,49 @@ public:
   ////////////////////////////////////////////////////////////////////////////////
   void    clearParam  ();
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that selects between Sync Read and Fast Sync Read
+  /// @description With Fast Sync Read the Dynamixels answer together in one status packet with a single header and CRC,
+  /// @description which saves the framing and the return delay of every Dynamixel but the first.
+  /// @param enable true for INST_FAST_SYNC_READ, false for INST_SYNC_READ
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setFastRead (bool enable) { is_fast_read_ = enable; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether Fast Sync Read is used
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isFastRead  () { return is_fast_read_; }
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that transmits the Sync Read instruction packet which might be constructed by GroupSyncRead::addParam function
+  /// @description The packet is framed once by PreparedPacket and sent again as it is until the list changes.
   /// @return COMM_NOT_AVAILABLE
   /// @return   when the list for Sync Read is empty
   /// @return   when the protocol1.0 has been used
-  /// @return or the other communication results which come from PacketHandler::syncReadTx
+  /// @return COMM_TX_ERROR
+  /// @return   when the packet or its answer doesn't fit in the packet buffers
+  /// @return or the other communication results which come from PacketHandler::txPreparedPacket
   ////////////////////////////////////////////////////////////////////////////////
   int     txPacket();
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of status bytes the last GroupSyncRead::txPacket asked for, without byte stuffing
+  ////////////////////////////////////////////////////////////////////////////////
+  uint16_t getRxLength() { return prepared_.getRxLength(); }
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that receives the packet which might be come from the Dynamixel
+  /// @description All status packets are received in one pass by PacketHandler::syncReadRx(),
+  /// @description a Dynamixel which fails does not stop the data of the others from being received.
+  /// @description The status packets are read as the last GroupSyncRead::txPacket sent them for, Fast or not.
+  /// @description When the list changed after GroupSyncRead::txPacket, the status packets of the list which was sent are received and dropped.
   /// @return COMM_NOT_AVAILABLE
   /// @return   when the list for Sync Read is empty
+  /// @return   when the list changed after the instruction packet was sent
   /// @return   when the protocol1.0 has been used
   /// @return COMM_SUCCESS
-  /// @return   when there is packet recieved
-  /// @return or the other communication results
+  /// @return   when there is packet recieved from every Dynamixel
+  /// @return or the communication result of the first Dynamixel which failed
   ////////////////////////////////////////////////////////////////////////////////
   int     rxPacket();
 
@@ -119,12 +155,21 @@ public:
   /// @param address Address of the data for read
   /// @param data_length Length of the data for read
   /// @return false
-  /// @return   when there are no data available
+  /// @return   when there are no data available for the ID
   /// @return   when the protocol1.0 has been used
   /// @return or true
   ////////////////////////////////////////////////////////////////////////////////
   bool        isAvailable (uint8_t id, uint16_t address, uint16_t data_length);
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the communication result of one Dynamixel in the last GroupSyncRead::rxPacket
+  /// @param id Dynamixel ID
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the ID is not in the list or nothing has been received since the list changed
+  /// @return or the communication result for the ID
+  ////////////////////////////////////////////////////////////////////////////////
+  int         getResult   (uint8_t id);
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that gets the data which might be received by GroupSyncRead::rxPacket or GroupSyncRead::txRxPacket
   /// @param id Dynamixel ID
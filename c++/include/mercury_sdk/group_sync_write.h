@@ -39,7 +39,16 @@ private:
     uint16_t start_address_;
     uint16_t data_length_;
 
-    void makeParam();
+    // the instruction packet is framed around the slots and kept between transmissions,
+    // only the slots from first_dirty_slot_ on are checked again before the next one
+    std::vector<uint16_t> slot_crc_;        // CRC16 of the packet up to each slot, and of the whole packet last
+    std::vector<uint8_t> slot_stuffing_;    // whether FF FF FD ends in each slot
+    int stuffing_count_;                    // slots in which FF FF FD ends
+    bool header_stuffing_;                  // whether FF FF FD ends in the address or the data length
+    unsigned int first_dirty_slot_;
+
+    void    makeFrame();
+    void    updateFrame();
 
 public:
   ////////////////////////////////////////////////////////////////////////////////
@@ -89,9 +98,11 @@ public:
 
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that transmits the Sync Write instruction packet which might be constructed by GroupSyncWrite::addParam function
+  /// @description The packet is written with PacketHandler::framedPacketTxOnly, after the CRC16 of the changed slots is updated.
+  /// @description A packet which needs byte stuffing is sent with PacketHandler::syncWriteTxOnly instead.
   /// @return COMM_NOT_AVAILABLE
   /// @return   when the list for Sync Write is empty
-  /// @return or the other communication results which come from PacketHandler::syncWriteTxOnly
+  /// @return or the other communication results which come from PacketHandler::framedPacketTxOnly or PacketHandler::syncWriteTxOnly
   ////////////////////////////////////////////////////////////////////////////////
   int     txPacket();
 };
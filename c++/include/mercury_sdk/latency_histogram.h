@@ -0,0 +1,105 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_LATENCYHISTOGRAM_H_
+#define INCLUDE_MERCURY_SDK_LATENCYHISTOGRAM_H_
+
+#include <atomic>
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for a histogram of latencies with a fixed relative precision, in the manner of HdrHistogram
+/// @description Latencies are counted in microseconds. Below 64 usec every value has its own bucket, above it each power
+/// @description of two is split into 32 buckets, so a bucket is at most 1/32 (3.1%) of its values wide, up to 67 seconds.
+/// @description One thread records, any other thread can read the histogram at the same time without a lock:
+/// @description the buckets are atomic counters, so a reader sees each of them whole, if not all of them at the same instant.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC LatencyHistogram
+{
+ public:
+  static const int      SUB_BUCKET_BITS_  = 6;      ///< bits of a value kept by its bucket
+  static const int      MAX_VALUE_BITS_   = 26;     ///< values from 2^26 usec on are counted in the last bucket
+  static const int      BUCKET_COUNT_     = (MAX_VALUE_BITS_ - SUB_BUCKET_BITS_ + 2) << (SUB_BUCKET_BITS_ - 1);
+
+  LatencyHistogram();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that counts a latency
+  /// @description Only one thread may record into a histogram at a time.
+  /// @param nsec Latency in nanoseconds, negative values count as 0
+  ////////////////////////////////////////////////////////////////////////////////
+  void    record(int64_t nsec);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that empties the histogram
+  /// @description No thread may record into the histogram while the function runs.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clear();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of latencies counted
+  ////////////////////////////////////////////////////////////////////////////////
+  uint64_t getCount() const { return count_.load(std::memory_order_relaxed); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns a percentile of the latencies
+  /// @description The value is the upper end of the bucket which holds the percentile, so it is never below the true one.
+  /// @param percentile Percentile from 0 to 100, e.g. 99.9
+  /// @return Latency in milliseconds
+  /// @return or 0 when the histogram is empty
+  ////////////////////////////////////////////////////////////////////////////////
+  double  getPercentile(double percentile) const;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the mean of the latencies
+  /// @return Latency in milliseconds, or 0 when the histogram is empty
+  ////////////////////////////////////////////////////////////////////////////////
+  double  getMean() const;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the highest latency counted, exactly
+  /// @return Latency in milliseconds, or 0 when the histogram is empty
+  ////////////////////////////////////////////////////////////////////////////////
+  double  getMax() const;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of latencies in a bucket
+  /// @param bucket Bucket from 0 to BUCKET_COUNT_ - 1
+  ////////////////////////////////////////////////////////////////////////////////
+  uint64_t getBucketCount(int bucket) const { return buckets_[bucket].load(std::memory_order_relaxed); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the upper end of a bucket
+  /// @param bucket Bucket from 0 to BUCKET_COUNT_ - 1
+  /// @return Latency in milliseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  static double getBucketLimit(int bucket);
+
+ private:
+  std::atomic<uint64_t> buckets_[BUCKET_COUNT_];
+  std::atomic<uint64_t> count_;
+  std::atomic<int64_t>  sum_;     ///< nsec
+  std::atomic<int64_t>  max_;     ///< nsec
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_LATENCYHISTOGRAM_H_ */
@@ -17,9 +17,30 @@
 #ifndef INCLUDE_MERCURY_SDK_MERCURYSDK_H_
 #define INCLUDE_MERCURY_SDK_MERCURYSDK_H_
 
+#include "async_packet_handler.h"
+#include "bus_emulator.h"
+#include "bus_manager.h"
+#include "byte_stuffing.h"
+#include "co_packet_handler.h"
+#include "crc16.h"
+#include "event_loop.h"
+#include "group_bulk_read.h"
+#include "group_bulk_write.h"
 #include "group_sync_read.h"
 #include "group_sync_write.h"
+#include "latency_histogram.h"
+#include "monotonic_clock.h"
 #include "packet_handler.h"
 #include "port_handler.h"
+#include "port_handler_emulator.h"
+#include "port_handler_replay.h"
+#include "port_handler_scheduled.h"
+#include "port_io_engine.h"
+#include "prepared_packet.h"
+#include "servo_emulator.h"
+#include "status_packet_parser.h"
+#include "traffic_recorder.h"
+#include "transaction_metrics.h"
+#include "virtual_bus.h"
 
 #endif /* INCLUDE_MERCURY_SDK_MERCURYSDK_H_ */	
\ No newline at end of file
@@ -0,0 +1,63 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_MONOTONICCLOCK_H_
+#define INCLUDE_MERCURY_SDK_MONOTONICCLOCK_H_
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for the monotonic time base used for every timeout in the SDK
+/// @description Times are signed 64-bit nanosecond counts from an arbitrary fixed point.
+/// @description The clock never jumps when the wall clock is stepped (e.g. by NTP),
+/// @description so applications can use it to schedule their control loops against the same deadlines as the SDK.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC MonotonicClock
+{
+ public:
+  static const int64_t NSEC_PER_USEC = 1000LL;        ///< nanoseconds per microsecond
+  static const int64_t NSEC_PER_MSEC = 1000000LL;     ///< nanoseconds per millisecond
+  static const int64_t NSEC_PER_SEC  = 1000000000LL;  ///< nanoseconds per second
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the current monotonic time
+  /// @description The function reads CLOCK_MONOTONIC on Linux and QueryPerformanceCounter() on Windows.
+  /// @return current time in nanoseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  static int64_t getTime();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that converts milliseconds to nanoseconds
+  /// @param msec Time in milliseconds
+  /// @return Time in nanoseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  static int64_t fromMsec(double msec) { return (int64_t)(msec * (double)NSEC_PER_MSEC); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that converts nanoseconds to milliseconds
+  /// @param nsec Time in nanoseconds
+  /// @return Time in milliseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  static double  toMsec(int64_t nsec) { return (double)nsec / (double)NSEC_PER_MSEC; }
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_MONOTONICCLOCK_H_ */
@@ -39,6 +39,8 @@
 #include <functional>
 #include <string>
 #include "port_handler.h"
+#include "prepared_packet.h"
+#include "status_packet_parser.h"
 
 #define BROADCAST_ID        0xFE    // 254
 #define MAX_ID              0xFC    // 252
@@ -63,6 +65,10 @@
 #define INST_CLEAR              16      // 0x10
 #define INST_STATUS             85      // 0x55
 #define INST_SYNC_READ          130     // 0x82
+#define INST_BULK_READ          146     // 0x92
+#define INST_BULK_WRITE         147     // 0x93
+#define INST_FAST_SYNC_READ     138     // 0x8A
+#define INST_FAST_BULK_READ     154     // 0x9A
 
 // Communication Result
 #define COMM_SUCCESS        0       // tx or rx packet communication success
@@ -153,6 +159,20 @@ class WINDECLSPEC PacketHandler
   ////////////////////////////////////////////////////////////////////////////////
   virtual int rxPacket        (PortHandler *port, uint8_t *rxpacket) = 0;
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that receives as much of a status packet as has arrived, without waiting
+  /// @description The function feeds the received bytes to the parser and returns as soon as they run out,
+  /// @description so a caller can wait for the port by itself (e.g. in an event loop) and call it again.
+  /// @description PacketHandler::rxPacket() is this function called until the packet is complete, with PortHandler::waitPort() in between.
+  /// @description Unlike PacketHandler::rxPacket(), the function doesn't release the port.
+  /// @param port PortHandler instance
+  /// @param parser Parser of the status packet, which keeps its place between the calls
+  /// @return COMM_RX_WAITING
+  /// @return   when the packet isn't complete yet and PortHandler::isPacketTimeout() doesn't show the timeout
+  /// @return or the other communication results of PacketHandler::rxPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int rxPacketNoWait  (PortHandler *port, StatusPacketParser *parser) = 0;
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that transmits packet (txpacket) and receives packet (rxpacket) during designated time via PortHandler port
   /// @description The function calls PacketHandler::txPacket(),
@@ -198,6 +218,19 @@ class WINDECLSPEC PacketHandler
   ////////////////////////////////////////////////////////////////////////////////
   virtual int ping            (PortHandler *port, uint8_t id, uint16_t *model_number, uint8_t *error = 0) = 0;
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits INST_PING instruction packet
+  /// @description The function makes an instruction packet with INST_PING,
+  /// @description transmits the packet with PacketHandler::txPacket() and sets the timeout of the status packet,
+  /// @description which is then received with PacketHandler::rxPacket() or PacketHandler::rxPacketNoWait().
+  /// @param port PortHandler instance
+  /// @param id Mercury ID
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when it tries to transmit to BROADCAST_ID
+  /// @return or the other communication results which come from PacketHandler::txPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int pingTx          (PortHandler *port, uint8_t id) = 0;
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief (Available only in Protocol 2.0) The function that pings all connected Mercury
   /// @param port PortHandler instance
@@ -419,6 +452,24 @@ class WINDECLSPEC PacketHandler
   ////////////////////////////////////////////////////////////////////////////////
   virtual int writeTxOnly     (PortHandler *port, uint8_t id, uint16_t address, uint16_t length, uint8_t *data) = 0;
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits INST_WRITE instruction packet with the data for write, for a status packet to follow
+  /// @description The function makes an instruction packet with INST_WRITE and the data for write,
+  /// @description transmits the packet with PacketHandler::txPacket() and sets the timeout of the status packet,
+  /// @description which is then received with PacketHandler::rxPacket() or PacketHandler::rxPacketNoWait().
+  /// @param port PortHandler instance
+  /// @param id Mercury ID
+  /// @param address Address of the data for write
+  /// @param length Length of the data for write
+  /// @param data Data for write
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when it tries to transmit to BROADCAST_ID
+  /// @return COMM_TX_ERROR
+  /// @return   when the data doesn't fit in the instruction packet
+  /// @return or the other communication results which come from PacketHandler::txPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int writeTx         (PortHandler *port, uint8_t id, uint16_t address, uint16_t length, uint8_t *data) = 0;
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that transmits INST_WRITE instruction packet with the data for write, and receives the packet
   /// @description The function makes an instruction packet with INST_WRITE and the data for write,
@@ -549,6 +600,89 @@ class WINDECLSPEC PacketHandler
   ////////////////////////////////////////////////////////////////////////////////
   virtual int syncReadTx      (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length) = 0;
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that receives every status packet answering an INST_SYNC_READ instruction packet
+  /// @description The function feeds the bytes received on the port through one status packet parser until every Mercury
+  /// @description in id_list has answered or the packet timeout set by PacketHandler::syncReadTx() expires.
+  /// @description The data of each packet is copied to data_list as soon as the packet is complete, and a Mercury which
+  /// @description does not answer or whose packet is corrupt does not stop the others from being received.
+  /// @param port PortHandler instance
+  /// @param data_length Length of the data for Sync Read
+  /// @param id_list Mercury IDs in the order of the Sync Read parameter
+  /// @param id_count Number of IDs in id_list
+  /// @param data_list Buffers of data_length bytes for the data of each ID
+  /// @param error_list Buffers for the Mercury hardware error of each ID
+  /// @param result_list Communication result of each ID
+  /// @return COMM_SUCCESS
+  /// @return   when every Mercury has answered with a valid packet
+  /// @return or the communication result of the first ID in id_list which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int syncReadRx      (PortHandler *port, uint16_t data_length, uint8_t *id_list, uint16_t id_count, uint8_t **data_list, uint8_t **error_list, int *result_list) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits INST_FAST_SYNC_READ instruction packet
+  /// @description The function makes an instruction packet with INST_FAST_SYNC_READ,
+  /// @description transmits the packet with PacketHandler::txPacket().
+  /// @description The Mercurys answer together in one status packet, which is received by PacketHandler::fastSyncReadRx().
+  /// @param port PortHandler instance
+  /// @param start_address Address of the data for Fast Sync Read
+  /// @param data_length Length of the data for Fast Sync Read
+  /// @param param Parameter for Fast Sync Read
+  /// @param param_length Length of the data for Fast Sync Read
+  /// @return COMM_TX_ERROR
+  /// @return   when the status packet would not fit in the status packet buffer of the port
+  /// @return or the other communication results which come from PacketHandler::txPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int fastSyncReadTx  (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that receives the status packet answering an INST_FAST_SYNC_READ instruction packet
+  /// @description The status packet has one header and one CRC, and carries ERROR ID DATA CRC16 for every Mercury
+  /// @description in the order of the Fast Sync Read parameter.
+  /// @param port PortHandler instance
+  /// @param data_length Length of the data for Fast Sync Read
+  /// @param id_list Mercury IDs in the order of the Fast Sync Read parameter
+  /// @param id_count Number of IDs in id_list
+  /// @param data_list Buffers of data_length bytes for the data of each ID
+  /// @param error_list Buffers for the Mercury hardware error of each ID
+  /// @param result_list Communication result of each ID
+  /// @return COMM_SUCCESS
+  /// @return   when the status packet is valid and carries every ID
+  /// @return or the communication result of the first ID in id_list which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int fastSyncReadRx  (PortHandler *port, uint16_t data_length, uint8_t *id_list, uint16_t id_count, uint8_t **data_list, uint8_t **error_list, int *result_list) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits INST_FAST_BULK_READ instruction packet
+  /// @description The function makes an instruction packet with INST_FAST_BULK_READ,
+  /// @description transmits the packet with PacketHandler::txPacket().
+  /// @description The Mercurys answer together in one status packet, which is received by PacketHandler::fastBulkReadRx().
+  /// @param port PortHandler instance
+  /// @param param Parameter for Fast Bulk Read {ID, ADDR_L, ADDR_H, LEN_L, LEN_H, ID, ADDR_L, ADDR_H, LEN_L, LEN_H, ...}
+  /// @param param_length Length of the data for Fast Bulk Read
+  /// @return COMM_TX_ERROR
+  /// @return   when the status packet would not fit in the status packet buffer of the port
+  /// @return or the other communication results which come from PacketHandler::txPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int fastBulkReadTx  (PortHandler *port, uint8_t *param, uint16_t param_length) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that receives the status packet answering an INST_FAST_BULK_READ instruction packet
+  /// @description The status packet has one header and one CRC, and carries ERROR ID DATA CRC16 for every Mercury
+  /// @description in the order of the Fast Bulk Read parameter.
+  /// @param port PortHandler instance
+  /// @param id_list Mercury IDs in the order of the Fast Bulk Read parameter
+  /// @param id_count Number of IDs in id_list
+  /// @param data_length_list Length of the data for each ID
+  /// @param data_list Buffers for the data of each ID
+  /// @param error_list Buffers for the Mercury hardware error of each ID
+  /// @param result_list Communication result of each ID
+  /// @return COMM_SUCCESS
+  /// @return   when the status packet is valid and carries every ID
+  /// @return or the communication result of the first ID in id_list which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int fastBulkReadRx  (PortHandler *port, uint8_t *id_list, uint16_t id_count, uint16_t *data_length_list, uint8_t **data_list, uint8_t **error_list, int *result_list) = 0;
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that transmits INST_SYNC_WRITE instruction packet
   /// @description The function makes an instruction packet with INST_SYNC_WRITE,
@@ -562,6 +696,74 @@ class WINDECLSPEC PacketHandler
   ////////////////////////////////////////////////////////////////////////////////
   virtual int syncWriteTxOnly (PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length) = 0;
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits an instruction packet which is already framed
+  /// @description The function writes the packet as it is, with its header, byte stuffing and CRC16 already in place,
+  /// @description and doesn't wait for a status packet. It is used by GroupSyncWrite, which keeps its packet between transmissions.
+  /// @param port PortHandler instance
+  /// @param packet Framed instruction packet
+  /// @param length Length of the packet
+  /// @return COMM_PORT_BUSY
+  /// @return   when the port is already in use
+  /// @return COMM_TX_ERROR
+  /// @return   when the packet is longer than TXPACKET_MAX_LEN
+  /// @return COMM_TX_FAIL
+  /// @return   when written packet is shorter than expected
+  /// @return or COMM_SUCCESS
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int framedPacketTxOnly (PortHandler *port, uint8_t *packet, uint16_t length) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits a prepared instruction packet
+  /// @description The function writes the packet framed by PreparedPacket with a single PortHandler::writePort() call.
+  /// @description When the packet expects an answer, the port stays in use and the packet timeout is set,
+  /// @description so the answer is received as after the matching Tx function, e.g. by PacketHandler::readRx() or PacketHandler::syncReadRx().
+  /// @param port PortHandler instance
+  /// @param packet Prepared instruction packet
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when no packet is prepared
+  /// @return or communication results which come from PacketHandler::framedPacketTxOnly()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int txPreparedPacket (PortHandler *port, PreparedPacket *packet) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits INST_BULK_READ instruction packet
+  /// @description The function makes an instruction packet with INST_BULK_READ,
+  /// @description transmits the packet with PacketHandler::txPacket().
+  /// @param port PortHandler instance
+  /// @param param Parameter for Bulk Read {ID, ADDR_L, ADDR_H, LEN_L, LEN_H, ID, ADDR_L, ADDR_H, LEN_L, LEN_H, ...}
+  /// @param param_length Length of the data for Bulk Read
+  /// @return communication results which come from PacketHandler::txPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int bulkReadTx      (PortHandler *port, uint8_t *param, uint16_t param_length) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that receives every status packet answering an INST_BULK_READ instruction packet
+  /// @description The function works as PacketHandler::syncReadRx(), with a data length for each ID.
+  /// @param port PortHandler instance
+  /// @param id_list Mercury IDs in the order of the Bulk Read parameter
+  /// @param id_count Number of IDs in id_list
+  /// @param data_length_list Length of the data for each ID
+  /// @param data_list Buffers for the data of each ID
+  /// @param error_list Buffers for the Mercury hardware error of each ID
+  /// @param result_list Communication result of each ID
+  /// @return COMM_SUCCESS
+  /// @return   when every Mercury has answered with a valid packet
+  /// @return or the communication result of the first ID in id_list which failed
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int bulkReadRx      (PortHandler *port, uint8_t *id_list, uint16_t id_count, uint16_t *data_length_list, uint8_t **data_list, uint8_t **error_list, int *result_list) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that transmits INST_BULK_WRITE instruction packet
+  /// @description The function makes an instruction packet with INST_BULK_WRITE,
+  /// @description transmits the packet with PacketHandler::txRxPacket().
+  /// @param port PortHandler instance
+  /// @param param Parameter for Bulk Write {ID, ADDR_L, ADDR_H, LEN_L, LEN_H, DATA0, DATA1, ..., ID, ADDR_L, ...}
+  /// @param param_length Length of the data for Bulk Write
+  /// @return communication results which come from PacketHandler::txRxPacket()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int bulkWriteTxOnly (PortHandler *port, uint8_t *param, uint16_t param_length) = 0;
+
 ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that synchronises the servo
   /// @description This function will synchronise the target Mercury servo.
@@ -45,10 +45,14 @@
 #endif
 
 #include <stdint.h>
+#include <atomic>
 
 namespace mercury
 {
 
+class TrafficRecorder;
+class TransactionMetrics;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// @brief The class for port control that inherits PortHandlerLinux, PortHandlerWindows, PortHandlerMac, or PortHandlerArduino
 ////////////////////////////////////////////////////////////////////////////////
@@ -56,6 +60,30 @@ class WINDECLSPEC PortHandler
 {
  public:
   static const int DEFAULT_BAUDRATE_ = 1000000; ///< Default Baudrate
+  static const int RX_BUFFER_LENGTH_ = 4096;    ///< Size of the receive buffer
+  static const int TX_PACKET_LENGTH_ = 1024;    ///< Size of the instruction packet buffer
+  static const int RX_PACKET_LENGTH_ = 1024;    ///< Size of the status packet buffer
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The policy used by PortHandler::waitPort() while a status packet is awaited
+  ////////////////////////////////////////////////////////////////////////////////
+  enum WaitPolicy
+  {
+    WAIT_BLOCK  = 0,  ///< sleep until bytes arrive or the packet timeout expires
+    WAIT_SPIN   = 1,  ///< poll the port without sleeping (lowest latency, one core per port)
+    WAIT_HYBRID = 2   ///< sleep until the status packet is due, spin around its expected arrival, then sleep again
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief Time spent by PortHandler::waitPort() in each phase since the last PortHandler::resetWaitStatistics()
+  ////////////////////////////////////////////////////////////////////////////////
+  struct WaitStatistics
+  {
+    double    spin_time;      ///< msec spent spinning on the port
+    double    block_time;     ///< msec spent sleeping on the port
+    uint32_t  spin_wakeups;   ///< number of waits which found bytes while spinning
+    uint32_t  block_wakeups;  ///< number of waits which found bytes after sleeping
+  };
 
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that gets PortHandler class inheritance
@@ -63,10 +91,131 @@ class WINDECLSPEC PortHandler
   ////////////////////////////////////////////////////////////////////////////////
   static PortHandler *getPortHandler(const char *port_name);
 
-  bool   is_using_; ///< shows whether the port is in use
+  std::atomic<bool> is_using_; ///< shows whether the port is in use, a packet handler claims it with exchange(true)
 
   virtual ~PortHandler() { }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that selects how PortHandler::waitPort() waits for a status packet
+  /// @param policy WAIT_BLOCK, WAIT_SPIN or WAIT_HYBRID
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setWaitPolicy(WaitPolicy policy) { wait_policy_ = policy; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the wait policy of the port
+  /// @return WAIT_BLOCK, WAIT_SPIN or WAIT_HYBRID
+  ////////////////////////////////////////////////////////////////////////////////
+  WaitPolicy getWaitPolicy() { return wait_policy_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the time spent in each phase of PortHandler::waitPort()
+  /// @return statistics accumulated since the last PortHandler::resetWaitStatistics()
+  ////////////////////////////////////////////////////////////////////////////////
+  WaitStatistics getWaitStatistics() { return wait_statistics_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that clears the statistics returned by PortHandler::getWaitStatistics()
+  ////////////////////////////////////////////////////////////////////////////////
+  void    resetWaitStatistics();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that tells the port which Mercury answers the packet being awaited
+  /// @description The function selects the return delay used to place the spin window of WAIT_HYBRID,
+  /// @description and the servo whose return delay is measured when the first byte of the status packet arrives.
+  /// @param id Mercury ID
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setResponderId(uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that seeds the return delay of a Mercury
+  /// @description The value is refined by measurement afterwards. It is the time from the end of the instruction packet
+  /// @description on the wire until the first byte of the status packet can be read.
+  /// @param id Mercury ID
+  /// @param msec Return delay in milliseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setReturnDelayTime(uint8_t id, double msec);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the measured return delay of a Mercury
+  /// @param id Mercury ID
+  /// @return Return delay in milliseconds
+  /// @return or a negative value when the delay has not been measured yet
+  ////////////////////////////////////////////////////////////////////////////////
+  double  getReturnDelayTime(uint8_t id) { return return_delay_[id]; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that records every byte written to and read from the port
+  /// @description The bytes are recorded by PortHandler::writePort() and PortHandler::readPort() with the time of the port.
+  /// @param recorder Recorder, which has to outlive the port (0 to stop recording)
+  /// @param channel Channel which tells the records of the port apart from those of other ports sharing the recorder
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setRecorder(TrafficRecorder *recorder, uint8_t channel = 0) { recorder_ = recorder; recorder_channel_ = channel; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the recorder of the port
+  /// @return the recorder set by PortHandler::setRecorder(), or 0
+  ////////////////////////////////////////////////////////////////////////////////
+  TrafficRecorder *getRecorder() { return recorder_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that measures the transactions on the port
+  /// @description The packet handlers time every transaction and count its failures and bytes, see TransactionMetrics.
+  /// @param metrics Metrics of this port only, which have to outlive it (0 to stop measuring)
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setMetrics(TransactionMetrics *metrics) { metrics_ = metrics; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the metrics of the port
+  /// @return the metrics set by PortHandler::setMetrics(), or 0
+  ////////////////////////////////////////////////////////////////////////////////
+  TransactionMetrics *getMetrics() { return metrics_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that moves every byte available on the port into the receive buffer
+  /// @description The function calls PortHandler::readPort() once with all free space of the receive buffer,
+  /// @description so bytes of several status packets are collected with a single system call.
+  /// @return Number of bytes added to the receive buffer
+  ////////////////////////////////////////////////////////////////////////////////
+  int     fillRxBuffer();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the first unconsumed byte in the receive buffer
+  /// @description The pointer is valid until the next call of PortHandler::fillRxBuffer().
+  /// @return Pointer to the unconsumed bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t *getRxData() { return &rx_buffer_[rx_begin_]; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns how many unconsumed bytes are in the receive buffer
+  /// @return Number of unconsumed bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getRxLength() { return rx_end_ - rx_begin_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that marks bytes at the front of the receive buffer as consumed
+  /// @param length Number of bytes consumed
+  ////////////////////////////////////////////////////////////////////////////////
+  void    consumeRx(int length) { rx_begin_ += length; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that discards every byte in the receive buffer
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clearRxBuffer() { rx_begin_ = rx_end_ = 0; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the buffer instruction packets are built in
+  /// @description The buffer is owned by the port and holds TX_PACKET_LENGTH_ bytes, so that sending a packet
+  /// @description needs no allocation. It may only be used while the port is in use by the caller.
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t *getTxPacket() { return tx_packet_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the buffer status packets are assembled in
+  /// @description The buffer is owned by the port and holds RX_PACKET_LENGTH_ bytes.
+  /// @description Like the instruction buffer, it may only be used while the port is in use by the caller.
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t *getRxPacket() { return rx_packet_; }
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that opens the port
   /// @description The function calls PortHandlerLinux::setBaudRate() to open the port.
@@ -82,7 +231,7 @@ class WINDECLSPEC PortHandler
 
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that clears the port
-  /// @description The function clears the port.
+  /// @description The function clears the port and discards the bytes left in the receive buffer.
   ////////////////////////////////////////////////////////////////////////////////
   virtual void    clearPort() = 0;
 
@@ -149,6 +298,16 @@ class WINDECLSPEC PortHandler
   ////////////////////////////////////////////////////////////////////////////////
   virtual int     writePort(uint8_t *packet, int length) = 0;
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that waits until bytes arrive in the port buffer
+  /// @description The function puts the calling thread to sleep until bytes are able to be read from the port buffer
+  /// @description or the packet timeout set by PortHandler::setPacketTimeout() expires, whichever comes first.
+  /// @return true
+  /// @return   when bytes are able to be read from the port buffer
+  /// @return or false
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual bool    waitPort() = 0;
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that sets and starts stopwatch for watching packet timeout
   /// @description The function sets the stopwatch by getting current time and the time of packet timeout with packet_length.
@@ -168,6 +327,58 @@ class WINDECLSPEC PortHandler
   /// @description The function checks whether current time is passed by the time of packet timeout from the time set by PortHandlerLinux::setPacketTimeout().
   ////////////////////////////////////////////////////////////////////////////////
   virtual bool    isPacketTimeout() = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the time at which the packet timeout expires
+  /// @return time on the MonotonicClock in nanoseconds,
+  /// @return   or on the clock of the port when PortHandler::isClockVirtual() returns true
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int64_t getPacketDeadline() = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the descriptor of the open port, for waiting on it together with other descriptors
+  /// @return file descriptor which becomes readable when bytes arrive
+  /// @return or -1 when the port isn't open or the platform has no such descriptor
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int     getPortDescriptor() = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether the port keeps a clock of its own, which only moves in PortHandler::waitPort()
+  /// @description PortHandler::waitPort() of such a port returns at once, after moving its clock to the next bytes or the packet timeout.
+  /// @return false
+  /// @return   when the port runs on the MonotonicClock
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual bool    isClockVirtual() { return false; }
+
+ protected:
+  PortHandler();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that feeds a measured return delay of the current responder into its estimate
+  /// @param msec Time from the end of the instruction packet until the first status byte was read
+  ////////////////////////////////////////////////////////////////////////////////
+  void    updateReturnDelay(double msec);
+
+  WaitPolicy      wait_policy_;
+  WaitStatistics  wait_statistics_;
+
+  TrafficRecorder *recorder_;
+  uint8_t         recorder_channel_;
+
+  TransactionMetrics *metrics_;
+
+  uint8_t responder_id_;
+  bool    is_awaiting_response_;      ///< true until the first status byte for responder_id_ has been read
+  double  return_delay_[256];         ///< smoothed return delay per ID (msec), negative when unknown
+  double  return_delay_jitter_[256];  ///< smoothed absolute deviation of return_delay_ (msec)
+
+  uint8_t rx_buffer_[RX_BUFFER_LENGTH_];
+  int     rx_begin_;                  ///< index of the first unconsumed byte in rx_buffer_
+  int     rx_end_;                    ///< index one past the last received byte in rx_buffer_
+
+  uint8_t tx_packet_[TX_PACKET_LENGTH_];
+  uint8_t rx_packet_[RX_PACKET_LENGTH_];
 };
 
 }
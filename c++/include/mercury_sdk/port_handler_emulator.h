@@ -0,0 +1,144 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_PORTHANDLEREMULATOR_H_
+#define INCLUDE_MERCURY_SDK_PORTHANDLEREMULATOR_H_
+
+#include "bus_emulator.h"
+#include "port_handler_scheduled.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for a port connected to a bus of emulated Mercurys, for running the SDK without hardware
+/// @description Every byte takes 10 bit times at the baudrate of the port, and each status packet starts after the
+/// @description return delay of its Mercury, so a transaction lasts as long as on a real bus, apart from the USB latency.
+/// @description With CLOCK_REAL the bytes arrive on the MonotonicClock and waitPort() sleeps until they do.
+/// @description With CLOCK_VIRTUAL the port keeps its own clock, which jumps to the end of the next burst of bytes in waitPort(),
+/// @description so a run takes no time and its results and timings are exactly the same on every machine.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC PortHandlerEmulator : public PortHandlerScheduled
+{
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The clock the bytes on the emulated bus are timed with
+  ////////////////////////////////////////////////////////////////////////////////
+  enum ClockMode
+  {
+    CLOCK_REAL    = 0,  ///< the MonotonicClock
+    CLOCK_VIRTUAL = 1   ///< a clock of the port, which only moves with the bytes on the bus
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the port with an empty bus
+  /// @param port_name Port name, only returned by PortHandlerEmulator::getPortName()
+  /// @param clock_mode CLOCK_REAL or CLOCK_VIRTUAL
+  ////////////////////////////////////////////////////////////////////////////////
+  PortHandlerEmulator(const char *port_name, ClockMode clock_mode = CLOCK_REAL);
+
+  virtual ~PortHandlerEmulator() { closePort(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the bus behind the port, to add Mercurys to it and look at their control tables
+  /// @return the bus, owned by the port
+  ////////////////////////////////////////////////////////////////////////////////
+  BusEmulator *getBus() { return &bus_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the clock mode of the port
+  ////////////////////////////////////////////////////////////////////////////////
+  ClockMode getClockMode() { return clock_mode_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that opens the port
+  /// @return true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    openPort();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that closes the port
+  /// @description The bytes still on the bus are dropped.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    closePort();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets port name into the port handler
+  /// @param port_name Port name
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setPortName(const char *port_name);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns port name set into the port handler
+  /// @return Port name
+  ////////////////////////////////////////////////////////////////////////////////
+  char   *getPortName();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets baudrate into the port handler
+  /// @description Any baudrate is accepted. Only the Mercurys set to the same baudrate answer.
+  /// @param baudrate Baudrate
+  /// @return true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    setBaudRate(const int baudrate);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns current baudrate set into the port handler
+  /// @return Baudrate
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getBaudRate();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that writes bytes on the port buffer
+  /// @description The bytes reach the Mercurys at the end of their time on the wire, and the status packets are
+  /// @description scheduled from there. With CLOCK_VIRTUAL the clock moves to the end of the bytes, as tcdrain() would.
+  /// @param packet Buffer which would be written on the port buffer
+  /// @param length Length of the buffer for write
+  /// @return -1
+  /// @return   when the port isn't open
+  /// @return or Length of bytes written
+  ////////////////////////////////////////////////////////////////////////////////
+  int     writePort(uint8_t *packet, int length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets and starts stopwatch for watching packet timeout
+  /// @description The timeout starts when the last byte written leaves the wire.
+  /// @param packet_length Length of the packet expected to be received
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setPacketTimeout(uint16_t packet_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets and starts stopwatch for watching packet timeout
+  /// @description The timeout starts when the last byte written leaves the wire.
+  /// @param msec Timeout in milliseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setPacketTimeout(double msec);
+
+ private:
+  BusEmulator bus_;
+  ClockMode   clock_mode_;
+  int         baudrate_;
+  char        port_name_[100];
+
+  double      tx_time_per_byte;   ///< msec
+  int64_t     byte_time_;         ///< nsec per byte on the wire
+  int64_t     bus_free_time_;     ///< time at which the last status byte scheduled has arrived (nsec)
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_PORTHANDLEREMULATOR_H_ */
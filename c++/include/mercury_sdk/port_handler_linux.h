@@ -40,16 +40,20 @@ class PortHandlerLinux : public PortHandler
   int     baudrate_;
   char    port_name_[100];
 
-  double  packet_start_time_;
-  double  packet_timeout_;
+  int64_t packet_deadline_; ///< monotonic time at which the packet timeout expires (nsec)
   double  tx_time_per_byte;
+  int64_t tx_end_time_;     ///< monotonic time at which the last written byte leaves the wire (nsec)
+  int     latency_timer_;   ///< USB latency timer in effect (msec)
 
   bool    setupPort(const int cflag_baud);
   bool    setCustomBaudrate(int speed);
   int     getCFlagBaud(const int baudrate);
 
-  double  getCurrentTime();
-  double  getTimeSinceStart();
+  void    setupLowLatency();
+  int     readLatencyTimer(const char *sysfs_path);
+
+  bool    pollPort(int64_t nsec);
+  void    getSpinWindow(int64_t now, int64_t *window_start, int64_t *window_end);
 
  public:
   ////////////////////////////////////////////////////////////////////////////////
@@ -114,6 +118,14 @@ class PortHandlerLinux : public PortHandler
   ////////////////////////////////////////////////////////////////////////////////
   int     getBaudRate();
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the USB latency timer in effect for the port
+  /// @description The value is read from sysfs when the port is opened, after trying to lower it to 1 msec,
+  /// @description and is used by PortHandlerLinux::setPacketTimeout().
+  /// @return Latency timer in milliseconds (0 when the port is not a usb serial adapter)
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getLatencyTimer() { return latency_timer_; }
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that checks how much bytes are able to be read from the port buffer
   /// @description The function checks how much bytes are able to be read from the port buffer
@@ -146,16 +158,28 @@ class PortHandlerLinux : public PortHandler
   ////////////////////////////////////////////////////////////////////////////////
   int     writePort(uint8_t *packet, int length);
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that waits until bytes arrive in the port buffer
+  /// @description The function waits according to the wait policy until the port becomes readable
+  /// @description or the packet timeout set by PortHandlerLinux::setPacketTimeout() expires, whichever comes first.
+  /// @description WAIT_BLOCK sleeps in ppoll(), WAIT_SPIN polls without sleeping, and WAIT_HYBRID sleeps until
+  /// @description the window around the expected arrival of the status packet, spins through it, then sleeps again.
+  /// @return true
+  /// @return   when bytes are able to be read from the port buffer
+  /// @return or false
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    waitPort();
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that sets and starts stopwatch for watching packet timeout
-  /// @description The function sets the stopwatch by getting current time and the time of packet timeout with packet_length.
+  /// @description The function sets the packet deadline on the MonotonicClock from the time of packet timeout with packet_length.
   /// @param packet_length Length of the packet expected to be received
   ////////////////////////////////////////////////////////////////////////////////
   void    setPacketTimeout(uint16_t packet_length);
 
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that sets and starts stopwatch for watching packet timeout
-  /// @description The function sets the stopwatch by getting current time and the time of packet timeout with msec.
+  /// @description The function sets the packet deadline on the MonotonicClock from the time of packet timeout with msec.
   /// @param packet_length Length of the packet expected to be received
   ////////////////////////////////////////////////////////////////////////////////
   void    setPacketTimeout(double msec);
@@ -165,6 +189,16 @@ class PortHandlerLinux : public PortHandler
   /// @description The function checks whether current time is passed by the time of packet timeout from the time set by PortHandlerLinux::setPacketTimeout().
   ////////////////////////////////////////////////////////////////////////////////
   bool    isPacketTimeout();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the time at which the packet timeout expires
+  ////////////////////////////////////////////////////////////////////////////////
+  int64_t getPacketDeadline() { return packet_deadline_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the file descriptor of the serial port
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getPortDescriptor() { return socket_fd_; }
 };
 
 }
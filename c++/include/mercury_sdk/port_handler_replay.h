@@ -0,0 +1,199 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_PORTHANDLERREPLAY_H_
+#define INCLUDE_MERCURY_SDK_PORTHANDLERREPLAY_H_
+
+#include <vector>
+
+#include "port_handler_scheduled.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for a port which answers from a capture file written by the TrafficRecorder
+/// @description The capture is cut into exchanges: the bytes of one write to the port, followed by every read until the next write.
+/// @description When the SDK writes the same bytes as the next exchange, the bytes read in the capture arrive again, in the same
+/// @description chunks and at the same delay after the write, corrupt and partial packets included. A write which differs is
+/// @description looked for among the next exchanges, and left unanswered when it isn't found, so that the SDK times out.
+/// @description With REPLAY_TIMED the bytes arrive on the MonotonicClock. With REPLAY_FAST the port keeps its own clock,
+/// @description which jumps to the next chunk in waitPort(), so a replay runs as fast as the SDK and is the same on every run.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC PortHandlerReplay : public PortHandlerScheduled
+{
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The clock the recorded bytes are replayed with
+  ////////////////////////////////////////////////////////////////////////////////
+  enum ReplayMode
+  {
+    REPLAY_TIMED  = 0,  ///< the MonotonicClock, waitPort() waits as long as the capture did
+    REPLAY_FAST   = 1   ///< a clock of the port, which only moves in waitPort()
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the port without a capture
+  /// @param port_name Port name, only returned by PortHandlerReplay::getPortName()
+  /// @param replay_mode REPLAY_TIMED or REPLAY_FAST
+  ////////////////////////////////////////////////////////////////////////////////
+  PortHandlerReplay(const char *port_name, ReplayMode replay_mode = REPLAY_FAST);
+
+  virtual ~PortHandlerReplay() { closePort(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that loads the records of one channel from a capture file
+  /// @description The records end at the first one which was not complete when the file was closed.
+  /// @description Bytes read before the first write of the channel are skipped. The replay starts from the first exchange.
+  /// @param path Path of the capture file
+  /// @param channel Channel of the port in the capture, see PortHandler::setRecorder()
+  /// @return false
+  /// @return   when the file cannot be read or isn't a capture file of TrafficRecorder::VERSION_
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    loadCapture(const char *path, uint8_t channel = 0);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that restarts the replay from the first exchange and clears its counters
+  ////////////////////////////////////////////////////////////////////////////////
+  void    rewind();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of exchanges loaded
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getExchangeCount() { return (int)exchanges_.size(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the index of the next exchange expected to be written
+  /// @return index, which equals PortHandlerReplay::getExchangeCount() at the end of the capture
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getPosition() { return position_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of writes which matched no exchange since the last rewind
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getMismatchCount() { return mismatch_count_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of exchanges passed over to match a write since the last rewind
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getSkippedCount() { return skipped_count_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the replay mode of the port
+  ////////////////////////////////////////////////////////////////////////////////
+  ReplayMode getReplayMode() { return replay_mode_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that opens the port
+  /// @return true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    openPort();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that closes the port
+  /// @description The bytes which have not been read are dropped. The position in the capture is kept.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    closePort();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets port name into the port handler
+  /// @param port_name Port name
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setPortName(const char *port_name);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns port name set into the port handler
+  /// @return Port name
+  ////////////////////////////////////////////////////////////////////////////////
+  char   *getPortName();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets baudrate into the port handler
+  /// @description The capture keeps no baudrate, it only sets the packet timeouts. Use the baudrate of the recorded port.
+  /// @param baudrate Baudrate
+  /// @return true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    setBaudRate(const int baudrate);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns current baudrate set into the port handler
+  /// @return Baudrate
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getBaudRate();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that writes bytes on the port buffer
+  /// @description The bytes are matched against the next exchanges of the capture, and the bytes read in the matching one
+  /// @description are scheduled after the write. Bytes of the previous exchange still on their way are dropped, since
+  /// @description the capture holds every byte in the exchange during which it was read.
+  /// @param packet Buffer which would be written on the port buffer
+  /// @param length Length of the buffer for write
+  /// @return -1
+  /// @return   when the port isn't open
+  /// @return or Length of bytes written
+  ////////////////////////////////////////////////////////////////////////////////
+  int     writePort(uint8_t *packet, int length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets and starts stopwatch for watching packet timeout
+  /// @description The timeout is the one of PortHandlerLinux with the default latency timer.
+  /// @param packet_length Length of the packet expected to be received
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setPacketTimeout(uint16_t packet_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that sets and starts stopwatch for watching packet timeout
+  /// @param msec Timeout in milliseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setPacketTimeout(double msec);
+
+ private:
+  struct Exchange
+  {
+    uint64_t  tx_offset;  ///< offset of the written bytes in data_
+    uint16_t  tx_length;
+    uint32_t  rx_begin;   ///< index of the first chunk read in chunks_
+    uint32_t  rx_end;     ///< index one past the last chunk read in chunks_
+  };
+
+  struct Chunk
+  {
+    uint64_t  offset;     ///< offset of the bytes in data_
+    uint16_t  length;
+    int64_t   delay;      ///< time from the write until the bytes were read (nsec)
+  };
+
+  int     findExchange(const uint8_t *packet, int length);
+
+  ReplayMode  replay_mode_;
+  int         baudrate_;
+  char        port_name_[100];
+
+  std::vector<uint8_t>  data_;        ///< bytes of every record loaded
+  std::vector<Exchange> exchanges_;
+  std::vector<Chunk>    chunks_;
+  int                   position_;
+  int                   mismatch_count_;
+  int                   skipped_count_;
+
+  double      tx_time_per_byte;   ///< msec
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_PORTHANDLERREPLAY_H_ */
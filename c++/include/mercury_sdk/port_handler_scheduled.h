@@ -0,0 +1,141 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_PORTHANDLERSCHEDULED_H_
+#define INCLUDE_MERCURY_SDK_PORTHANDLERSCHEDULED_H_
+
+#include <vector>
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The base class for ports without a device, whose bytes are scheduled to arrive at given times
+/// @description The derived class schedules the bytes answering each write, PortHandlerScheduled makes them arrive.
+/// @description On the MonotonicClock, waitPort() sleeps, or spins with WAIT_SPIN, until the next byte arrives or the packet timeout expires.
+/// @description On a virtual clock the port keeps its own clock, which jumps to the next bytes or past the deadline in waitPort(),
+/// @description so a run takes no time and is the same on every machine.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC PortHandlerScheduled : public PortHandler
+{
+ public:
+  virtual ~PortHandlerScheduled() { }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the current time of the port
+  /// @return MonotonicClock::getTime()
+  /// @return or the time of the virtual clock in nanoseconds, which starts at 0
+  ////////////////////////////////////////////////////////////////////////////////
+  int64_t getTime();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that clears the port
+  /// @description The function discards the bytes which have arrived. Bytes still on their way arrive later, as on a serial port.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clearPort();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks how much bytes are able to be read from the port buffer
+  /// @return Number of bytes which have arrived and were not read yet
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getBytesAvailable();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that reads bytes from the port buffer
+  /// @param packet Buffer for the packet received
+  /// @param length Length of the buffer for read
+  /// @return -1
+  /// @return   when the port isn't open
+  /// @return or Length of bytes read
+  ////////////////////////////////////////////////////////////////////////////////
+  int     readPort(uint8_t *packet, int length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that waits until bytes arrive in the port buffer
+  /// @description On a virtual clock the clock jumps to whichever comes first, to the last of the bytes which follow
+  /// @description each other within PortHandlerScheduled::rx_burst_gap_.
+  /// @return true
+  /// @return   when bytes are able to be read from the port buffer
+  /// @return or false
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    waitPort();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether packet timeout is occurred
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isPacketTimeout();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the time at which the packet timeout expires
+  /// @description The time is on the clock of the port, see PortHandlerScheduled::getTime().
+  ////////////////////////////////////////////////////////////////////////////////
+  int64_t getPacketDeadline() { return packet_deadline_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns -1, since no descriptor becomes readable with the bytes of the port
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getPortDescriptor() { return -1; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether the port runs on a virtual clock
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isClockVirtual() { return is_clock_virtual_; }
+
+ protected:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the port without bytes
+  /// @param is_clock_virtual Whether the port keeps a clock of its own instead of the MonotonicClock
+  ////////////////////////////////////////////////////////////////////////////////
+  PortHandlerScheduled(bool is_clock_virtual);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that schedules bytes, which arrive together at the given time
+  /// @description Bytes are scheduled in the order they arrive.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    scheduleRx(const uint8_t *data, int length, int64_t time);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that drops the bytes which have not arrived by the given time
+  ////////////////////////////////////////////////////////////////////////////////
+  void    dropPending(int64_t now);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that drops every byte scheduled
+  ////////////////////////////////////////////////////////////////////////////////
+  void    dropAll();
+
+  bool        is_open_;
+  int64_t     virtual_time_;      ///< time of the virtual clock (nsec)
+  int64_t     tx_end_time_;       ///< time at which the last written byte leaves the wire (nsec)
+  int64_t     packet_deadline_;
+  int64_t     rx_burst_gap_;      ///< bytes which arrive closer together are read at once on the virtual clock (nsec)
+
+ private:
+  int     getArrivedCount(int64_t now);
+
+  bool        is_clock_virtual_;
+
+  std::vector<uint8_t>  rx_data_;   ///< bytes scheduled on the port
+  std::vector<int64_t>  rx_time_;   ///< time at which each byte of rx_data_ arrives
+  uint32_t              rx_read_;   ///< index of the first byte of rx_data_ not read yet
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_PORTHANDLERSCHEDULED_H_ */
@@ -39,20 +39,15 @@ class WINDECLSPEC PortHandlerWindows : public PortHandler
 {
  private:
   HANDLE  serial_handle_;
-  LARGE_INTEGER freq_, counter_;
 
   int     baudrate_;
   char    port_name_[100];
 
-  double  packet_start_time_;
-  double  packet_timeout_;
+  int64_t packet_deadline_; ///< monotonic time at which the packet timeout expires (nsec)
   double  tx_time_per_byte_;
 
   bool    setupPort(const int baudrate);
 
-  double  getCurrentTime();
-  double  getTimeSinceStart();
-
  public:
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that initializes instance of PortHandler and gets port_name
@@ -148,16 +143,25 @@ class WINDECLSPEC PortHandlerWindows : public PortHandler
   ////////////////////////////////////////////////////////////////////////////////
   int     writePort(uint8_t *packet, int length);
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that waits until bytes arrive in the port buffer
+  /// @description The function yields the rest of the time slice unless the wait policy is WAIT_SPIN.
+  /// @description ReadFile() already waits up to ReadTotalTimeoutConstant for the first byte,
+  /// @description so WAIT_HYBRID behaves like WAIT_BLOCK on Windows.
+  /// @return true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    waitPort();
+
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that sets and starts stopwatch for watching packet timeout
-  /// @description The function sets the stopwatch by getting current time and the time of packet timeout with packet_length.
+  /// @description The function sets the packet deadline on the MonotonicClock from the time of packet timeout with packet_length.
   /// @param packet_length Length of the packet expected to be received
   ////////////////////////////////////////////////////////////////////////////////
   void    setPacketTimeout(uint16_t packet_length);
 
   ////////////////////////////////////////////////////////////////////////////////
   /// @brief The function that sets and starts stopwatch for watching packet timeout
-  /// @description The function sets the stopwatch by getting current time and the time of packet timeout with msec.
+  /// @description The function sets the packet deadline on the MonotonicClock from the time of packet timeout with msec.
   /// @param packet_length Length of the packet expected to be received
   ////////////////////////////////////////////////////////////////////////////////
   void    setPacketTimeout(double msec);
@@ -167,6 +171,16 @@ class WINDECLSPEC PortHandlerWindows : public PortHandler
   /// @description The function checks whether current time is passed by the time of packet timeout from the time set by PortHandlerWindows::setPacketTimeout().
   ////////////////////////////////////////////////////////////////////////////////
   bool    isPacketTimeout();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the time at which the packet timeout expires
+  ////////////////////////////////////////////////////////////////////////////////
+  int64_t getPacketDeadline() { return packet_deadline_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns -1, the serial handle can't be waited on together with file descriptors
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getPortDescriptor() { return -1; }
 };
 
 }
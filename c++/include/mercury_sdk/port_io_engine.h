@@ -0,0 +1,204 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_PORTIOENGINE_H_
+#define INCLUDE_MERCURY_SDK_PORTIOENGINE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "port_handler.h"
+#include "packet_handler.h"
+
+namespace mercury
+{
+
+class IoQueue;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The base class for the transactions run by a PortIoEngine
+/// @description A transaction is linked into the queues by itself, so submitting it allocates nothing.
+/// @description It must stay alive until it comes out of its completion queue, and can be submitted again after that.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC IoTransaction
+{
+  friend class IoQueue;
+  friend class PortIoEngine;
+
+ private:
+  std::atomic<IoTransaction *> next_;
+  IoQueue *completion_queue_;
+  int      result_;
+
+ public:
+  IoTransaction() : next_(0), completion_queue_(0), result_(COMM_NOT_AVAILABLE) { }
+  virtual ~IoTransaction() { }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that runs the transaction on the I/O thread of the engine
+  /// @description The function may call any function of PacketHandler or of a group bound to the port.
+  /// @param port PortHandler of the engine
+  /// @param ph PacketHandler of the engine
+  /// @return communication result of the transaction
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual int execute(PortHandler *port, PacketHandler *ph) = 0;
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that is called on the I/O thread when the transaction is done
+  /// @description The function is called after IoTransaction::execute(), before the transaction is posted to its completion queue.
+  /// @description When the transaction has no completion queue, the engine doesn't touch it after the function returns.
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual void onComplete() { }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the result of the last execution
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when the transaction has not been executed yet
+  /// @return or the result of IoTransaction::execute()
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getResult() { return result_; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for a queue of transactions with many producers and a single consumer
+/// @description Pushing is wait-free and popping is lock-free. The consumer only takes a mutex
+/// @description when it goes to sleep in IoQueue::wait() on an empty queue.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC IoQueue
+{
+ private:
+  class Stub : public IoTransaction
+  {
+   public:
+    int execute(PortHandler *, PacketHandler *) { return COMM_SUCCESS; }
+  };
+
+  std::atomic<IoTransaction *> head_;   // last pushed
+  IoTransaction *tail_;                 // next to pop, owned by the consumer
+  Stub           stub_;
+
+  std::atomic<bool>       is_waiting_;
+  std::mutex              mutex_;
+  std::condition_variable condition_;
+
+  void    link(IoTransaction *transaction);
+
+ public:
+  IoQueue();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that adds a transaction to the queue, from any thread
+  /// @param transaction Transaction which isn't in any queue
+  ////////////////////////////////////////////////////////////////////////////////
+  void    push(IoTransaction *transaction);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that takes the oldest transaction from the queue, from the consumer thread only
+  /// @return The transaction
+  /// @return or NULL when the queue is empty
+  ////////////////////////////////////////////////////////////////////////////////
+  IoTransaction *pop();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that takes the oldest transaction from the queue, waiting for one if the queue is empty
+  /// @description The function is called from the consumer thread only.
+  /// @param msec Longest time to wait in milliseconds, a negative value waits until a transaction arrives
+  /// @return The transaction
+  /// @return or NULL when the time ran out
+  ////////////////////////////////////////////////////////////////////////////////
+  IoTransaction *wait(double msec);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that runs the transactions of one port on a dedicated I/O thread
+/// @description Application threads submit transactions from anywhere. The I/O thread executes them one after another
+/// @description and posts each one to the completion queue given with it. The engine holds the port only while a transaction runs:
+/// @description a PacketHandler call made from another thread on the same port runs between two transactions or gets COMM_PORT_BUSY,
+/// @description and a transaction which finds the port held by such a call is done with COMM_PORT_BUSY. Neither corrupts the other.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC PortIoEngine
+{
+ private:
+  class Stop : public IoTransaction
+  {
+   public:
+    int execute(PortHandler *, PacketHandler *) { return COMM_SUCCESS; }
+  };
+
+  PortHandler   *port_;
+  PacketHandler *ph_;
+
+  IoQueue       submission_queue_;
+  Stop          stop_;
+  std::thread   thread_;
+  std::atomic<bool> is_running_;
+  std::atomic<int>  submitting_count_;  // submit() calls which may still push
+
+  void    run();
+  void    complete(IoTransaction *transaction);
+
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the engine for an open port
+  /// @param port PortHandler instance
+  /// @param ph PacketHandler instance
+  ////////////////////////////////////////////////////////////////////////////////
+  PortIoEngine(PortHandler *port, PacketHandler *ph);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that calls PortIoEngine::stop()
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual ~PortIoEngine() { stop(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts the I/O thread
+  /// @return false
+  /// @return   when the engine runs already
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    start();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that stops the I/O thread
+  /// @description The transactions submitted before are executed first. The function returns when the thread has ended.
+  /// @description A transaction submitted during or after the call is not executed, but completed with COMM_NOT_AVAILABLE.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    stop();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether the I/O thread runs
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isRunning() { return is_running_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that submits a transaction to the I/O thread, from any thread
+  /// @description When the engine doesn't run, the transaction is completed at once on the calling thread with COMM_NOT_AVAILABLE:
+  /// @description IoTransaction::onComplete() is called and the transaction is posted to its completion queue.
+  /// @param transaction Transaction which isn't in any queue
+  /// @param completion_queue Queue the transaction is posted to when it is done, or NULL
+  ////////////////////////////////////////////////////////////////////////////////
+  void    submit(IoTransaction *transaction, IoQueue *completion_queue);
+
+  PortHandler   *getPortHandler()   { return port_; }
+  PacketHandler *getPacketHandler() { return ph_; }
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_PORTIOENGINE_H_ */
@@ -0,0 +1,131 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_PREPAREDPACKET_H_
+#define INCLUDE_MERCURY_SDK_PREPAREDPACKET_H_
+
+#include <vector>
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that keeps an instruction packet framed for transmission
+/// @description The packet is built once with its header, byte stuffing and CRC16, then sent as it is by
+/// @description PacketHandler::txPreparedPacket() as often as needed. Changing some of its parameter bytes
+/// @description corrects the CRC16 from the changed bytes alone, unless byte stuffing is involved.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC PreparedPacket
+{
+ private:
+  std::vector<uint8_t> packet_;   ///< framed packet
+  std::vector<uint8_t> param_;    ///< parameter before byte stuffing
+  uint16_t packet_length_;
+  uint16_t rx_length_;
+  uint8_t  id_;
+  uint8_t  instruction_;
+  bool     is_stuffed_;           ///< whether the packet holds stuffed bytes
+
+  int     frame();
+
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes an empty prepared packet
+  ////////////////////////////////////////////////////////////////////////////////
+  PreparedPacket();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that frames an instruction packet
+  /// @param id Mercury ID or BROADCAST_ID
+  /// @param instruction Instruction of the packet
+  /// @param param Parameter of the packet
+  /// @param param_length Length of the parameter
+  /// @param rx_length Length of the answer for PortHandler::setPacketTimeout(), or 0 when no status packet is expected
+  /// @return COMM_TX_ERROR
+  /// @return   when the packet is longer than PortHandler::TX_PACKET_LENGTH_
+  /// @return or COMM_SUCCESS
+  ////////////////////////////////////////////////////////////////////////////////
+  int     prepare         (uint8_t id, uint8_t instruction, const uint8_t *param, uint16_t param_length, uint16_t rx_length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that frames an INST_PING instruction packet
+  /// @param id Mercury ID
+  /// @return communication results which come from PreparedPacket::prepare()
+  ////////////////////////////////////////////////////////////////////////////////
+  int     preparePing     (uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that frames an INST_READ instruction packet, the answer is received by PacketHandler::readRx()
+  /// @param id Mercury ID
+  /// @param address Address of the data for read
+  /// @param length Length of the data for read
+  /// @return communication results which come from PreparedPacket::prepare()
+  ////////////////////////////////////////////////////////////////////////////////
+  int     prepareRead     (uint8_t id, uint16_t address, uint16_t length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that frames an INST_SYNC_READ instruction packet, the answer is received by PacketHandler::syncReadRx()
+  /// @param start_address Address of the data for Sync Read
+  /// @param data_length Length of the data for Sync Read
+  /// @param id_list IDs of the Mercurys
+  /// @param id_count Number of IDs
+  /// @return communication results which come from PreparedPacket::prepare()
+  ////////////////////////////////////////////////////////////////////////////////
+  int     prepareSyncRead (uint16_t start_address, uint16_t data_length, const uint8_t *id_list, uint16_t id_count);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that frames an INST_FAST_SYNC_READ instruction packet, the answer is received by PacketHandler::fastSyncReadRx()
+  /// @param start_address Address of the data for Fast Sync Read
+  /// @param data_length Length of the data for Fast Sync Read
+  /// @param id_list IDs of the Mercurys
+  /// @param id_count Number of IDs
+  /// @return COMM_TX_ERROR
+  /// @return   when the answer would be longer than PortHandler::RX_PACKET_LENGTH_
+  /// @return or communication results which come from PreparedPacket::prepare()
+  ////////////////////////////////////////////////////////////////////////////////
+  int     prepareFastSyncRead (uint16_t start_address, uint16_t data_length, const uint8_t *id_list, uint16_t id_count);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that changes bytes of the parameter of the prepared packet
+  /// @description The CRC16 is corrected from the changed bytes. When the packet holds stuffed bytes,
+  /// @description or the new bytes need byte stuffing, the packet is framed again.
+  /// @param offset Offset of the bytes in the parameter
+  /// @param data New bytes
+  /// @param length Number of bytes
+  /// @return COMM_NOT_AVAILABLE
+  /// @return   when no packet is prepared or the bytes are out of the parameter
+  /// @return or communication results which come from PreparedPacket::prepare()
+  ////////////////////////////////////////////////////////////////////////////////
+  int     changeParam     (uint16_t offset, const uint8_t *data, uint16_t length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that forgets the prepared packet
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clear           () { packet_length_ = 0; }
+
+  bool      isPrepared      () { return packet_length_ > 0; }
+  uint8_t   getId           () { return id_; }
+  uint8_t   getInstruction  () { return instruction_; }
+  uint8_t  *getPacket       () { return &packet_[0]; }
+  uint16_t  getPacketLength () { return packet_length_; }
+  uint16_t  getRxLength     () { return rx_length_; }
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_PREPAREDPACKET_H_ */
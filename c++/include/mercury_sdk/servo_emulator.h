@@ -0,0 +1,188 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_SERVOEMULATOR_H_
+#define INCLUDE_MERCURY_SDK_SERVOEMULATOR_H_
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class for the control table of one emulated Mercury
+/// @description The control table holds the EEPROM area below ADDR_CONTROL_ENABLE, which survives a reboot,
+/// @description and the RAM area from ADDR_CONTROL_ENABLE on, which a reboot sets back to its defaults.
+/// @description The EEPROM area can only be written while the torque is disabled, as on the servo.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC ServoEmulator
+{
+ public:
+  static const int      CONTROL_TABLE_SIZE_   = 256;    ///< Size of the control table
+  static const uint16_t DEFAULT_MODEL_NUMBER_ = 0x0430; ///< Model number of an emulated Mercury
+  static const uint8_t  FIRMWARE_VERSION_     = 1;      ///< Firmware version of an emulated Mercury
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The control table addresses known to the emulator
+  ////////////////////////////////////////////////////////////////////////////////
+  enum Address
+  {
+    ADDR_MODEL_NUMBER       = 0x00, ///< 2 bytes, read only
+    ADDR_FIRMWARE_VERSION   = 0x02, ///< read only
+    ADDR_ID                 = 0x03,
+    ADDR_BAUDRATE           = 0x04, ///< 0: 9600, 1: 57600, 2: 115200, 3: 1M, 4: 2M, 5: 3M, 6: 4M, 7: 4.5M
+    ADDR_RETURN_DELAY_TIME  = 0x05, ///< in units of 2 usec, 50 by default
+    ADDR_OPERATING_MODE     = 0x06,
+    ADDR_CONTROL_ENABLE     = 0x30, ///< 1: torque enable, 2: start the synchronisation
+    ADDR_GOAL_POSITION      = 0x4e, ///< 4 bytes
+    ADDR_PRESENT_POSITION   = 0x5a, ///< 4 bytes, read only
+    ADDR_HARDWARE_STATUS    = 0x6b  ///< read only, bit 0x02 is set until the Mercury is synchronised
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the control table of a Mercury with its factory defaults
+  /// @param id Mercury ID
+  /// @param model_number Model number returned by a ping
+  ////////////////////////////////////////////////////////////////////////////////
+  ServoEmulator(uint8_t id, uint16_t model_number = DEFAULT_MODEL_NUMBER_);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the ID in the control table
+  /// @return Mercury ID
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t getId() { return table_[ADDR_ID]; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the model number in the control table
+  /// @return Model number
+  ////////////////////////////////////////////////////////////////////////////////
+  uint16_t getModelNumber();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the baudrate selected in the control table
+  /// @return Baudrate
+  /// @return or 0 when the baudrate number is not valid
+  ////////////////////////////////////////////////////////////////////////////////
+  int     getBaudRate();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the return delay selected in the control table
+  /// @description It is the time from the end of an instruction packet until the status packet starts.
+  /// @return Return delay in microseconds
+  ////////////////////////////////////////////////////////////////////////////////
+  double  getReturnDelayTime() { return table_[ADDR_RETURN_DELAY_TIME] * 2.0; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns whether the torque is enabled
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isTorqueEnabled() { return (table_[ADDR_CONTROL_ENABLE] & 0x01) != 0; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns whether a write is registered and waits for an Action
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isRegistered() { return reg_length_ > 0; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that selects whether the Mercury has to be synchronised after power on
+  /// @description When it is required, ADDR_HARDWARE_STATUS has bit 0x02 set after power on, a reboot or a factory reset,
+  /// @description until 0x02 is written to ADDR_CONTROL_ENABLE, as PacketHandler::synchronise() does.
+  /// @param is_required true when the Mercury needs the synchronisation
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setSynchronisationRequired(bool is_required);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the control table
+  /// @description The bytes can be changed directly, e.g. to inject a present position or an alert.
+  /// @return CONTROL_TABLE_SIZE_ bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t *getControlTable() { return table_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that executes a Read instruction
+  /// @param address Address of the first byte
+  /// @param length Number of bytes
+  /// @param data Buffer for length bytes
+  /// @return Error of the status packet (0 when the bytes were read)
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t read(uint16_t address, uint16_t length, uint8_t *data);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that executes a Write instruction
+  /// @description Nothing is written when a byte is read only, or is in the EEPROM area while the torque is enabled.
+  /// @param address Address of the first byte
+  /// @param length Number of bytes
+  /// @param data Bytes to write
+  /// @return Error of the status packet (0 when the bytes were written)
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t write(uint16_t address, uint16_t length, const uint8_t *data);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that executes a Reg Write instruction
+  /// @description The bytes are written by the next Action instruction. A new Reg Write replaces the registered one.
+  /// @param address Address of the first byte
+  /// @param length Number of bytes
+  /// @param data Bytes to write
+  /// @return Error of the status packet (0 when the bytes were registered)
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t regWrite(uint16_t address, uint16_t length, const uint8_t *data);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that executes an Action instruction
+  /// @return Error of the status packet (0 when the registered bytes were written)
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t action();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that executes a Reboot instruction
+  /// @description The RAM area is set back to its defaults and the registered write is dropped.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    reboot();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that executes a Factory Reset instruction
+  /// @param option 0xFF: reset all values, 0x01: all values except ID, 0x02: all values except ID and baudrate
+  /// @return Error of the status packet (0 when the Mercury was reset)
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t factoryReset(uint8_t option);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that executes a Clear instruction
+  /// @description 01 44 58 4C 22 clears the multi-turn information: the present position is brought into one turn.
+  /// @param param Parameters of the instruction
+  /// @param length Number of parameters
+  /// @return Error of the status packet (0 when the Mercury was cleared)
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t clear(const uint8_t *param, uint16_t length);
+
+ private:
+  void    setDefaults(uint16_t begin, uint16_t end);
+  void    setValue(uint16_t address, uint16_t length, uint32_t value);
+  int32_t getValue(uint16_t address);
+  void    applyWrite(uint16_t address, uint16_t length);
+
+  uint8_t   table_[CONTROL_TABLE_SIZE_];
+  uint16_t  model_number_;
+  bool      is_synchronisation_required_;
+
+  uint16_t  reg_address_;
+  uint16_t  reg_length_;
+  uint8_t   reg_data_[CONTROL_TABLE_SIZE_];
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_SERVOEMULATOR_H_ */
@@ -0,0 +1,144 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_STATUSPACKETPARSER_H_
+#define INCLUDE_MERCURY_SDK_STATUSPACKETPARSER_H_
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that assembles Protocol 2.0 status packets from a byte stream
+/// @description The parser keeps its state between calls, so bytes can be handed over in chunks of any size
+/// @description as they arrive from the port. Header, length and instruction are checked, the CRC is accumulated
+/// @description and byte stuffing is removed while the bytes are copied, so no byte of a valid packet is examined twice.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC StatusPacketParser
+{
+ public:
+  enum ParseResult
+  {
+    PARSE_INCOMPLETE  = 0,  ///< more bytes are needed
+    PARSE_PACKET      = 1,  ///< a status packet with a valid CRC is in the packet buffer
+    PARSE_CRC_ERROR   = 2   ///< a complete status packet is in the packet buffer but its CRC does not match
+  };
+
+ private:
+  enum ParseState
+  {
+    STATE_HEADER0 = 0,
+    STATE_HEADER1,
+    STATE_HEADER2,
+    STATE_RESERVED,
+    STATE_ID,
+    STATE_LENGTH_L,
+    STATE_LENGTH_H,
+    STATE_BODY,
+    STATE_CRC
+  };
+
+  uint8_t  *packet_;
+  uint16_t  capacity_;
+
+  int       state_;
+  uint16_t  index_;           ///< bytes written to the packet buffer
+  uint16_t  body_remaining_;  ///< bytes on the wire from the instruction up to the CRC still to come
+  uint16_t  crc_;             ///< CRC of the bytes on the wire so far
+  uint32_t  stuffing_window_; ///< last three bytes on the wire, to detect the stuffed 0xFD
+  uint32_t  received_length_;
+  uint32_t  skipped_length_;
+
+  int       parseBytes(const uint8_t *data, int length);
+  void      resync();
+  void      copyBody(const uint8_t *data, uint16_t length);
+
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that initializes the parser
+  /// @param packet Buffer the status packet is assembled in
+  /// @param capacity Size of the buffer, longer packets are skipped
+  ////////////////////////////////////////////////////////////////////////////////
+  StatusPacketParser(uint8_t *packet, uint16_t capacity);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that discards a partly received packet and starts searching for the next header
+  ////////////////////////////////////////////////////////////////////////////////
+  void      reset();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that feeds received bytes into the parser
+  /// @description The function consumes bytes until a complete packet has been assembled or the bytes run out.
+  /// @description Bytes after a complete packet are left for the next call. The packet stays in the packet buffer
+  /// @description until the next call, with the length field corrected for the removed stuffing.
+  /// @param data Received bytes
+  /// @param length Number of received bytes
+  /// @param consumed Number of bytes the parser has used
+  /// @return PARSE_INCOMPLETE, PARSE_PACKET or PARSE_CRC_ERROR
+  ////////////////////////////////////////////////////////////////////////////////
+  int       parse(const uint8_t *data, int length, int *consumed);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the packet buffer
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t  *getPacket()           { return packet_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the length of the last complete packet, without stuffing
+  ////////////////////////////////////////////////////////////////////////////////
+  uint16_t  getPacketLength()     { return index_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the ID of the last complete packet
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t   getId();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the error byte of the last complete packet
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t   getError();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the data of the last complete packet, which follows the error byte
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t  *getParameter();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the length of the data of the last complete packet
+  ////////////////////////////////////////////////////////////////////////////////
+  uint16_t  getParameterLength();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether a packet has been started but not completed
+  ////////////////////////////////////////////////////////////////////////////////
+  bool      isInPacket()          { return state_ >= STATE_RESERVED; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of bytes consumed since the parser was reset
+  ////////////////////////////////////////////////////////////////////////////////
+  uint32_t  getReceivedLength()   { return received_length_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of bytes skipped as noise since the parser was reset
+  ////////////////////////////////////////////////////////////////////////////////
+  uint32_t  getSkippedLength()    { return skipped_length_; }
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_STATUSPACKETPARSER_H_ */
@@ -0,0 +1,167 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_TRAFFICRECORDER_H_
+#define INCLUDE_MERCURY_SDK_TRAFFICRECORDER_H_
+
+#include <string.h>
+#include <atomic>
+
+#include "port_handler.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that records the bytes of ports into a memory-mapped capture file
+/// @description The file starts with a FileHeader, followed by the records in the order their space was taken.
+/// @description Each record is a Record followed by its bytes, padded to 8 bytes. The file is append only:
+/// @description once it is full, further records are dropped and counted in FileHeader::dropped_count.
+/// @description Recording takes the space with one compare-and-swap and copies the bytes, without a system call,
+/// @description so several ports (also on several threads) can share a recorder. The kernel writes the pages back,
+/// @description so the records survive a crash of the process.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC TrafficRecorder
+{
+ public:
+  static const uint32_t VERSION_        = 1;
+  static const uint64_t MIN_CAPACITY_   = 4096;   ///< smallest size of a capture file (bytes)
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The direction of recorded bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  enum Direction
+  {
+    DIRECTION_TX  = 0,  ///< written to the port (instruction packets)
+    DIRECTION_RX  = 1   ///< read from the port (status packets)
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The header at the start of a capture file
+  ////////////////////////////////////////////////////////////////////////////////
+  struct FileHeader
+  {
+    char                  magic[8];         ///< "MCYTRAF" followed by 0
+    uint32_t              version;          ///< VERSION_
+    uint32_t              header_size;      ///< offset of the first record
+    uint64_t              capacity;         ///< size of the file
+    int64_t               start_time;       ///< MonotonicClock time at which the file was created (nsec)
+    int64_t               start_realtime;   ///< wall clock time at which the file was created (nsec since the epoch)
+    std::atomic<uint64_t> end;              ///< offset of the next record
+    std::atomic<uint64_t> dropped_count;    ///< number of records dropped because the file was full
+    uint64_t              reserved;
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The header of a record
+  ////////////////////////////////////////////////////////////////////////////////
+  struct Record
+  {
+    std::atomic<uint32_t> size;       ///< size of the record with its padding, 0 until the bytes are complete
+    uint16_t              length;     ///< number of bytes which follow the header
+    uint8_t               direction;  ///< DIRECTION_TX or DIRECTION_RX
+    uint8_t               channel;    ///< channel of the port, see PortHandler::setRecorder()
+    int64_t               time;       ///< time of the bytes on the clock of the port (nsec)
+  };
+
+  TrafficRecorder();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that closes the capture file
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual ~TrafficRecorder();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that creates a capture file and maps it into memory
+  /// @description An existing file is overwritten. The whole capacity is allocated at once.
+  /// @param path Path of the capture file
+  /// @param capacity Size of the file in bytes (at least MIN_CAPACITY_)
+  /// @return false
+  /// @return   when the file could not be created or mapped (or the platform has no memory mapped files)
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    open(const char *path, uint64_t capacity);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that unmaps and closes the capture file
+  /// @description The file is cut after the last record. No port may record while the function runs.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    close();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether a capture file is open
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isOpen() { return header_ != 0; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of bytes used in the capture file, headers included
+  ////////////////////////////////////////////////////////////////////////////////
+  uint64_t getSize() { return header_ != 0 ? header_->end.load(std::memory_order_relaxed) : 0; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of records dropped because the capture file was full
+  ////////////////////////////////////////////////////////////////////////////////
+  uint64_t getDroppedCount() { return header_ != 0 ? header_->dropped_count.load(std::memory_order_relaxed) : 0; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that appends bytes to the capture file
+  /// @description The function is called by the port handlers, from any thread.
+  /// @param direction DIRECTION_TX or DIRECTION_RX
+  /// @param channel Channel of the port
+  /// @param time Time of the bytes (nsec)
+  /// @param data Bytes
+  /// @param length Number of bytes
+  /// @return false
+  /// @return   when the file isn't open or is full
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    record(Direction direction, uint8_t channel, int64_t time, const uint8_t *data, uint16_t length)
+  {
+    if (header_ == 0)
+      return false;
+
+    uint32_t size   = (uint32_t)((sizeof(Record) + length + 7) & ~(size_t)7);
+    uint64_t offset = header_->end.load(std::memory_order_relaxed);
+    do
+    {
+      if (offset + size > capacity_)
+      {
+        header_->dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    } while (header_->end.compare_exchange_weak(offset, offset + size, std::memory_order_relaxed) == false);
+
+    Record *record    = (Record *)(base_ + offset);
+    record->length    = length;
+    record->direction = (uint8_t)direction;
+    record->channel   = channel;
+    record->time      = time;
+    memcpy((uint8_t *)record + sizeof(Record), data, length);
+    record->size.store(size, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  uint8_t    *base_;
+  FileHeader *header_;
+  uint64_t    capacity_;
+  int         fd_;
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_TRAFFICRECORDER_H_ */
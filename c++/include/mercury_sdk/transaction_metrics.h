@@ -0,0 +1,251 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_TRANSACTIONMETRICS_H_
+#define INCLUDE_MERCURY_SDK_TRANSACTIONMETRICS_H_
+
+#include <atomic>
+
+#include "latency_histogram.h"
+#include "monotonic_clock.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that measures the transactions of a port: round-trip times, failures and bytes
+/// @description A transaction starts when its instruction packet has been written, and its round trip ends when the
+/// @description status packet, or each status packet of a Sync / Bulk Read, has been received or given up on.
+/// @description The latencies go into a LatencyHistogram per transaction type and per Mercury ID, next to counters of
+/// @description timeouts, corrupt packets and CRC errors. Packets which are only transmitted are counted, without a latency.
+/// @description The packet handlers update the metrics from the thread which holds the port, so one instance serves one port.
+/// @description Any other thread can read them at the same time without a lock.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC TransactionMetrics
+{
+ public:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The type of a transaction, after the instruction of its packet
+  ////////////////////////////////////////////////////////////////////////////////
+  enum TransactionType
+  {
+    TRANSACTION_PING            = 0,
+    TRANSACTION_READ            = 1,
+    TRANSACTION_WRITE           = 2,
+    TRANSACTION_REG_WRITE       = 3,
+    TRANSACTION_ACTION          = 4,
+    TRANSACTION_FACTORY_RESET   = 5,
+    TRANSACTION_REBOOT          = 6,
+    TRANSACTION_CLEAR           = 7,
+    TRANSACTION_SYNC_READ       = 8,
+    TRANSACTION_SYNC_WRITE      = 9,
+    TRANSACTION_FAST_SYNC_READ  = 10,
+    TRANSACTION_BULK_READ       = 11,
+    TRANSACTION_BULK_WRITE      = 12,
+    TRANSACTION_FAST_BULK_READ  = 13,
+    TRANSACTION_OTHER           = 14,
+    TRANSACTION_TYPE_COUNT      = 15
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The metrics of the transactions of one type
+  ////////////////////////////////////////////////////////////////////////////////
+  struct TypeMetrics
+  {
+    LatencyHistogram      latency;            ///< time from the write until the last status packet
+    std::atomic<uint64_t> transaction_count;  ///< instruction packets written
+    std::atomic<uint64_t> timeout_count;      ///< transactions which ended with COMM_RX_TIMEOUT
+    std::atomic<uint64_t> corrupt_count;      ///< transactions which ended with COMM_RX_CORRUPT
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The metrics of the status packets of one Mercury
+  /// @description The Mercurys of a Fast Sync / Bulk Read share one status packet, so its CRC errors are counted for BROADCAST_ID.
+  ////////////////////////////////////////////////////////////////////////////////
+  struct ServoMetrics
+  {
+    LatencyHistogram      latency;            ///< time from the write until the status packet
+    std::atomic<uint64_t> status_count;       ///< status packets awaited
+    std::atomic<uint64_t> timeout_count;      ///< status packets which never came
+    std::atomic<uint64_t> corrupt_count;      ///< status packets which came cut short or damaged
+    std::atomic<uint64_t> crc_error_count;    ///< status packets whose CRC did not match, part of corrupt_count
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The times at which a transaction went through each of its phases, on the MonotonicClock (nsec)
+  /// @description write_time - build_time is the host finishing the packet and the write call,
+  /// @description first_rx_time - write_time the wire time of the packet, the return delay and the USB latency,
+  /// @description last_rx_time - first_rx_time the status packets on the wire, and parse_time - last_rx_time the host again.
+  ////////////////////////////////////////////////////////////////////////////////
+  struct PhaseTiming
+  {
+    TransactionType type;
+    uint8_t   id;             ///< ID of the instruction packet
+    int       result;         ///< communication result of the transaction
+    uint16_t  tx_length;      ///< bytes written
+    uint32_t  rx_length;      ///< bytes read during the transaction
+    int64_t   build_time;     ///< the packet handler started to finish the packet (byte stuffing, CRC) and write it
+    int64_t   write_time;     ///< the write to the port returned
+    int64_t   first_rx_time;  ///< the first bytes were read, 0 when none came
+    int64_t   last_rx_time;   ///< the last bytes were read, 0 when none came
+    int64_t   parse_time;     ///< the status packets were parsed, or write_time for a packet without a status packet
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The type of the function which receives the phase timing of every transaction
+  /// @param timing Phases of the transaction, valid during the call
+  /// @param user_data Argument given to TransactionMetrics::setTraceCallback()
+  ////////////////////////////////////////////////////////////////////////////////
+  typedef void (*TraceCallback)(const PhaseTiming *timing, void *user_data);
+
+  TransactionMetrics();
+
+  virtual ~TransactionMetrics();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that traces the phases of every transaction
+  /// @description The callback is called at the end of each transaction, on the thread which ran it, while that thread still holds the port, so the callback must not use the port.
+  /// @description Packets without a status packet (Sync / Bulk Write, Action and broadcast writes) end when they are written.
+  /// @description Without a callback, the phases cost nothing: only the clock reads of the round trip are taken.
+  /// @description Set the callback while no transaction runs on the port.
+  /// @param callback Function which receives the timings, or NULL to stop tracing
+  /// @param user_data Argument of the callback
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setTraceCallback(TraceCallback callback, void *user_data = 0) { trace_callback_ = callback; trace_user_data_ = user_data; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the type of a transaction
+  /// @param instruction Instruction of the packet
+  /// @return TRANSACTION_OTHER for an unknown instruction
+  ////////////////////////////////////////////////////////////////////////////////
+  static TransactionType getTransactionType(uint8_t instruction);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the name of a transaction type, e.g. "SyncRead"
+  ////////////////////////////////////////////////////////////////////////////////
+  static const char *getTransactionName(TransactionType type);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the metrics of a transaction type
+  ////////////////////////////////////////////////////////////////////////////////
+  const TypeMetrics &getTypeMetrics(TransactionType type) { return types_[type]; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the metrics of a Mercury
+  /// @param id Mercury ID, or BROADCAST_ID for the Fast Sync / Bulk Reads
+  /// @return the metrics, which live as long as the instance
+  /// @return or 0 when no status packet of the Mercury has been awaited yet
+  ////////////////////////////////////////////////////////////////////////////////
+  const ServoMetrics *getServoMetrics(uint8_t id) { return servos_[id].load(std::memory_order_acquire); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of bytes written to the port
+  ////////////////////////////////////////////////////////////////////////////////
+  uint64_t getTxBytes() { return tx_bytes_.load(std::memory_order_relaxed); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of bytes read from the port
+  ////////////////////////////////////////////////////////////////////////////////
+  uint64_t getRxBytes() { return rx_bytes_.load(std::memory_order_relaxed); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that resets every histogram and counter
+  /// @description Call it from the thread which runs the transactions of the port, or while none runs.
+  /// @description The counters are not locked, so a transaction which ends on another thread during the call
+  /// @description can write back a count from before the reset.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    clear();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that marks the start of the packet build, called by the packet handlers once they hold the port
+  ////////////////////////////////////////////////////////////////////////////////
+  void    startPacket()
+  {
+    if (trace_callback_ != 0)
+      timing_.build_time = MonotonicClock::getTime();
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts a transaction, called by the packet handlers once a packet has been written
+  /// @param packet Instruction packet
+  /// @param length Length of the packet
+  ////////////////////////////////////////////////////////////////////////////////
+  void    beginTransaction(const uint8_t *packet, uint16_t length);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that ends the wait for the status packet of a Mercury, called by the packet handlers
+  /// @param id Mercury ID
+  /// @param result Communication result of the status packet
+  ////////////////////////////////////////////////////////////////////////////////
+  void    endStatus(uint8_t id, int result);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that ends the round trip of the transaction, called by the packet handlers
+  /// @param result Communication result of the transaction
+  ////////////////////////////////////////////////////////////////////////////////
+  void    endTransaction(int result);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that counts a status packet whose CRC did not match, called by the packet handlers
+  /// @param id Mercury ID the packet was received for
+  ////////////////////////////////////////////////////////////////////////////////
+  void    countCrcError(uint8_t id);
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that counts bytes read from the port, called by the port handlers
+  /// @param length Number of bytes
+  ////////////////////////////////////////////////////////////////////////////////
+  void    countRx(int length)
+  {
+    add(rx_bytes_, (uint64_t)length);
+    if (trace_callback_ != 0)
+      traceRx(length);
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the ID of the instruction packet of the running transaction
+  ////////////////////////////////////////////////////////////////////////////////
+  uint8_t getTransactionId() { return id_; }
+
+ private:
+  // one thread writes, so a load and a store make the counters exact without a locked instruction
+  static void add(std::atomic<uint64_t> &counter, uint64_t n)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  ServoMetrics *getServo(uint8_t id);
+  void    traceRx(int length);
+  void    trace(int result, int64_t parse_time);
+
+  TypeMetrics                 types_[TRANSACTION_TYPE_COUNT];
+  std::atomic<ServoMetrics *> servos_[256];   ///< created on the first status packet awaited from each ID
+  std::atomic<uint64_t>       tx_bytes_;
+  std::atomic<uint64_t>       rx_bytes_;
+
+  TransactionType type_;        ///< of the running transaction
+  uint8_t         id_;
+  int64_t         start_time_;  ///< time at which the instruction packet was written (nsec)
+
+  TraceCallback   trace_callback_;
+  void           *trace_user_data_;
+  PhaseTiming     timing_;      ///< of the running transaction
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_TRANSACTIONMETRICS_H_ */
@@ -0,0 +1,126 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#ifndef INCLUDE_MERCURY_SDK_VIRTUALBUS_H_
+#define INCLUDE_MERCURY_SDK_VIRTUALBUS_H_
+
+#include <atomic>
+#include <thread>
+
+#include "bus_emulator.h"
+
+namespace mercury
+{
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief The class that serves a bus of emulated Mercurys on a pseudo terminal (Linux)
+/// @description The virtual bus keeps the master side of a pty pair and answers on it from its own thread.
+/// @description The slave side, returned by VirtualBus::getPortName(), is opened by an unmodified PortHandlerLinux,
+/// @description so every transaction goes through termios, read(), write() and poll() as with a serial adapter.
+/// @description The baudrate set by the port handler selects which Mercurys listen, as with PortHandlerEmulator.
+////////////////////////////////////////////////////////////////////////////////
+class WINDECLSPEC VirtualBus
+{
+ private:
+  BusEmulator bus_;
+
+  int     master_fd_;
+  int     slave_fd_;          ///< kept open so that the master doesn't hang up while no port handler has the slave open
+  int     stop_fd_;           ///< eventfd which ends the thread
+  char    port_name_[100];
+  bool    is_timed_;
+
+  std::thread           thread_;
+  std::atomic<uint32_t> packet_count_;
+
+  void    run();
+  void    respond(int64_t rx_end_time, int64_t byte_time);
+  bool    writeMaster(const uint8_t *data, uint32_t length);
+  int     getSlaveBaudRate();
+
+ public:
+  VirtualBus();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that stops the thread and closes the pseudo terminal
+  ////////////////////////////////////////////////////////////////////////////////
+  virtual ~VirtualBus();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the emulated bus, to add Mercurys to it and look at their control tables
+  /// @description The bus may only be changed while the thread is stopped.
+  /// @return the bus, owned by the virtual bus
+  ////////////////////////////////////////////////////////////////////////////////
+  BusEmulator *getBus() { return &bus_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that opens a pseudo terminal pair
+  /// @return false
+  /// @return   when no pseudo terminal could be opened
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    open();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that stops the thread and closes the pseudo terminal pair
+  ////////////////////////////////////////////////////////////////////////////////
+  void    close();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the path of the slave side, to be passed to PortHandler::getPortHandler()
+  /// @return Port name (e.g. /dev/pts/3)
+  /// @return or an empty string when the pseudo terminal isn't open
+  ////////////////////////////////////////////////////////////////////////////////
+  char   *getPortName() { return port_name_; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that selects whether the status packets are sent at the time of a real bus
+  /// @description When timed, each status packet is written once its last byte would have arrived at the baudrate of the port,
+  /// @description after the return delay of its Mercury. Otherwise it is written as soon as the instruction packet is read,
+  /// @description so a transaction only costs the system calls and the tty layer.
+  /// @param is_timed true to model the bus timing (false by default)
+  ////////////////////////////////////////////////////////////////////////////////
+  void    setTiming(bool is_timed) { is_timed_ = is_timed; }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that starts the thread which answers on the pseudo terminal
+  /// @return false
+  /// @return   when the pseudo terminal isn't open
+  /// @return or true
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    start();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that stops the thread
+  /// @description The function returns when the thread has ended.
+  ////////////////////////////////////////////////////////////////////////////////
+  void    stop();
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that checks whether the thread runs
+  ////////////////////////////////////////////////////////////////////////////////
+  bool    isRunning() { return thread_.joinable(); }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// @brief The function that returns the number of instruction packets executed since the pseudo terminal was opened
+  ////////////////////////////////////////////////////////////////////////////////
+  uint32_t getPacketCount() { return packet_count_; }
+};
+
+}
+
+
+#endif /* INCLUDE_MERCURY_SDK_VIRTUALBUS_H_ */
@@ -0,0 +1,262 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "async_packet_handler.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "async_packet_handler.h"
+#endif
+
+#include <chrono>
+#include <string.h>
+
+using namespace mercury;
+
+AsyncRequest::AsyncRequest()
+  : handler_(0),
+    is_done_(true),
+    callback_(0),
+    user_data_(0),
+    kind_(KIND_READ),
+    id_(0),
+    address_(0),
+    length_(0),
+    data_(value_),
+    error_(0),
+    model_number_(0),
+    sync_read_(0),
+    sync_write_(0)
+{
+  memset(value_, 0, sizeof(value_));
+}
+
+int AsyncRequest::execute(PortHandler *port, PacketHandler *ph)
+{
+  switch (kind_)
+  {
+    case KIND_READ:
+      return ph->readTxRx(port, id_, address_, length_, data_, &error_);
+
+    case KIND_WRITE:
+      return ph->writeTxRx(port, id_, address_, length_, data_, &error_);
+
+    case KIND_PING:
+      return ph->ping(port, id_, &model_number_, &error_);
+
+    case KIND_SYNC_READ:
+      return sync_read_->txRxPacket();
+
+    case KIND_SYNC_WRITE:
+      return sync_write_->txPacket();
+
+    default:
+      return COMM_NOT_AVAILABLE;
+  }
+}
+
+void AsyncRequest::onComplete()
+{
+  AsyncPacketHandler *handler = handler_;
+
+  if (callback_ != 0)
+    callback_(this, user_data_);
+
+  // the caller may submit the request again from here on
+  is_done_.store(true, std::memory_order_release);
+  handler->notify();
+}
+
+int AsyncRequest::wait(double msec)
+{
+  if (isDone() == true)
+    return getResult();
+
+  return handler_->wait(this, msec);
+}
+
+uint32_t AsyncRequest::getValue()
+{
+  if (kind_ == KIND_PING)
+    return model_number_;
+
+  switch (length_)
+  {
+    case 1:
+      return data_[0];
+
+    case 2:
+      return MCY_MAKEWORD(data_[0], data_[1]);
+
+    case 4:
+      return MCY_MAKEDWORD(MCY_MAKEWORD(data_[0], data_[1]), MCY_MAKEWORD(data_[2], data_[3]));
+
+    default:
+      return 0;
+  }
+}
+
+AsyncPacketHandler::AsyncPacketHandler(PortIoEngine *engine)
+  : engine_(engine),
+    waiting_count_(0)
+{
+}
+
+int AsyncPacketHandler::claim(AsyncRequest *request)
+{
+  if (engine_->isRunning() == false)
+    return COMM_NOT_AVAILABLE;
+
+  if (request->is_done_.exchange(false, std::memory_order_acq_rel) == false)
+    return COMM_PORT_BUSY;
+
+  return COMM_SUCCESS;
+}
+
+void AsyncPacketHandler::submit(AsyncRequest *request, AsyncRequest::Callback callback, void *user_data)
+{
+  request->handler_   = this;
+  request->callback_  = callback;
+  request->user_data_ = user_data;
+  engine_->submit(request, 0);
+}
+
+int AsyncPacketHandler::wait(AsyncRequest *request, double msec)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  // pairs with the fence in notify(): either the I/O thread sees the waiter, or the waiter sees the request done
+  waiting_count_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  bool is_done;
+  if (msec < 0)
+  {
+    condition_.wait(lock, [request] { return request->isDone(); });
+    is_done = true;
+  }
+  else
+  {
+    is_done = condition_.wait_for(lock, std::chrono::microseconds((long long)(msec * 1000.0)),
+                                  [request] { return request->isDone(); });
+  }
+
+  waiting_count_.fetch_sub(1, std::memory_order_relaxed);
+
+  if (is_done == false)
+    return COMM_RX_WAITING;
+  return request->getResult();
+}
+
+void AsyncPacketHandler::notify()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting_count_.load(std::memory_order_relaxed) > 0)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    condition_.notify_all();
+  }
+}
+
+int AsyncPacketHandler::readAsync(AsyncRequest *request, uint8_t id, uint16_t address, uint16_t length, uint8_t *data,
+                                  AsyncRequest::Callback callback, void *user_data)
+{
+  if (data == 0 && length > sizeof(request->value_))
+    return COMM_TX_ERROR;
+
+  int result = claim(request);
+  if (result != COMM_SUCCESS)
+    return result;
+
+  request->kind_    = AsyncRequest::KIND_READ;
+  request->id_      = id;
+  request->address_ = address;
+  request->length_  = length;
+  request->data_    = (data == 0) ? request->value_ : data;
+  request->error_   = 0;
+
+  submit(request, callback, user_data);
+  return COMM_SUCCESS;
+}
+
+int AsyncPacketHandler::writeAsync(AsyncRequest *request, uint8_t id, uint16_t address, uint16_t length, uint8_t *data,
+                                   AsyncRequest::Callback callback, void *user_data)
+{
+  int result = claim(request);
+  if (result != COMM_SUCCESS)
+    return result;
+
+  request->kind_    = AsyncRequest::KIND_WRITE;
+  request->id_      = id;
+  request->address_ = address;
+  request->length_  = length;
+  request->error_   = 0;
+
+  // short data is kept in the request, so the caller's buffer can go at once
+  if (length <= sizeof(request->value_))
+  {
+    memcpy(request->value_, data, length);
+    request->data_ = request->value_;
+  }
+  else
+  {
+    request->data_ = data;
+  }
+
+  submit(request, callback, user_data);
+  return COMM_SUCCESS;
+}
+
+int AsyncPacketHandler::pingAsync(AsyncRequest *request, uint8_t id, AsyncRequest::Callback callback, void *user_data)
+{
+  int result = claim(request);
+  if (result != COMM_SUCCESS)
+    return result;
+
+  request->kind_         = AsyncRequest::KIND_PING;
+  request->id_           = id;
+  request->error_        = 0;
+  request->model_number_ = 0;
+
+  submit(request, callback, user_data);
+  return COMM_SUCCESS;
+}
+
+int AsyncPacketHandler::syncReadAsync(AsyncRequest *request, GroupSyncRead *group, AsyncRequest::Callback callback, void *user_data)
+{
+  int result = claim(request);
+  if (result != COMM_SUCCESS)
+    return result;
+
+  request->kind_      = AsyncRequest::KIND_SYNC_READ;
+  request->sync_read_ = group;
+
+  submit(request, callback, user_data);
+  return COMM_SUCCESS;
+}
+
+int AsyncPacketHandler::syncWriteAsync(AsyncRequest *request, GroupSyncWrite *group, AsyncRequest::Callback callback, void *user_data)
+{
+  int result = claim(request);
+  if (result != COMM_SUCCESS)
+    return result;
+
+  request->kind_       = AsyncRequest::KIND_SYNC_WRITE;
+  request->sync_write_ = group;
+
+  submit(request, callback, user_data);
+  return COMM_SUCCESS;
+}
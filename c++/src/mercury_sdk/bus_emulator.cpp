@@ -0,0 +1,395 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "bus_emulator.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "bus_emulator.h"
+#endif
+
+#include <string.h>
+
+#include "byte_stuffing.h"
+#include "crc16.h"
+#include "packet_handler.h"
+
+#define PKT_ID                  4
+#define PKT_LENGTH_L            5
+#define PKT_LENGTH_H            6
+#define PKT_INSTRUCTION         7
+
+#define TXPACKET_MAX_LEN        PortHandler::TX_PACKET_LENGTH_
+
+#define ERRNUM_INSTRUCTION      2       // Instruction error
+#define ERRNUM_DATA_LENGTH      5       // Data length error
+
+using namespace mercury;
+
+BusEmulator::BusEmulator()
+  : baudrate_(PortHandler::DEFAULT_BAUDRATE_),
+    crc_error_count_(0)
+{
+  for (int id = 0; id < 256; id++)
+    servos_[id] = 0;
+}
+
+BusEmulator::~BusEmulator()
+{
+  for (int id = 0; id < 256; id++)
+    delete servos_[id];
+}
+
+ServoEmulator *BusEmulator::addServo(uint8_t id, uint16_t model_number)
+{
+  if (id > MAX_ID || servos_[id] != 0)
+    return 0;
+
+  servos_[id] = new ServoEmulator(id, model_number);
+  return servos_[id];
+}
+
+void BusEmulator::removeServo(uint8_t id)
+{
+  delete servos_[id];
+  servos_[id] = 0;
+}
+
+void BusEmulator::clearResponses()
+{
+  tx_data_.clear();
+  responses_.clear();
+}
+
+int BusEmulator::receive(const uint8_t *data, int length)
+{
+  int executed = 0;
+  uint32_t begin = 0;
+
+  rx_data_.insert(rx_data_.end(), data, data + length);
+
+  while (begin + PKT_INSTRUCTION <= rx_data_.size())
+  {
+    const uint8_t *packet = &rx_data_[begin];
+    uint32_t available    = (uint32_t)rx_data_.size() - begin;
+
+    if (packet[0] != 0xFF || packet[1] != 0xFF || packet[2] != 0xFD || packet[3] != 0x00)
+    {
+      begin++;
+      continue;
+    }
+
+    uint16_t packet_length = MCY_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]);
+    if (packet_length < 3 || packet_length + PKT_INSTRUCTION > TXPACKET_MAX_LEN)
+    {
+      begin++;
+      continue;
+    }
+    if (available < (uint32_t)(PKT_INSTRUCTION + packet_length))
+      break;
+
+    uint32_t crc_index = PKT_INSTRUCTION + packet_length - 2;
+    if (Crc16::update(0, packet, (uint16_t)crc_index) != MCY_MAKEWORD(packet[crc_index], packet[crc_index + 1]))
+    {
+      crc_error_count_++;
+      begin++;
+      continue;
+    }
+
+    param_.resize(packet_length);
+    uint32_t param_length = ByteStuffing::unstuff(packet, PKT_INSTRUCTION, crc_index, &param_[0]);
+    execute(packet[PKT_ID], param_[0], &param_[1], (uint16_t)(param_length - 1));
+
+    executed++;
+    begin += PKT_INSTRUCTION + packet_length;
+  }
+
+  rx_data_.erase(rx_data_.begin(), rx_data_.begin() + begin);
+  return executed;
+}
+
+bool BusEmulator::isListening(uint8_t id)
+{
+  return servos_[id] != 0 && servos_[id]->getBaudRate() == baudrate_;
+}
+
+void BusEmulator::execute(uint8_t id, uint8_t instruction, const uint8_t *param, uint16_t length)
+{
+  uint8_t data[ServoEmulator::CONTROL_TABLE_SIZE_];
+
+  switch (instruction)
+  {
+    case INST_SYNC_READ:
+    case INST_BULK_READ:
+    {
+      bool is_bulk      = (instruction == INST_BULK_READ);
+      uint16_t step     = is_bulk ? 5 : 1;
+      uint16_t first    = is_bulk ? 0 : 4;
+      if (id != BROADCAST_ID || (is_bulk == false && length < 4))
+        break;
+
+      // the Mercurys answer one after the other, in the order of the list
+      for (uint16_t i = first; i + step <= length; i += step)
+      {
+        uint8_t  target   = param[i];
+        uint16_t address  = is_bulk ? MCY_MAKEWORD(param[i + 1], param[i + 2]) : MCY_MAKEWORD(param[0], param[1]);
+        uint16_t size     = is_bulk ? MCY_MAKEWORD(param[i + 3], param[i + 4]) : MCY_MAKEWORD(param[2], param[3]);
+        if (isListening(target) == false)
+          continue;
+
+        ServoEmulator *servo = servos_[target];
+        uint8_t error = servo->read(address, size, data);
+        addStatus(target, servo->getReturnDelayTime(), error, data, error == 0 ? size : 0);
+      }
+      break;
+    }
+
+    case INST_FAST_SYNC_READ:
+    case INST_FAST_BULK_READ:
+      if (id == BROADCAST_ID)
+        executeFastRead(param, length, instruction == INST_FAST_BULK_READ);
+      break;
+
+    case INST_SYNC_WRITE:
+    {
+      if (id != BROADCAST_ID || length < 4)
+        break;
+
+      uint16_t address  = MCY_MAKEWORD(param[0], param[1]);
+      uint16_t size     = MCY_MAKEWORD(param[2], param[3]);
+      for (uint32_t i = 4; i + 1 + size <= length; i += 1 + size)
+      {
+        if (isListening(param[i]))
+          servos_[param[i]]->write(address, size, &param[i + 1]);
+      }
+      break;
+    }
+
+    case INST_BULK_WRITE:
+    {
+      if (id != BROADCAST_ID)
+        break;
+
+      for (uint32_t i = 0; i + 5 <= length; )
+      {
+        uint16_t address  = MCY_MAKEWORD(param[i + 1], param[i + 2]);
+        uint16_t size     = MCY_MAKEWORD(param[i + 3], param[i + 4]);
+        if (i + 5 + size > length)
+          break;
+        if (isListening(param[i]))
+          servos_[param[i]]->write(address, size, &param[i + 5]);
+        i += 5 + size;
+      }
+      break;
+    }
+
+    default:
+      if (id == BROADCAST_ID)
+      {
+        for (int target = 0; target <= MAX_ID; target++)
+        {
+          if (isListening(target))
+            executeSingle(servos_[target], instruction, param, length, true);
+        }
+      }
+      else if (isListening(id))
+      {
+        executeSingle(servos_[id], instruction, param, length, false);
+      }
+      break;
+  }
+
+  updateIds();
+}
+
+void BusEmulator::executeSingle(ServoEmulator *servo, uint8_t instruction, const uint8_t *param, uint16_t length, bool is_broadcast)
+{
+  uint8_t data[ServoEmulator::CONTROL_TABLE_SIZE_];
+  uint16_t data_length  = 0;
+  uint8_t error         = 0;
+
+  // the status packet leaves with the ID and the return delay from before the instruction
+  uint8_t id            = servo->getId();
+  double delay          = servo->getReturnDelayTime();
+
+  switch (instruction)
+  {
+    case INST_PING:
+      data[0]     = MCY_LOBYTE(servo->getModelNumber());
+      data[1]     = MCY_HIBYTE(servo->getModelNumber());
+      data[2]     = servo->getControlTable()[ServoEmulator::ADDR_FIRMWARE_VERSION];
+      data_length = 3;
+      break;
+
+    case INST_READ:
+      if (length != 4)
+      {
+        error = ERRNUM_DATA_LENGTH;
+        break;
+      }
+      error = servo->read(MCY_MAKEWORD(param[0], param[1]), MCY_MAKEWORD(param[2], param[3]), data);
+      if (error == 0)
+        data_length = MCY_MAKEWORD(param[2], param[3]);
+      break;
+
+    case INST_WRITE:
+    case INST_REG_WRITE:
+      if (length < 2)
+        error = ERRNUM_DATA_LENGTH;
+      else if (instruction == INST_WRITE)
+        error = servo->write(MCY_MAKEWORD(param[0], param[1]), length - 2, &param[2]);
+      else
+        error = servo->regWrite(MCY_MAKEWORD(param[0], param[1]), length - 2, &param[2]);
+      break;
+
+    case INST_ACTION:
+      error = servo->action();
+      break;
+
+    case INST_REBOOT:
+      servo->reboot();
+      break;
+
+    case INST_FACTORY_RESET:
+      if (length != 1)
+        error = ERRNUM_DATA_LENGTH;
+      else
+        error = servo->factoryReset(param[0]);
+      break;
+
+    case INST_CLEAR:
+      error = servo->clear(param, length);
+      break;
+
+    default:
+      error = ERRNUM_INSTRUCTION;
+      break;
+  }
+
+  // only a ping is answered by every Mercury of a broadcast, and an Action is never answered
+  if ((is_broadcast && instruction != INST_PING) || instruction == INST_ACTION)
+    return;
+
+  addStatus(id, delay, error, data, data_length);
+}
+
+// ERROR ID DATA CRC16_L CRC16_H of each Mercury follow the instruction, the CRC after the last one is the CRC of the packet;
+// each Mercury appends its part to the packet, so the packet ends where a Mercury of the list is missing
+void BusEmulator::executeFastRead(const uint8_t *param, uint16_t length, bool is_bulk)
+{
+  static const uint8_t header[PKT_INSTRUCTION] = { 0xFF, 0xFF, 0xFD, 0x00, BROADCAST_ID, 0x00, 0x00 };
+
+  uint16_t step         = is_bulk ? 5 : 1;
+  uint16_t first        = is_bulk ? 0 : 4;
+  uint32_t sent_length  = 0;
+  double delay          = 0.0;
+  uint16_t header_crc   = Crc16::update(0, header, PKT_INSTRUCTION);
+
+  if (is_bulk == false && length < 4)
+    return;
+
+  body_.assign(1, INST_STATUS);
+  for (uint16_t i = first; i + step <= length; i += step)
+  {
+    uint8_t  target   = param[i];
+    uint16_t address  = is_bulk ? MCY_MAKEWORD(param[i + 1], param[i + 2]) : MCY_MAKEWORD(param[0], param[1]);
+    uint16_t size     = is_bulk ? MCY_MAKEWORD(param[i + 3], param[i + 4]) : MCY_MAKEWORD(param[2], param[3]);
+
+    if (i != first)
+    {
+      uint16_t crc = Crc16::update(header_crc, body_.data(), (uint16_t)body_.size());
+      body_.push_back(MCY_LOBYTE(crc));
+      body_.push_back(MCY_HIBYTE(crc));
+    }
+
+    uint32_t offset = (uint32_t)body_.size();
+    body_.resize(offset + 2 + size, 0);
+    if (isListening(target) == false)
+    {
+      if (sent_length == 0)
+        sent_length = offset;
+      continue;
+    }
+
+    ServoEmulator *servo = servos_[target];
+    if (i == first)
+      delay = servo->getReturnDelayTime();
+    body_[offset]     = servo->read(address, size, &body_[offset + 2]);
+    body_[offset + 1] = target;
+  }
+
+  if (sent_length == 0)
+    sent_length = (uint32_t)body_.size();
+  if (sent_length > 1)
+    addPacket(BROADCAST_ID, delay, body_.data(), (uint32_t)body_.size(), sent_length);
+}
+
+void BusEmulator::addStatus(uint8_t id, double delay, uint8_t error, const uint8_t *data, uint16_t length)
+{
+  body_.resize(2 + length);
+  body_[0] = INST_STATUS;
+  body_[1] = error;
+  memcpy(&body_[2], data, length);
+
+  addPacket(id, delay, body_.data(), (uint32_t)body_.size(), (uint32_t)body_.size());
+}
+
+// the packet is cut after the first sent_length bytes of the body when the rest of it is never sent
+void BusEmulator::addPacket(uint8_t id, double delay, const uint8_t *body, uint32_t length, uint32_t sent_length)
+{
+  uint32_t offset = (uint32_t)tx_data_.size();
+  tx_data_.resize(offset + PKT_INSTRUCTION + length + length / 3 + 2);
+
+  uint8_t *packet   = &tx_data_[offset];
+  uint32_t stuffed  = ByteStuffing::stuff(body, length, packet + PKT_INSTRUCTION);
+
+  packet[0]             = 0xFF;
+  packet[1]             = 0xFF;
+  packet[2]             = 0xFD;
+  packet[3]             = 0x00;
+  packet[PKT_ID]        = id;
+  packet[PKT_LENGTH_L]  = MCY_LOBYTE(stuffed + 2);
+  packet[PKT_LENGTH_H]  = MCY_HIBYTE(stuffed + 2);
+
+  uint16_t crc = Crc16::update(0, packet, (uint16_t)(PKT_INSTRUCTION + stuffed));
+  packet[PKT_INSTRUCTION + stuffed]     = MCY_LOBYTE(crc);
+  packet[PKT_INSTRUCTION + stuffed + 1] = MCY_HIBYTE(crc);
+
+  uint32_t packet_length = PKT_INSTRUCTION + stuffed + 2;
+  if (sent_length < length)
+    packet_length = PKT_INSTRUCTION + sent_length + ByteStuffing::count(body, sent_length);
+  tx_data_.resize(offset + packet_length);
+
+  Response response;
+  response.offset = offset;
+  response.length = packet_length;
+  response.delay  = delay;
+  responses_.push_back(response);
+}
+
+// an ID written by the last instruction moves the Mercury once its status packet has left
+void BusEmulator::updateIds()
+{
+  for (int id = 0; id < 256; id++)
+  {
+    ServoEmulator *servo = servos_[id];
+    if (servo == 0 || servo->getId() == id || servos_[servo->getId()] != 0)
+      continue;
+
+    servos_[servo->getId()] = servo;
+    servos_[id] = 0;
+  }
+}
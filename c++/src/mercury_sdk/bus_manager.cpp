@@ -0,0 +1,249 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "bus_manager.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "bus_manager.h"
+#endif
+
+using namespace mercury;
+
+int BusManager::BusTransaction::execute(PortHandler *port, PacketHandler *ph)
+{
+  int result = COMM_SUCCESS;
+
+  if (mode_ == MODE_SCAN)
+  {
+    bus_->scan_list_.clear();
+    return ph->broadcastPing(port, bus_->scan_list_);
+  }
+
+  if ((mode_ == MODE_WRITE || mode_ == MODE_WRITE_READ) && bus_->write_count_ > 0)
+  {
+    result = bus_->sync_write_->txPacket();
+    if (result != COMM_SUCCESS)
+      return result;
+  }
+
+  if ((mode_ == MODE_READ || mode_ == MODE_WRITE_READ) && bus_->servo_count_ > 0 && bus_->sync_read_ != 0)
+    result = bus_->sync_read_->txRxPacket();
+
+  return result;
+}
+
+BusManager::BusManager(PacketHandler *ph, uint16_t read_address, uint16_t read_length, uint16_t write_address, uint16_t write_length)
+  : ph_(ph),
+    read_address_(read_address),
+    read_length_(read_length),
+    write_address_(write_address),
+    write_length_(write_length),
+    is_fast_read_(false)
+{
+  for (int id = 0; id < 256; id++)
+  {
+    id_to_bus_[id]  = BUS_MANAGER_NO_BUS;
+    is_written_[id] = false;
+  }
+}
+
+BusManager::~BusManager()
+{
+  for (unsigned int i = 0; i < buses_.size(); i++)
+  {
+    Bus *bus = buses_[i];
+
+    bus->engine_->stop();
+    delete bus->engine_;
+    delete bus->sync_read_;
+    delete bus->sync_write_;
+
+    bus->port_->closePort();
+    delete bus->port_;
+    delete bus;
+  }
+}
+
+int BusManager::addPort(PortHandler *port)
+{
+  Bus *bus = new Bus;
+  bus->port_        = port;
+  bus->engine_      = new PortIoEngine(port, ph_);
+  bus->sync_read_   = (read_length_ > 0) ? new GroupSyncRead(port, ph_, read_address_, read_length_) : 0;
+  bus->sync_write_  = (write_length_ > 0) ? new GroupSyncWrite(port, ph_, write_address_, write_length_) : 0;
+  bus->servo_count_ = 0;
+  bus->write_count_ = 0;
+  bus->transaction_.bus_  = bus;
+  bus->transaction_.mode_ = MODE_READ;
+
+  if (bus->sync_read_ != 0)
+    bus->sync_read_->setFastRead(is_fast_read_);
+
+  bus->engine_->start();
+  buses_.push_back(bus);
+
+  return (int)buses_.size() - 1;
+}
+
+int BusManager::runCycle(Mode mode)
+{
+  if (buses_.size() == 0)
+    return COMM_NOT_AVAILABLE;
+
+  for (unsigned int i = 0; i < buses_.size(); i++)
+  {
+    buses_[i]->transaction_.mode_ = mode;
+    buses_[i]->engine_->submit(&buses_[i]->transaction_, &completion_queue_);
+  }
+
+  // the buses finish in any order, the cycle is over when the slowest one is
+  for (unsigned int i = 0; i < buses_.size(); i++)
+    completion_queue_.wait(-1);
+
+  for (unsigned int i = 0; i < buses_.size(); i++)
+  {
+    if (buses_[i]->transaction_.getResult() != COMM_SUCCESS)
+      return buses_[i]->transaction_.getResult();
+  }
+
+  return COMM_SUCCESS;
+}
+
+int BusManager::scan()
+{
+  int result = runCycle(MODE_SCAN);
+
+  for (unsigned int i = 0; i < buses_.size(); i++)
+  {
+    std::vector<uint8_t> &scan_list = buses_[i]->scan_list_;
+    for (unsigned int n = 0; n < scan_list.size(); n++)
+    {
+      if (id_to_bus_[scan_list[n]] == BUS_MANAGER_NO_BUS)
+        addServo(scan_list[n], (int)i);
+    }
+  }
+
+  return result;
+}
+
+bool BusManager::addServo(uint8_t id, int bus)
+{
+  if (bus < 0 || bus >= (int)buses_.size() || id_to_bus_[id] != BUS_MANAGER_NO_BUS)
+    return false;
+
+  Bus *target = buses_[bus];
+  if (target->sync_read_ != 0 && target->sync_read_->addParam(id) == false)
+    return false;
+
+  target->servo_count_++;
+  id_to_bus_[id] = bus;
+  return true;
+}
+
+void BusManager::removeServo(uint8_t id)
+{
+  if (id_to_bus_[id] == BUS_MANAGER_NO_BUS)
+    return;
+
+  Bus *bus = buses_[id_to_bus_[id]];
+  if (bus->sync_read_ != 0)
+    bus->sync_read_->removeParam(id);
+  bus->servo_count_--;
+
+  if (is_written_[id] == true)
+  {
+    bus->sync_write_->removeParam(id);
+    bus->write_count_--;
+    is_written_[id] = false;
+  }
+
+  id_to_bus_[id] = BUS_MANAGER_NO_BUS;
+}
+
+void BusManager::setFastRead(bool enable)
+{
+  is_fast_read_ = enable;
+  for (unsigned int i = 0; i < buses_.size(); i++)
+  {
+    if (buses_[i]->sync_read_ != 0)
+      buses_[i]->sync_read_->setFastRead(enable);
+  }
+}
+
+bool BusManager::setData(uint8_t id, uint8_t *data)
+{
+  if (id_to_bus_[id] == BUS_MANAGER_NO_BUS || write_length_ == 0)
+    return false;
+
+  Bus *bus = buses_[id_to_bus_[id]];
+  if (is_written_[id] == true)
+    return bus->sync_write_->changeParam(id, data);
+
+  if (bus->sync_write_->addParam(id, data) == false)
+    return false;
+
+  bus->write_count_++;
+  is_written_[id] = true;
+  return true;
+}
+
+int BusManager::readAll()
+{
+  return runCycle(MODE_READ);
+}
+
+int BusManager::writeAll()
+{
+  return runCycle(MODE_WRITE);
+}
+
+int BusManager::writeReadAll()
+{
+  return runCycle(MODE_WRITE_READ);
+}
+
+int BusManager::getResult(uint8_t id)
+{
+  if (id_to_bus_[id] == BUS_MANAGER_NO_BUS || read_length_ == 0)
+    return COMM_NOT_AVAILABLE;
+
+  return buses_[id_to_bus_[id]]->sync_read_->getResult(id);
+}
+
+bool BusManager::isAvailable(uint8_t id, uint16_t address, uint16_t data_length)
+{
+  if (id_to_bus_[id] == BUS_MANAGER_NO_BUS || read_length_ == 0)
+    return false;
+
+  return buses_[id_to_bus_[id]]->sync_read_->isAvailable(id, address, data_length);
+}
+
+uint32_t BusManager::getData(uint8_t id, uint16_t address, uint16_t data_length)
+{
+  if (isAvailable(id, address, data_length) == false)
+    return 0;
+
+  return buses_[id_to_bus_[id]]->sync_read_->getData(id, address, data_length);
+}
+
+bool BusManager::getError(uint8_t id, uint8_t *error)
+{
+  if (id_to_bus_[id] == BUS_MANAGER_NO_BUS || read_length_ == 0)
+    return false;
+
+  return buses_[id_to_bus_[id]]->sync_read_->getError(id, error);
+}
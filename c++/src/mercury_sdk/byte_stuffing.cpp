@@ -0,0 +1,187 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "byte_stuffing.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "byte_stuffing.h"
+#endif
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BYTE_STUFFING_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+using namespace mercury;
+
+#if defined(BYTE_STUFFING_SSE2)
+static inline uint32_t lowestBit(uint32_t mask)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (uint32_t)index;
+#else
+  return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+// bit k is set when FF FF FD ends at data[k], data[-2] and data[-1] have to be readable
+static inline uint32_t headerEndMask(const uint8_t *data)
+{
+  const __m128i ff = _mm_set1_epi8((char)0xFF);
+  const __m128i fd = _mm_set1_epi8((char)0xFD);
+  __m128i header0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data - 2)), ff);
+  __m128i header1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data - 1)), ff);
+  __m128i header2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)data), fd);
+  return (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(header0, header1), header2));
+}
+#endif
+
+static inline bool isHeaderEnd(const uint8_t *data)
+{
+  return data[0] == 0xFD && data[-1] == 0xFF && data[-2] == 0xFF;
+}
+
+uint32_t ByteStuffing::find(const uint8_t *data, uint32_t length)
+{
+  uint32_t i = 2;   // end of the first FF FF FD
+
+#if defined(BYTE_STUFFING_SSE2)
+  for (; i + 16 <= length; i += 16)
+  {
+    uint32_t mask = headerEndMask(data + i);
+    if (mask != 0)
+      return i + lowestBit(mask) - 2;
+  }
+#endif
+
+  for (; i < length; i++)
+  {
+    if (isHeaderEnd(data + i))
+      return i - 2;
+  }
+
+  return length;
+}
+
+uint32_t ByteStuffing::count(const uint8_t *data, uint32_t length)
+{
+  uint32_t n = 0;
+  uint32_t i = 2;
+
+#if defined(BYTE_STUFFING_SSE2)
+  for (; i + 16 <= length; i += 16)
+  {
+    for (uint32_t mask = headerEndMask(data + i); mask != 0; mask &= mask - 1)
+      n++;
+  }
+#endif
+
+  for (; i < length; i++)
+  {
+    if (isHeaderEnd(data + i))
+      n++;
+  }
+
+  return n;
+}
+
+uint32_t ByteStuffing::stuff(const uint8_t *data, uint32_t length, uint8_t *stuffed)
+{
+  uint32_t out = 0;
+  uint32_t i = 0;
+
+  // the first two bytes can't end FF FF FD
+  for (; i < length && i < 2; i++)
+    stuffed[out++] = data[i];
+
+#if defined(BYTE_STUFFING_SSE2)
+  // blocks without FF FF FD are copied as they are
+  for (; i + 16 <= length; i += 16)
+  {
+    uint32_t mask = headerEndMask(data + i);
+    if (mask == 0)
+    {
+      _mm_storeu_si128((__m128i *)(stuffed + out), _mm_loadu_si128((const __m128i *)(data + i)));
+      out += 16;
+      continue;
+    }
+
+    for (uint32_t b = 0; b < 16; b++)
+    {
+      stuffed[out++] = data[i + b];
+      if (mask & (1u << b))
+        stuffed[out++] = 0xFD;
+    }
+  }
+#endif
+
+  for (; i < length; i++)
+  {
+    stuffed[out++] = data[i];
+    if (isHeaderEnd(data + i))
+      stuffed[out++] = 0xFD;
+  }
+
+  return out;
+}
+
+uint32_t ByteStuffing::unstuff(const uint8_t *data, uint32_t begin, uint32_t length, uint8_t *unstuffed)
+{
+  uint32_t out = 0;
+  uint32_t i = begin;
+
+  // the first three bytes can't follow FF FF FD
+  for (; i < length && i < 3; i++)
+    unstuffed[out++] = data[i];
+
+#if defined(BYTE_STUFFING_SSE2)
+  // blocks without stuffing are copied as they are
+  const __m128i fd = _mm_set1_epi8((char)0xFD);
+  for (; i + 16 <= length; i += 16)
+  {
+    __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+    uint32_t mask = headerEndMask(data + i - 1) & (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, fd));
+    if (mask == 0)
+    {
+      _mm_storeu_si128((__m128i *)(unstuffed + out), block);
+      out += 16;
+      continue;
+    }
+
+    for (uint32_t b = 0; b < 16; b++)
+    {
+      if ((mask & (1u << b)) == 0)
+        unstuffed[out++] = data[i + b];
+    }
+  }
+#endif
+
+  for (; i < length; i++)
+  {
+    if (data[i] != 0xFD || isHeaderEnd(data + i - 1) == false)
+      unstuffed[out++] = data[i];
+  }
+
+  return out;
+}
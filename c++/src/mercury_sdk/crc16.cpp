@@ -0,0 +1,237 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "crc16.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "crc16.h"
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC16_CLMUL
+#define CRC16_CLMUL_TARGET  __attribute__((target("pclmul,ssse3")))
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(_M_X64)
+#define CRC16_CLMUL
+#define CRC16_CLMUL_TARGET
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#define CRC16_POLYNOMIAL      0x18005 // x^16 + x^15 + x^2 + 1
+#define CRC16_CLMUL_MIN_SIZE  64      // shorter blocks are faster with the tables
+
+using namespace mercury;
+
+static const uint16_t crc_table[256] = {0x0000,
+  0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
+  0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027,
+  0x0022, 0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D,
+  0x8077, 0x0072, 0x0050, 0x8055, 0x805F, 0x005A, 0x804B,
+  0x004E, 0x0044, 0x8041, 0x80C3, 0x00C6, 0x00CC, 0x80C9,
+  0x00D8, 0x80DD, 0x80D7, 0x00D2, 0x00F0, 0x80F5, 0x80FF,
+  0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1, 0x00A0, 0x80A5,
+  0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1, 0x8093,
+  0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
+  0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197,
+  0x0192, 0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE,
+  0x01A4, 0x81A1, 0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB,
+  0x01FE, 0x01F4, 0x81F1, 0x81D3, 0x01D6, 0x01DC, 0x81D9,
+  0x01C8, 0x81CD, 0x81C7, 0x01C2, 0x0140, 0x8145, 0x814F,
+  0x014A, 0x815B, 0x015E, 0x0154, 0x8151, 0x8173, 0x0176,
+  0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162, 0x8123,
+  0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
+  0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104,
+  0x8101, 0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D,
+  0x8317, 0x0312, 0x0330, 0x8335, 0x833F, 0x033A, 0x832B,
+  0x032E, 0x0324, 0x8321, 0x0360, 0x8365, 0x836F, 0x036A,
+  0x837B, 0x037E, 0x0374, 0x8371, 0x8353, 0x0356, 0x035C,
+  0x8359, 0x0348, 0x834D, 0x8347, 0x0342, 0x03C0, 0x83C5,
+  0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1, 0x83F3,
+  0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
+  0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7,
+  0x03B2, 0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E,
+  0x0384, 0x8381, 0x0280, 0x8285, 0x828F, 0x028A, 0x829B,
+  0x029E, 0x0294, 0x8291, 0x82B3, 0x02B6, 0x02BC, 0x82B9,
+  0x02A8, 0x82AD, 0x82A7, 0x02A2, 0x82E3, 0x02E6, 0x02EC,
+  0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2, 0x02D0, 0x82D5,
+  0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1, 0x8243,
+  0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
+  0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264,
+  0x8261, 0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E,
+  0x0234, 0x8231, 0x8213, 0x0216, 0x021C, 0x8219, 0x0208,
+  0x820D, 0x8207, 0x0202 };
+
+// crc_table[b] continued over k zero bytes, for slice-by-8 and the constants of the carry-less folding
+struct Crc16Tables
+{
+  uint16_t slice[8][256];
+  uint16_t x128;  // x^128 mod P
+  uint16_t x192;  // x^192 mod P
+  Crc16::Engine engine;
+
+  Crc16Tables()
+  {
+    for (int b = 0; b < 256; b++)
+    {
+      slice[0][b] = crc_table[b];
+      for (int k = 1; k < 8; k++)
+        slice[k][b] = (slice[k - 1][b] << 8) ^ crc_table[slice[k - 1][b] >> 8];
+    }
+
+    x128 = powerOfX(128);
+    x192 = powerOfX(192);
+    engine = hasClmul() ? Crc16::ENGINE_CLMUL : Crc16::ENGINE_SLICE8;
+  }
+
+  static uint16_t powerOfX(int n)
+  {
+    uint32_t r = 1;
+    for (int i = 0; i < n; i++)
+    {
+      r <<= 1;
+      if (r & 0x10000)
+        r ^= CRC16_POLYNOMIAL;
+    }
+    return (uint16_t)r;
+  }
+
+  static bool hasClmul()
+  {
+#if defined(CRC16_CLMUL) && defined(_M_X64)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) && (info[2] & (1 << 9));    // PCLMULQDQ, SSSE3
+#elif defined(CRC16_CLMUL)
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+      return false;
+    return (ecx & bit_PCLMUL) && (ecx & bit_SSSE3);
+#else
+    return false;
+#endif
+  }
+};
+
+static const Crc16Tables &getTables()
+{
+  static const Crc16Tables tables;
+  return tables;
+}
+
+static uint16_t updateTable(uint16_t crc_accum, const uint8_t *data_blk_ptr, uint32_t data_blk_size)
+{
+  uint16_t i;
+
+  for (uint32_t j = 0; j < data_blk_size; j++)
+  {
+    i = ((uint16_t)(crc_accum >> 8) ^ *data_blk_ptr++) & 0xFF;
+    crc_accum = (crc_accum << 8) ^ crc_table[i];
+  }
+
+  return crc_accum;
+}
+
+// the CRC goes into the first two bytes of each 8, every byte is then looked up continued over the bytes after it
+static uint16_t updateSlice8(uint16_t crc_accum, const uint8_t *data_blk_ptr, uint32_t data_blk_size)
+{
+  const uint16_t (*slice)[256] = getTables().slice;
+
+  while (data_blk_size >= 8)
+  {
+    const uint8_t *p = data_blk_ptr;
+    crc_accum = slice[7][p[0] ^ (crc_accum >> 8)] ^ slice[6][p[1] ^ (crc_accum & 0xFF)] ^
+                slice[5][p[2]] ^ slice[4][p[3]] ^ slice[3][p[4]] ^ slice[2][p[5]] ^
+                slice[1][p[6]] ^ slice[0][p[7]];
+    data_blk_ptr  += 8;
+    data_blk_size -= 8;
+  }
+
+  return updateTable(crc_accum, data_blk_ptr, data_blk_size);
+}
+
+#if defined(CRC16_CLMUL)
+// the bytes are loaded most significant first, so that bit i of a block is the coefficient of x^i;
+// the leading 128 bits V are folded into the next block as V * x^128 = high * (x^192 mod P) + low * (x^128 mod P)
+// and the CRC of the last V, a polynomial of the same remainder as the bytes before it, is taken with the tables
+CRC16_CLMUL_TARGET
+static uint16_t updateClmul(uint16_t crc_accum, const uint8_t *data_blk_ptr, uint32_t data_blk_size)
+{
+  const Crc16Tables &tables = getTables();
+  const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const __m128i fold    = _mm_set_epi64x(tables.x192, tables.x128);
+
+  __m128i value = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data_blk_ptr), reverse);
+  value = _mm_xor_si128(value, _mm_set_epi64x((long long)((uint64_t)crc_accum << 48), 0));
+  data_blk_ptr  += 16;
+  data_blk_size -= 16;
+
+  while (data_blk_size >= 16)
+  {
+    __m128i block = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data_blk_ptr), reverse);
+    value = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(value, fold, 0x11), _mm_clmulepi64_si128(value, fold, 0x00)), block);
+    data_blk_ptr  += 16;
+    data_blk_size -= 16;
+  }
+
+  uint8_t rest[16];
+  _mm_storeu_si128((__m128i *)rest, _mm_shuffle_epi8(value, reverse));
+
+  return updateSlice8(updateSlice8(0, rest, 16), data_blk_ptr, data_blk_size);
+}
+#endif
+
+uint16_t Crc16::update(uint16_t crc_accum, const uint8_t *data_blk_ptr, uint16_t data_blk_size)
+{
+  if (data_blk_size < CRC16_CLMUL_MIN_SIZE)
+    return updateSlice8(crc_accum, data_blk_ptr, data_blk_size);
+
+  return update(getTables().engine, crc_accum, data_blk_ptr, data_blk_size);
+}
+
+uint16_t Crc16::update(Engine engine, uint16_t crc_accum, const uint8_t *data_blk_ptr, uint16_t data_blk_size)
+{
+  switch (engine)
+  {
+    case ENGINE_TABLE:
+      return updateTable(crc_accum, data_blk_ptr, data_blk_size);
+
+#if defined(CRC16_CLMUL)
+    case ENGINE_CLMUL:
+      if (getTables().engine == ENGINE_CLMUL && data_blk_size >= 16)
+        return updateClmul(crc_accum, data_blk_ptr, data_blk_size);
+      return updateSlice8(crc_accum, data_blk_ptr, data_blk_size);
+#endif
+
+    default:
+      return updateSlice8(crc_accum, data_blk_ptr, data_blk_size);
+  }
+}
+
+Crc16::Engine Crc16::getEngine()
+{
+  return getTables().engine;
+}
+
+uint16_t Crc16::extend(uint16_t crc_accum, uint32_t zero_count)
+{
+  for (uint32_t j = 0; j < zero_count; j++)
+    crc_accum = (crc_accum << 8) ^ crc_table[crc_accum >> 8];
+
+  return crc_accum;
+}
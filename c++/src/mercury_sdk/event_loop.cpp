@@ -0,0 +1,306 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "event_loop.h"
+#include "monotonic_clock.h"
+
+#define EVENT_LOOP_MAX_EVENTS   16
+
+using namespace mercury;
+
+EventLoop::EventLoop()
+  : epoll_fd_(-1),
+    timer_fd_(-1),
+    timer_deadline_(0),
+    ready_head_(0),
+    ready_tail_(0),
+    reader_count_(0),
+    is_stopped_(false)
+{
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);   // the clock of MonotonicClock
+
+  // the timer is the event without a port
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events   = EPOLLIN;
+  event.data.ptr = 0;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &event);
+}
+
+EventLoop::~EventLoop()
+{
+  for (unsigned int i = 0; i < ports_.size(); i++)
+    delete ports_[i];
+
+  if (timer_fd_ != -1)
+    close(timer_fd_);
+  if (epoll_fd_ != -1)
+    close(epoll_fd_);
+}
+
+EventLoop::PortEntry *EventLoop::getEntry(PortHandler *port)
+{
+  for (unsigned int i = 0; i < ports_.size(); i++)
+  {
+    if (ports_[i]->port == port)
+      return ports_[i];
+  }
+
+  if (addPort(port) == false)
+    return 0;
+  return ports_.back();
+}
+
+bool EventLoop::addPort(PortHandler *port)
+{
+  for (unsigned int i = 0; i < ports_.size(); i++)
+  {
+    if (ports_[i]->port == port)
+      return true;
+  }
+
+  PortEntry *entry  = new PortEntry;
+  entry->port       = port;
+  entry->descriptor = port->getPortDescriptor();
+  entry->is_locked  = false;
+  entry->lock_head  = 0;
+  entry->lock_tail  = 0;
+  entry->reader     = 0;
+  entry->deadline   = 0;
+
+  // the port is armed one shot at a time by waitPort(), bytes which nobody waits for don't wake the loop
+  if (entry->descriptor != -1)
+  {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLONESHOT;
+    event.data.ptr = entry;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, entry->descriptor, &event) != 0)
+    {
+      delete entry;
+      return false;
+    }
+  }
+
+  ports_.push_back(entry);
+  return true;
+}
+
+void EventLoop::removePort(PortHandler *port)
+{
+  for (unsigned int i = 0; i < ports_.size(); i++)
+  {
+    if (ports_[i]->port != port)
+      continue;
+
+    if (ports_[i]->descriptor != -1)
+      epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, ports_[i]->descriptor, 0);
+
+    delete ports_[i];
+    ports_.erase(ports_.begin() + i);
+    return;
+  }
+}
+
+bool EventLoop::lockPort(PortHandler *port, Waiter *waiter)
+{
+  PortEntry *entry = getEntry(port);
+  if (entry == 0)
+    return true;    // not watched, nothing to share
+
+  if (entry->is_locked == false)
+  {
+    entry->is_locked = true;
+    return true;
+  }
+
+  waiter->next_ = 0;
+  if (entry->lock_tail != 0)
+    entry->lock_tail->next_ = waiter;
+  else
+    entry->lock_head = waiter;
+  entry->lock_tail = waiter;
+  return false;
+}
+
+void EventLoop::unlockPort(PortHandler *port)
+{
+  PortEntry *entry = getEntry(port);
+  if (entry == 0)
+    return;
+
+  // the lock passes straight to the next waiter, so nobody can take it in between
+  Waiter *waiter = entry->lock_head;
+  if (waiter == 0)
+  {
+    entry->is_locked = false;
+    return;
+  }
+
+  entry->lock_head = waiter->next_;
+  if (entry->lock_head == 0)
+    entry->lock_tail = 0;
+  post(waiter);
+}
+
+bool EventLoop::waitPort(PortHandler *port, Waiter *waiter)
+{
+  PortEntry *entry = getEntry(port);
+  if (entry == 0 || entry->reader != 0)
+    return false;
+
+  // the deadline of a port on its own clock means nothing to the loop, the port moves its clock on by itself
+  if (port->isClockVirtual() == true)
+  {
+    port->waitPort();
+    post(waiter);
+    return true;
+  }
+
+  if (entry->descriptor != -1)
+  {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN | EPOLLONESHOT;
+    event.data.ptr = entry;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, entry->descriptor, &event) != 0)
+      return false;
+  }
+
+  entry->reader   = waiter;
+  entry->deadline = port->getPacketDeadline();
+  reader_count_++;
+  return true;
+}
+
+void EventLoop::post(Waiter *waiter)
+{
+  waiter->next_ = 0;
+  if (ready_tail_ != 0)
+    ready_tail_->next_ = waiter;
+  else
+    ready_head_ = waiter;
+  ready_tail_ = waiter;
+}
+
+void EventLoop::wake(PortEntry *entry)
+{
+  Waiter *waiter = entry->reader;
+  entry->reader = 0;
+  reader_count_--;
+  post(waiter);
+}
+
+void EventLoop::armTimer(int64_t deadline)
+{
+  if (deadline == timer_deadline_)
+    return;
+
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  spec.it_value.tv_sec  = (time_t)(deadline / MonotonicClock::NSEC_PER_SEC);
+  spec.it_value.tv_nsec = (long)(deadline % MonotonicClock::NSEC_PER_SEC);
+  timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, 0);   // a zero deadline disarms it
+  timer_deadline_ = deadline;
+}
+
+void EventLoop::run()
+{
+  struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+
+  is_stopped_ = false;
+  while (is_stopped_ == false)
+  {
+    // resume everything which is ready, the waiters it posts are resumed on the next pass
+    Waiter *waiter = ready_head_;
+    ready_head_ = ready_tail_ = 0;
+    while (waiter != 0)
+    {
+      Waiter *next = waiter->next_;
+      waiter->resume();
+      waiter = next;
+    }
+
+    if (ready_head_ != 0)
+      continue;
+    if (reader_count_ == 0)
+      break;
+
+    // wake the readers whose packet timeout has expired, and find the next timeout
+    int64_t now           = MonotonicClock::getTime();
+    int64_t next_deadline = INT64_MAX;
+    bool    is_polling    = false;
+    for (unsigned int i = 0; i < ports_.size(); i++)
+    {
+      PortEntry *entry = ports_[i];
+      if (entry->reader == 0)
+        continue;
+
+      if (entry->deadline <= now)
+        wake(entry);
+      else if (entry->descriptor == -1)
+        is_polling = true;
+      else if (entry->deadline < next_deadline)
+        next_deadline = entry->deadline;
+    }
+
+    if (ready_head_ != 0)
+      continue;
+
+    int timeout = -1;
+    if (is_polling == true)
+      timeout = 0;
+    else if (next_deadline != INT64_MAX)
+      armTimer(next_deadline);
+
+    int count = epoll_wait(epoll_fd_, events, EVENT_LOOP_MAX_EVENTS, timeout);
+    for (int i = 0; i < count; i++)
+    {
+      PortEntry *entry = (PortEntry *)events[i].data.ptr;
+      if (entry == 0)
+      {
+        uint64_t expirations;
+        if (read(timer_fd_, &expirations, sizeof(expirations)) > 0)
+          timer_deadline_ = 0;
+        continue;
+      }
+
+      if (entry->reader != 0)
+        wake(entry);
+    }
+
+    // ports without a descriptor are checked again by their reader
+    if (is_polling == true)
+    {
+      for (unsigned int i = 0; i < ports_.size(); i++)
+      {
+        if (ports_[i]->reader != 0 && ports_[i]->descriptor == -1)
+          wake(ports_[i]);
+      }
+    }
+  }
+}
+
+#endif
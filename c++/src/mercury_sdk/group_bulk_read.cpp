@@ -0,0 +1,227 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "../../include/mercury_sdk/group_bulk_read.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "group_bulk_read.h"
+#endif
+
+using namespace mercury;
+
+GroupBulkRead::GroupBulkRead(PortHandler *port, PacketHandler *ph)
+  : GroupHandler(port, ph),
+    is_fast_read_(false),
+    is_fast_read_sent_(false)
+{
+  clearParam();
+}
+
+void GroupBulkRead::makeParam()
+{
+  if (id_list_.size() == 0)
+    return;
+
+  param_list_.resize(id_list_.size() * 5);    // ID(1) + ADDR(2) + LENGTH(2)
+
+  rx_data_list_.resize(id_list_.size());
+  rx_error_list_.resize(id_list_.size());
+
+  int idx = 0;
+  for (unsigned int i = 0; i < id_list_.size(); i++)
+  {
+    param_list_[idx++] = id_list_[i];                   // ID
+    param_list_[idx++] = MCY_LOBYTE(address_list_[i]);  // ADDR_L
+    param_list_[idx++] = MCY_HIBYTE(address_list_[i]);  // ADDR_H
+    param_list_[idx++] = MCY_LOBYTE(slot_length_[i]);   // LEN_L
+    param_list_[idx++] = MCY_HIBYTE(slot_length_[i]);   // LEN_H
+
+    rx_data_list_[i] = getSlotData(i);
+    rx_error_list_[i] = &error_list_[i];
+  }
+
+  is_param_changed_   = false;
+}
+
+// the slots changed after the instruction packet was sent, so its status packets are received
+// for the IDs and lengths of the parameter it carried, and dropped
+int GroupBulkRead::dropRx()
+{
+  uint16_t cnt = (uint16_t)(param_list_.size() / 5);
+  if (cnt == 0)
+    return COMM_NOT_AVAILABLE;
+
+  std::vector<uint8_t> id_list(cnt);
+  std::vector<uint16_t> length_list(cnt);
+  std::vector<uint8_t *> data_list(cnt);
+  std::vector<int> result_list(cnt);
+  size_t total_length = 0;
+  for (uint16_t i = 0; i < cnt; i++)
+  {
+    id_list[i] = param_list_[i * 5];
+    length_list[i] = MCY_MAKEWORD(param_list_[i * 5 + 3], param_list_[i * 5 + 4]);
+    total_length += length_list[i];
+  }
+
+  std::vector<uint8_t> data(total_length + 1);
+  for (uint16_t i = 0, idx = 0; i < cnt; idx += length_list[i], i++)
+    data_list[i] = &data[idx];
+
+  if (is_fast_read_sent_ == true)
+    ph_->fastBulkReadRx(port_, &id_list[0], cnt, &length_list[0], &data_list[0], 0, &result_list[0]);
+  else
+    ph_->bulkReadRx(port_, &id_list[0], cnt, &length_list[0], &data_list[0], 0, &result_list[0]);
+
+  return COMM_NOT_AVAILABLE;
+}
+
+bool GroupBulkRead::addParam(uint8_t id, uint16_t start_address, uint16_t data_length)
+{
+  if (addSlot(id, data_length) == false)   // id already exist
+    return false;
+
+  address_list_.push_back(start_address);
+  error_list_.push_back(0);
+
+  rx_result_list_.clear();
+  is_param_changed_   = true;
+  return true;
+}
+
+void GroupBulkRead::removeParam(uint8_t id)
+{
+  int slot = removeSlot(id);
+  if (slot < 0)    // NOT exist
+    return;
+
+  address_list_.erase(address_list_.begin() + slot);
+  error_list_.erase(error_list_.begin() + slot);
+
+  rx_result_list_.clear();
+  is_param_changed_   = true;
+}
+
+void GroupBulkRead::clearParam()
+{
+  clearSlots();
+  address_list_.clear();
+  error_list_.clear();
+  rx_result_list_.clear();
+  is_param_changed_   = true;
+}
+
+int GroupBulkRead::txPacket()
+{
+  if (id_list_.size() == 0)
+    return COMM_NOT_AVAILABLE;
+
+  if (is_param_changed_ == true || param_list_.empty())
+    makeParam();
+
+  is_fast_read_sent_ = is_fast_read_;
+  if (is_fast_read_sent_ == true)
+    return ph_->fastBulkReadTx(port_, &param_list_[0], (uint16_t)param_list_.size());
+
+  return ph_->bulkReadTx(port_, &param_list_[0], (uint16_t)param_list_.size());
+}
+
+int GroupBulkRead::rxPacket()
+{
+  int cnt            = id_list_.size();
+  int result         = COMM_RX_FAIL;
+
+  if (is_param_changed_ == true)
+    return dropRx();
+
+  if (cnt == 0)
+    return COMM_NOT_AVAILABLE;
+
+  rx_result_list_.resize(cnt);
+  if (is_fast_read_sent_ == true)
+    result = ph_->fastBulkReadRx(port_, &id_list_[0], (uint16_t)cnt, &slot_length_[0], &rx_data_list_[0], &rx_error_list_[0], &rx_result_list_[0]);
+  else
+    result = ph_->bulkReadRx(port_, &id_list_[0], (uint16_t)cnt, &slot_length_[0], &rx_data_list_[0], &rx_error_list_[0], &rx_result_list_[0]);
+
+  return result;
+}
+
+int GroupBulkRead::txRxPacket()
+{
+  int result         = COMM_TX_FAIL;
+
+  result = txPacket();
+  if (result != COMM_SUCCESS)
+    return result;
+
+  return rxPacket();
+}
+
+bool GroupBulkRead::isAvailable(uint8_t id, uint16_t address, uint16_t data_length)
+{
+  if (getResult(id) != COMM_SUCCESS)
+    return false;
+
+  int slot = id_to_slot_[id];
+  uint16_t start_addr = address_list_[slot];
+
+  if (address < start_addr || start_addr + slot_length_[slot] - data_length < address)
+    return false;
+
+  return true;
+}
+
+int GroupBulkRead::getResult(uint8_t id)
+{
+  int slot = findSlot(id);
+  if (slot < 0 || (size_t)slot >= rx_result_list_.size())
+    return COMM_NOT_AVAILABLE;
+
+  return rx_result_list_[slot];
+}
+
+uint32_t GroupBulkRead::getData(uint8_t id, uint16_t address, uint16_t data_length)
+{
+  if (isAvailable(id, address, data_length) == false)
+    return 0;
+
+  int slot = id_to_slot_[id];
+  uint8_t *data = getSlotData(slot) + (address - address_list_[slot]);
+
+  switch(data_length)
+  {
+    case 1:
+      return data[0];
+
+    case 2:
+      return MCY_MAKEWORD(data[0], data[1]);
+
+    case 4:
+      return MCY_MAKEDWORD(MCY_MAKEWORD(data[0], data[1]), MCY_MAKEWORD(data[2], data[3]));
+
+    default:
+      return 0;
+  }
+}
+
+bool GroupBulkRead::getError(uint8_t id, uint8_t* error)
+{
+  int slot = findSlot(id);
+  if (slot < 0)
+    return false;
+
+  return (error[0] = error_list_[slot]);
+}
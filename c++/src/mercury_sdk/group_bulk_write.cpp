@@ -0,0 +1,89 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "../../include/mercury_sdk/group_bulk_write.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "group_bulk_write.h"
+#endif
+
+using namespace mercury;
+
+GroupBulkWrite::GroupBulkWrite(PortHandler *port, PacketHandler *ph)
+  : GroupHandler(port, ph)
+{
+  clearParam();
+}
+
+// each slot holds ID(1) + ADDR(2) + LENGTH(2) + DATA(data_length), so the slots in a row are the Bulk Write parameter
+
+bool GroupBulkWrite::addParam(uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data)
+{
+  if (addSlot(id, 5 + data_length) == false)   // id already exist
+    return false;
+
+  uint8_t *slot_data = getSlotData(id_to_slot_[id]);
+  slot_data[0] = id;
+  slot_data[1] = MCY_LOBYTE(start_address);
+  slot_data[2] = MCY_HIBYTE(start_address);
+  slot_data[3] = MCY_LOBYTE(data_length);
+  slot_data[4] = MCY_HIBYTE(data_length);
+  for (int c = 0; c < data_length; c++)
+    slot_data[5 + c] = data[c];
+
+  return true;
+}
+
+void GroupBulkWrite::removeParam(uint8_t id)
+{
+  removeSlot(id);
+}
+
+bool GroupBulkWrite::changeParam(uint8_t id, uint16_t start_address, uint16_t data_length, uint8_t *data)
+{
+  int slot = findSlot(id);
+  if (slot < 0)    // NOT exist
+    return false;
+
+  // a slot of another length is moved to the end, the order of a Bulk Write does not matter
+  if (slot_length_[slot] != 5 + data_length)
+  {
+    removeSlot(id);
+    return addParam(id, start_address, data_length, data);
+  }
+
+  uint8_t *slot_data = getSlotData(slot);
+  slot_data[1] = MCY_LOBYTE(start_address);
+  slot_data[2] = MCY_HIBYTE(start_address);
+  for (int c = 0; c < data_length; c++)
+    slot_data[5 + c] = data[c];
+
+  return true;
+}
+
+void GroupBulkWrite::clearParam()
+{
+  clearSlots();
+}
+
+int GroupBulkWrite::txPacket()
+{
+  if (id_list_.size() == 0)
+    return COMM_NOT_AVAILABLE;
+
+  return ph_->bulkWriteTxOnly(port_, data_, (uint16_t)data_size_);
+}
@@ -27,13 +27,95 @@
 #include "../../include/mercury_sdk/group_handler.h"
 #endif
 
+#include <string.h>
+
 using namespace mercury;
 
 GroupHandler::GroupHandler(PortHandler *port, PacketHandler *ph)
  : port_(port),
    ph_(ph),
+   data_(0),
+   data_size_(0),
+   frame_head_(0),
+   frame_tail_(0),
    is_param_changed_(false),
-   param_(0)
+   data_buffer_(0),
+   data_capacity_(0)
+{
+  memset(id_to_slot_, GROUP_NO_SLOT, sizeof(id_to_slot_));
+}
+
+GroupHandler::~GroupHandler()
+{
+  if (data_buffer_ != 0)
+    delete[] data_buffer_;
+}
+
+bool GroupHandler::addSlot(uint8_t id, uint16_t length)
+{
+  if (id_to_slot_[id] != GROUP_NO_SLOT || id_list_.size() >= GROUP_NO_SLOT)
+    return false;
+
+  if (data_size_ + length > data_capacity_)
+  {
+    uint32_t capacity = (data_capacity_ < GROUP_DATA_ALIGNMENT) ? GROUP_DATA_ALIGNMENT : data_capacity_ * 2;
+    while (capacity < data_size_ + length)
+      capacity *= 2;
+
+    uint8_t *buffer = new uint8_t[frame_head_ + capacity + frame_tail_ + GROUP_DATA_ALIGNMENT - 1];
+    uint8_t *data = (uint8_t *)(((uintptr_t)buffer + frame_head_ + GROUP_DATA_ALIGNMENT - 1) & ~(uintptr_t)(GROUP_DATA_ALIGNMENT - 1));
+    if (data_ != 0)
+      memcpy(data - frame_head_, data_ - frame_head_, frame_head_ + data_size_);
+
+    if (data_buffer_ != 0)
+      delete[] data_buffer_;
+    data_buffer_    = buffer;
+    data_           = data;
+    data_capacity_  = capacity;
+  }
+
+  id_to_slot_[id] = (uint8_t)id_list_.size();
+  id_list_.push_back(id);
+  slot_offset_.push_back(data_size_);
+  slot_length_.push_back(length);
+  memset(data_ + data_size_, 0, length);
+  data_size_ += length;
+
+  return true;
+}
+
+int GroupHandler::removeSlot(uint8_t id)
+{
+  int slot = findSlot(id);
+  if (slot < 0)
+    return -1;
+
+  uint16_t length = slot_length_[slot];
+  uint32_t end    = slot_offset_[slot] + length;
+  memmove(data_ + slot_offset_[slot], data_ + end, data_size_ - end);
+  data_size_ -= length;
+
+  id_list_.erase(id_list_.begin() + slot);
+  slot_offset_.erase(slot_offset_.begin() + slot);
+  slot_length_.erase(slot_length_.begin() + slot);
+  id_to_slot_[id] = GROUP_NO_SLOT;
+
+  for (unsigned int i = slot; i < id_list_.size(); i++)
+  {
+    slot_offset_[i] -= length;
+    id_to_slot_[id_list_[i]] = (uint8_t)i;
+  }
+
+  return slot;
+}
+
+void GroupHandler::clearSlots()
 {
+  for (unsigned int i = 0; i < id_list_.size(); i++)
+    id_to_slot_[id_list_[i]] = GROUP_NO_SLOT;
 
+  id_list_.clear();
+  slot_offset_.clear();
+  slot_length_.clear();
+  data_size_ = 0;
 }
@@ -33,7 +33,8 @@ using namespace mercury;
 
 GroupSyncRead::GroupSyncRead(PortHandler *port, PacketHandler *ph, uint16_t start_address, uint16_t data_length)
   : GroupHandler(port, ph),
-    last_result_(false),
+    is_fast_read_(false),
+    is_fast_read_sent_(false),
     start_address_(start_address),
     data_length_(data_length)
 {
@@ -45,15 +46,44 @@ void GroupSyncRead::makeParam()
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return;
 
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  if (is_fast_read_ == true)
+    prepared_.prepareFastSyncRead(start_address_, data_length_, &id_list_[0], (uint16_t)id_list_.size());
+  else
+    prepared_.prepareSyncRead(start_address_, data_length_, &id_list_[0], (uint16_t)id_list_.size());
 
-  param_ = new uint8_t[id_list_.size() * 1];  // ID(1)
-
-  int idx = 0;
+  // the parameter is the ID list itself, only the pointers into the slots are refreshed
+  rx_data_list_.resize(id_list_.size());
+  rx_error_list_.resize(id_list_.size());
   for (unsigned int i = 0; i < id_list_.size(); i++)
-    param_[idx++] = id_list_[i];
+  {
+    rx_data_list_[i] = getSlotData(i);
+    rx_error_list_[i] = &error_list_[i];
+  }
+  prepared_id_list_ = id_list_;
+
+  is_param_changed_   = false;
+}
+
+// the slots changed after the instruction packet was sent, so its status packets are received
+// for the IDs it was framed with, and dropped
+int GroupSyncRead::dropRx()
+{
+  uint16_t cnt = (uint16_t)prepared_id_list_.size();
+  if (cnt == 0)
+    return COMM_NOT_AVAILABLE;
+
+  std::vector<uint8_t> data(cnt * data_length_ + 1);
+  std::vector<uint8_t *> data_list(cnt);
+  std::vector<int> result_list(cnt);
+  for (uint16_t i = 0; i < cnt; i++)
+    data_list[i] = &data[i * data_length_];
+
+  if (is_fast_read_sent_ == true)
+    ph_->fastSyncReadRx(port_, data_length_, &prepared_id_list_[0], cnt, &data_list[0], 0, &result_list[0]);
+  else
+    ph_->syncReadRx(port_, data_length_, &prepared_id_list_[0], cnt, &data_list[0], 0, &result_list[0]);
+
+  return COMM_NOT_AVAILABLE;
 }
 
 bool GroupSyncRead::addParam(uint8_t id)
@@ -61,13 +91,12 @@ bool GroupSyncRead::addParam(uint8_t id)
   if (ph_->getProtocolVersion() == 1.0)
     return false;
 
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (addSlot(id, data_length_) == false)   // id already exist
     return false;
 
-  id_list_.push_back(id);
-  data_list_[id] = new uint8_t[data_length_];
-  error_list_[id] = new uint8_t[1];
+  error_list_.push_back(0);
 
+  rx_result_list_.clear();
   is_param_changed_   = true;
   return true;
 }
@@ -76,16 +105,13 @@ void GroupSyncRead::removeParam(uint8_t id)
   if (ph_->getProtocolVersion() == 1.0)
     return;
 
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  int slot = removeSlot(id);
+  if (slot < 0)    // NOT exist
     return;
 
-  id_list_.erase(it);
-  delete[] data_list_[id];
-  delete[] error_list_[id];
-  data_list_.erase(id);
-  error_list_.erase(id);
+  error_list_.erase(error_list_.begin() + slot);
 
+  rx_result_list_.clear();
   is_param_changed_   = true;
 }
 void GroupSyncRead::clearParam()
@@ -93,18 +119,10 @@ void GroupSyncRead::clearParam()
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return;
 
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-  {
-    delete[] data_list_[id_list_[i]];
-    delete[] error_list_[id_list_[i]];
-  }
-
-  id_list_.clear();
-  data_list_.clear();
+  clearSlots();
   error_list_.clear();
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  rx_result_list_.clear();
+  is_param_changed_   = true;
 }
 
 int GroupSyncRead::txPacket()
@@ -112,36 +130,35 @@ int GroupSyncRead::txPacket()
   if (ph_->getProtocolVersion() == 1.0 || id_list_.size() == 0)
     return COMM_NOT_AVAILABLE;
 
-  if (is_param_changed_ == true || param_ == 0)
+  if (is_param_changed_ == true || prepared_.getInstruction() != (is_fast_read_ ? INST_FAST_SYNC_READ : INST_SYNC_READ))
     makeParam();
 
-  return ph_->syncReadTx(port_, start_address_, data_length_, param_, (uint16_t)id_list_.size() * 1);
+  if (prepared_.isPrepared() == false)   // the packet or its answer doesn't fit in the buffers
+    return COMM_TX_ERROR;
+
+  is_fast_read_sent_ = (prepared_.getInstruction() == INST_FAST_SYNC_READ);
+  return ph_->txPreparedPacket(port_, &prepared_);
 }
 
 int GroupSyncRead::rxPacket()
 {
-  last_result_ = false;
-
   if (ph_->getProtocolVersion() == 1.0)
     return COMM_NOT_AVAILABLE;
 
   int cnt            = id_list_.size();
   int result         = COMM_RX_FAIL;
 
+  if (is_param_changed_ == true)
+    return dropRx();
+
   if (cnt == 0)
     return COMM_NOT_AVAILABLE;
 
-  for (int i = 0; i < cnt; i++)
-  {
-    uint8_t id = id_list_[i];
-
-    result = ph_->readRx(port_, id, data_length_, data_list_[id], error_list_[id]);
-    if (result != COMM_SUCCESS)
-      return result;
-  }
-
-  if (result == COMM_SUCCESS)
-    last_result_ = true;
+  rx_result_list_.resize(cnt);
+  if (is_fast_read_sent_ == true)
+    result = ph_->fastSyncReadRx(port_, data_length_, &id_list_[0], (uint16_t)cnt, &rx_data_list_[0], &rx_error_list_[0], &rx_result_list_[0]);
+  else
+    result = ph_->syncReadRx(port_, data_length_, &id_list_[0], (uint16_t)cnt, &rx_data_list_[0], &rx_error_list_[0], &rx_result_list_[0]);
 
   return result;
 }
@@ -162,7 +179,7 @@ int GroupSyncRead::txRxPacket()
 
 bool GroupSyncRead::isAvailable(uint8_t id, uint16_t address, uint16_t data_length)
 {
-  if (ph_->getProtocolVersion() == 1.0 || last_result_ == false || data_list_.find(id) == data_list_.end())
+  if (ph_->getProtocolVersion() == 1.0 || getResult(id) != COMM_SUCCESS)
     return false;
 
   if (address < start_address_ || start_address_ + data_length_ - data_length < address)
@@ -171,22 +188,32 @@ bool GroupSyncRead::isAvailable(uint8_t id, uint16_t address, uint16_t data_leng
   return true;
 }
 
+int GroupSyncRead::getResult(uint8_t id)
+{
+  int slot = findSlot(id);
+  if (slot < 0 || (size_t)slot >= rx_result_list_.size())
+    return COMM_NOT_AVAILABLE;
+
+  return rx_result_list_[slot];
+}
+
 uint32_t GroupSyncRead::getData(uint8_t id, uint16_t address, uint16_t data_length)
 {
   if (isAvailable(id, address, data_length) == false)
     return 0;
 
+  uint8_t *data = getSlotData(id_to_slot_[id]) + (address - start_address_);
+
   switch(data_length)
   {
     case 1:
-      return data_list_[id][address - start_address_];
+      return data[0];
 
     case 2:
-      return MCY_MAKEWORD(data_list_[id][address - start_address_], data_list_[id][address - start_address_ + 1]);
+      return MCY_MAKEWORD(data[0], data[1]);
 
     case 4:
-      return MCY_MAKEDWORD(MCY_MAKEWORD(data_list_[id][address - start_address_ + 0], data_list_[id][address - start_address_ + 1]),
-                 MCY_MAKEWORD(data_list_[id][address - start_address_ + 2], data_list_[id][address - start_address_ + 3]));
+      return MCY_MAKEDWORD(MCY_MAKEWORD(data[0], data[1]), MCY_MAKEWORD(data[2], data[3]));
 
     default:
       return 0;
@@ -195,5 +222,9 @@ uint32_t GroupSyncRead::getData(uint8_t id, uint16_t address, uint16_t data_leng
 
 bool GroupSyncRead::getError(uint8_t id, uint8_t* error)
 {
-  return (error[0] = error_list_[id][0]);
+  int slot = findSlot(id);
+  if (slot < 0)
+    return false;
+
+  return (error[0] = error_list_[slot]);
 }
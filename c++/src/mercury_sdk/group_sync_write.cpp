@@ -29,94 +29,136 @@
 #include "../../include/mercury_sdk/group_sync_write.h"
 #endif
 
+#include <string.h>
+
+#include "byte_stuffing.h"
+#include "crc16.h"
+
+// HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H
+#define SYNC_WRITE_FRAME_HEAD   12
+#define SYNC_WRITE_FRAME_TAIL   2       // CRC16_L CRC16_H
+
 using namespace mercury;
 
 GroupSyncWrite::GroupSyncWrite(PortHandler *port, PacketHandler *ph, uint16_t start_address, uint16_t data_length)
   : GroupHandler(port, ph),
     start_address_(start_address),
-    data_length_(data_length)
+    data_length_(data_length),
+    stuffing_count_(0),
+    header_stuffing_(false),
+    first_dirty_slot_(0)
 {
+  frame_head_ = SYNC_WRITE_FRAME_HEAD;
+  frame_tail_ = SYNC_WRITE_FRAME_TAIL;
   clearParam();
 }
 
-void GroupSyncWrite::makeParam()
+// returns whether FF FF FD ends in packet[begin] ... packet[end - 1], begin has to be 2 or more
+static bool hasStuffing(const uint8_t *packet, uint32_t begin, uint32_t end)
 {
-  if (id_list_.size() == 0) return;
+  return ByteStuffing::find(packet + begin - 2, end - begin + 2) < end - begin + 2;
+}
 
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+void GroupSyncWrite::makeFrame()
+{
+  uint8_t *frame  = getFrame();
+  uint16_t length = (uint16_t)(data_size_ + 7);   // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
+
+  frame[0]  = 0xFF;
+  frame[1]  = 0xFF;
+  frame[2]  = 0xFD;
+  frame[3]  = 0x00;
+  frame[4]  = BROADCAST_ID;
+  frame[5]  = MCY_LOBYTE(length);
+  frame[6]  = MCY_HIBYTE(length);
+  frame[7]  = INST_SYNC_WRITE;
+  frame[8]  = MCY_LOBYTE(start_address_);
+  frame[9]  = MCY_HIBYTE(start_address_);
+  frame[10] = MCY_LOBYTE(data_length_);
+  frame[11] = MCY_HIBYTE(data_length_);
+
+  // byte stuffing starts after the instruction
+  header_stuffing_ = hasStuffing(frame, 10, SYNC_WRITE_FRAME_HEAD);
+
+  slot_crc_.resize(id_list_.size() + 1);
+  slot_crc_[0] = Crc16::update(0, frame, SYNC_WRITE_FRAME_HEAD);
+  slot_stuffing_.assign(id_list_.size(), 0);
+  stuffing_count_   = 0;
+  first_dirty_slot_ = 0;
+
+  is_param_changed_ = false;
+}
+
+void GroupSyncWrite::updateFrame()
+{
+  if (is_param_changed_ == true)
+    makeFrame();
 
-  param_ = new uint8_t[id_list_.size() * (1 + data_length_)]; // ID(1) + DATA(data_length)
+  uint8_t *frame = getFrame();
+  uint16_t crc   = slot_crc_[first_dirty_slot_];
 
-  int idx = 0;
-  for (unsigned int i = 0; i < id_list_.size(); i++)
+  // a change in a slot moves the CRC16 of every slot after it, and may stuff the first bytes of the next one
+  for (unsigned int i = first_dirty_slot_; i < id_list_.size(); i++)
   {
-    uint8_t id = id_list_[i];
-    if (data_list_[id] == 0)
-      return;
+    uint32_t begin = SYNC_WRITE_FRAME_HEAD + slot_offset_[i];
+    uint8_t stuffing = hasStuffing(frame, begin, begin + slot_length_[i]) ? 1 : 0;
+    stuffing_count_ += stuffing - slot_stuffing_[i];
+    slot_stuffing_[i] = stuffing;
 
-    param_[idx++] = id;
-    for (int c = 0; c < data_length_; c++)
-      param_[idx++] = (data_list_[id])[c];
+    crc = Crc16::update(crc, data_ + slot_offset_[i], slot_length_[i]);
+    slot_crc_[i + 1] = crc;
   }
+  first_dirty_slot_ = id_list_.size();
+
+  frame[SYNC_WRITE_FRAME_HEAD + data_size_ + 0] = MCY_LOBYTE(crc);
+  frame[SYNC_WRITE_FRAME_HEAD + data_size_ + 1] = MCY_HIBYTE(crc);
 }
 
+// each slot holds ID(1) + DATA(data_length), so the slots in a row are the Sync Write parameter
+
 bool GroupSyncWrite::addParam(uint8_t id, uint8_t *data)
 {
-  if (std::find(id_list_.begin(), id_list_.end(), id) != id_list_.end())   // id already exist
+  if (addSlot(id, 1 + data_length_) == false)   // id already exist
     return false;
 
-  id_list_.push_back(id);
-  data_list_[id]    = new uint8_t[data_length_];
+  uint8_t *slot_data = getSlotData(id_to_slot_[id]);
+  slot_data[0] = id;
   for (int c = 0; c < data_length_; c++)
-    data_list_[id][c] = data[c];
+    slot_data[1 + c] = data[c];
 
-  is_param_changed_   = true;
+  is_param_changed_ = true;
   return true;
 }
 
 void GroupSyncWrite::removeParam(uint8_t id)
 {
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  if (removeSlot(id) < 0)    // NOT exist
     return;
 
-  id_list_.erase(it);
-  delete[] data_list_[id];
-  data_list_.erase(id);
-
-  is_param_changed_   = true;
+  is_param_changed_ = true;
 }
 
 bool GroupSyncWrite::changeParam(uint8_t id, uint8_t *data)
 {
-  std::vector<uint8_t>::iterator it = std::find(id_list_.begin(), id_list_.end(), id);
-  if (it == id_list_.end())    // NOT exist
+  int slot = findSlot(id);
+  if (slot < 0)    // NOT exist
     return false;
 
-  delete[] data_list_[id];
-  data_list_[id]    = new uint8_t[data_length_];
-  for (int c = 0; c < data_length_; c++)
-    data_list_[id][c] = data[c];
+  uint8_t *slot_data = getSlotData(slot);
+  if (memcmp(slot_data + 1, data, data_length_) == 0)
+    return true;
+
+  memcpy(slot_data + 1, data, data_length_);
+  if ((unsigned int)slot < first_dirty_slot_)
+    first_dirty_slot_ = slot;
 
-  is_param_changed_   = true;
   return true;
 }
 
 void GroupSyncWrite::clearParam()
 {
-  if (id_list_.size() == 0)
-    return;
-
-  for (unsigned int i = 0; i < id_list_.size(); i++)
-    delete[] data_list_[id_list_[i]];
-
-  id_list_.clear();
-  data_list_.clear();
-  if (param_ != 0)
-    delete[] param_;
-  param_ = 0;
+  clearSlots();
+  is_param_changed_ = true;
 }
 
 int GroupSyncWrite::txPacket()
@@ -124,8 +166,11 @@ int GroupSyncWrite::txPacket()
   if (id_list_.size() == 0)
     return COMM_NOT_AVAILABLE;
 
-  if (is_param_changed_ == true || param_ == 0)
-    makeParam();
+  updateFrame();
+
+  // byte stuffing moves the bytes after it, so such a packet is built again by the packet handler
+  if (header_stuffing_ == true || stuffing_count_ > 0)
+    return ph_->syncWriteTxOnly(port_, start_address_, data_length_, data_, (uint16_t)data_size_);
 
-  return ph_->syncWriteTxOnly(port_, start_address_, data_length_, param_, id_list_.size() * (1 + data_length_));
+  return ph_->framedPacketTxOnly(port_, getFrame(), (uint16_t)(SYNC_WRITE_FRAME_HEAD + data_size_ + SYNC_WRITE_FRAME_TAIL));
 }
@@ -0,0 +1,126 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "latency_histogram.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "latency_histogram.h"
+#include <intrin.h>
+#endif
+
+#include "monotonic_clock.h"
+
+#define HALF_BUCKET_COUNT   (1 << (LatencyHistogram::SUB_BUCKET_BITS_ - 1))   // buckets per power of two
+
+using namespace mercury;
+
+static int getHighestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return (int)index;
+#else
+  return 63 - __builtin_clzll(value);
+#endif
+}
+
+// the bucket keeps the SUB_BUCKET_BITS_ highest bits of the value, the shift tells which power of two they belong to
+static int getBucket(uint64_t usec)
+{
+  if (usec >= ((uint64_t)1 << LatencyHistogram::MAX_VALUE_BITS_))
+    return LatencyHistogram::BUCKET_COUNT_ - 1;
+  if (usec < 2 * HALF_BUCKET_COUNT)
+    return (int)usec;
+
+  int shift = getHighestBit(usec) - (LatencyHistogram::SUB_BUCKET_BITS_ - 1);
+  return shift * HALF_BUCKET_COUNT + (int)(usec >> shift);
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+  clear();
+}
+
+void LatencyHistogram::record(int64_t nsec)
+{
+  if (nsec < 0)
+    nsec = 0;
+
+  // one thread writes, so a load and a store make the counters exact without a locked instruction
+  std::atomic<uint64_t> &bucket = buckets_[getBucket((uint64_t)nsec / MonotonicClock::NSEC_PER_USEC)];
+  bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  sum_.store(sum_.load(std::memory_order_relaxed) + nsec, std::memory_order_relaxed);
+  if (nsec > max_.load(std::memory_order_relaxed))
+    max_.store(nsec, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::clear()
+{
+  for (int b = 0; b < BUCKET_COUNT_; b++)
+    buckets_[b].store(0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getPercentile(double percentile) const
+{
+  // the buckets are summed again rather than trusting count_, which may be ahead of or behind them while a latency is recorded
+  uint64_t total = 0;
+  for (int b = 0; b < BUCKET_COUNT_; b++)
+    total += buckets_[b].load(std::memory_order_relaxed);
+  if (total == 0)
+    return 0.0;
+
+  uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.999999);
+  if (rank < 1)
+    rank = 1;
+
+  uint64_t seen = 0;
+  for (int b = 0; b < BUCKET_COUNT_; b++)
+  {
+    seen += buckets_[b].load(std::memory_order_relaxed);
+    if (seen >= rank)
+      return getBucketLimit(b);
+  }
+  return getBucketLimit(BUCKET_COUNT_ - 1);
+}
+
+double LatencyHistogram::getMean() const
+{
+  uint64_t count = count_.load(std::memory_order_relaxed);
+  if (count == 0)
+    return 0.0;
+  return MonotonicClock::toMsec(sum_.load(std::memory_order_relaxed)) / (double)count;
+}
+
+double LatencyHistogram::getMax() const
+{
+  return MonotonicClock::toMsec(max_.load(std::memory_order_relaxed));
+}
+
+double LatencyHistogram::getBucketLimit(int bucket)
+{
+  int shift = 0;
+  if (bucket >= 2 * HALF_BUCKET_COUNT)
+    shift = bucket / HALF_BUCKET_COUNT - 1;
+
+  uint64_t top = (uint64_t)(bucket - shift * HALF_BUCKET_COUNT);
+  return MonotonicClock::toMsec((int64_t)((top + 1) << shift) * MonotonicClock::NSEC_PER_USEC);
+}
@@ -0,0 +1,46 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include <time.h>
+#include "monotonic_clock.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include <Windows.h>
+#include "monotonic_clock.h"
+#endif
+
+using namespace mercury;
+
+int64_t MonotonicClock::getTime()
+{
+#if defined(__linux__)
+  struct timespec tv;
+  clock_gettime(CLOCK_MONOTONIC, &tv);
+  return (int64_t)tv.tv_sec * NSEC_PER_SEC + (int64_t)tv.tv_nsec;
+#elif defined(_WIN32) || defined(_WIN64)
+  static LARGE_INTEGER freq = { 0 };
+  LARGE_INTEGER counter;
+
+  if (freq.QuadPart == 0)
+    QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&counter);
+
+  // split the conversion so that counter * NSEC_PER_SEC cannot overflow
+  return (counter.QuadPart / freq.QuadPart) * NSEC_PER_SEC
+       + (counter.QuadPart % freq.QuadPart) * NSEC_PER_SEC / freq.QuadPart;
+#endif
+}
@@ -31,6 +31,10 @@
 #include "port_handler_windows.h"
 #endif
 
+#include <string.h>
+
+#include "transaction_metrics.h"
+
 using namespace mercury;
 
 PortHandler *PortHandler::getPortHandler(const char *port_name)
@@ -41,3 +45,84 @@ PortHandler *PortHandler::getPortHandler(const char *port_name)
   return (PortHandler *)(new PortHandlerWindows(port_name));
 #endif
 }
+
+PortHandler::PortHandler()
+  : is_using_(false),
+    wait_policy_(WAIT_BLOCK),
+    recorder_(0),
+    recorder_channel_(0),
+    metrics_(0),
+    responder_id_(0),
+    is_awaiting_response_(false),
+    rx_begin_(0),
+    rx_end_(0)
+{
+  resetWaitStatistics();
+  for (int id = 0; id < 256; id++)
+  {
+    return_delay_[id]         = -1.0;
+    return_delay_jitter_[id]  = 0.0;
+  }
+}
+
+void PortHandler::resetWaitStatistics()
+{
+  wait_statistics_.spin_time      = 0.0;
+  wait_statistics_.block_time     = 0.0;
+  wait_statistics_.spin_wakeups   = 0;
+  wait_statistics_.block_wakeups  = 0;
+}
+
+void PortHandler::setResponderId(uint8_t id)
+{
+  responder_id_         = id;
+  is_awaiting_response_ = true;
+}
+
+void PortHandler::setReturnDelayTime(uint8_t id, double msec)
+{
+  return_delay_[id]         = msec;
+  return_delay_jitter_[id]  = 0.0;
+}
+
+void PortHandler::updateReturnDelay(double msec)
+{
+  is_awaiting_response_ = false;
+
+  double *delay  = &return_delay_[responder_id_];
+  double *jitter = &return_delay_jitter_[responder_id_];
+  if (*delay < 0.0)
+  {
+    *delay = msec;
+    return;
+  }
+
+  // exponentially weighted moving average (1/8) of the delay and of its deviation
+  double deviation = msec - *delay;
+  *delay  += deviation / 8.0;
+  *jitter += ((deviation < 0.0 ? -deviation : deviation) - *jitter) / 8.0;
+}
+
+int PortHandler::fillRxBuffer()
+{
+  if (rx_begin_ == rx_end_)
+  {
+    rx_begin_ = rx_end_ = 0;
+  }
+  else if (RX_BUFFER_LENGTH_ - rx_end_ < RX_BUFFER_LENGTH_ / 4)
+  {
+    // move the unconsumed tail (normally less than one status packet) to the front
+    memmove(rx_buffer_, &rx_buffer_[rx_begin_], rx_end_ - rx_begin_);
+    rx_end_  -= rx_begin_;
+    rx_begin_ = 0;
+  }
+
+  int read_length = readPort(&rx_buffer_[rx_end_], RX_BUFFER_LENGTH_ - rx_end_);
+  if (read_length <= 0)
+    return 0;
+
+  if (metrics_ != 0)
+    metrics_->countRx(read_length);
+  rx_end_ += read_length;
+  return read_length;
+}
@@ -0,0 +1,128 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "port_handler_emulator.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "port_handler_emulator.h"
+#endif
+
+#include <string.h>
+#include <algorithm>
+
+#include "monotonic_clock.h"
+#include "traffic_recorder.h"
+
+using namespace mercury;
+
+PortHandlerEmulator::PortHandlerEmulator(const char *port_name, ClockMode clock_mode)
+  : PortHandlerScheduled(clock_mode == CLOCK_VIRTUAL),
+    clock_mode_(clock_mode),
+    baudrate_(DEFAULT_BAUDRATE_),
+    tx_time_per_byte(0.0),
+    byte_time_(0),
+    bus_free_time_(0)
+{
+  setPortName(port_name);
+}
+
+bool PortHandlerEmulator::openPort()
+{
+  return setBaudRate(baudrate_);
+}
+
+void PortHandlerEmulator::closePort()
+{
+  is_open_ = false;
+  dropAll();
+  bus_.clearPort();
+}
+
+void PortHandlerEmulator::setPortName(const char *port_name)
+{
+  strncpy(port_name_, port_name, sizeof(port_name_) - 1);
+  port_name_[sizeof(port_name_) - 1] = 0;
+}
+
+char *PortHandlerEmulator::getPortName()
+{
+  return port_name_;
+}
+
+bool PortHandlerEmulator::setBaudRate(const int baudrate)
+{
+  closePort();
+
+  baudrate_         = baudrate;
+  tx_time_per_byte  = (1000.0 / (double)baudrate_) * 10.0;
+  byte_time_        = MonotonicClock::NSEC_PER_SEC * 10 / baudrate_;
+  rx_burst_gap_     = byte_time_;
+  bus_.setBaudRate(baudrate_);
+
+  is_open_ = true;
+  return true;
+}
+
+int PortHandlerEmulator::getBaudRate()
+{
+  return baudrate_;
+}
+
+int PortHandlerEmulator::writePort(uint8_t *packet, int length)
+{
+  if (is_open_ == false)
+    return -1;
+
+  int64_t now = getTime();
+  if (recorder_ != 0 && length > 0)
+    recorder_->record(TrafficRecorder::DIRECTION_TX, recorder_channel_, now, packet, (uint16_t)length);
+
+  // the bytes follow those still leaving the UART
+  tx_end_time_ = std::max(now, tx_end_time_) + byte_time_ * length;
+  if (clock_mode_ == CLOCK_VIRTUAL)
+    virtual_time_ = tx_end_time_;
+
+  // each status packet starts after the return delay of its Mercury, once the bus is free
+  bus_.receive(packet, length);
+
+  int64_t time = std::max(tx_end_time_, bus_free_time_);
+  const uint8_t *data = bus_.getResponseData();
+  for (int i = 0; i < bus_.getResponseCount(); i++)
+  {
+    const BusEmulator::Response &response = bus_.getResponse(i);
+    time += (int64_t)(response.delay * (double)MonotonicClock::NSEC_PER_USEC);
+    for (uint32_t s = 0; s < response.length; s++)
+    {
+      time += byte_time_;
+      scheduleRx(&data[response.offset + s], 1, time);
+    }
+  }
+  bus_free_time_ = time;
+  bus_.clearResponses();
+
+  return length;
+}
+
+void PortHandlerEmulator::setPacketTimeout(uint16_t packet_length)
+{
+  setPacketTimeout((tx_time_per_byte * (double)packet_length) + 2.0);
+}
+
+void PortHandlerEmulator::setPacketTimeout(double msec)
+{
+  packet_deadline_ = std::max(getTime(), tx_end_time_) + MonotonicClock::fromMsec(msec);
+}
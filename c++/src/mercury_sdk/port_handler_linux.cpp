@@ -25,7 +25,11 @@
 #if defined(__linux__)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <libgen.h>
+#include <limits.h>
 #include <string.h>
 #include <unistd.h>
 #include <termios.h>
@@ -35,37 +39,40 @@
 #include <linux/serial.h>
 
 #include "port_handler_linux.h"
+#include "monotonic_clock.h"
+#include "traffic_recorder.h"
 
 #define LATENCY_TIMER  16  // msec (USB latency timer)
-                           // You should adjust the latency timer value. From the version Ubuntu 16.04.2, the default latency timer of the usb serial is '16 msec'.
-                           // When you are going to use sync / bulk read, the latency timer should be loosen.
+                           // Default latency timer of the usb serial, used when the actual value cannot be read.
+                           // From the version Ubuntu 16.04.2, the default latency timer of the usb serial is '16 msec'.
                            // the lower latency timer value, the faster communication speed.
 
                            // Note:
-                           // You can check its value by:
-                           // $ cat /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
-                           //
-                           // If you think that the communication is too slow, type following after plugging the usb in to change the latency timer
-                           //
-                           // Method 1. Type following (you should do this everytime when the usb once was plugged out or the connection was dropped)
-                           // $ echo 1 | sudo tee /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
-                           // $ cat /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
-                           //
-                           // Method 2. If you want to set it as be done automatically, and don't want to do above everytime, make rules file in /etc/udev/rules.d/. For example,
+                           // PortHandlerLinux reads the latency timer of the adapter from
+                           // /sys/bus/usb-serial/devices/ttyUSB0/latency_timer when the port is opened,
+                           // tries to lower it to LATENCY_TIMER_LOW and derives the packet timeout from the value in effect.
+                           // Lowering it needs write access to the sysfs attribute. If the SDK is not allowed to do so,
+                           // make rules file in /etc/udev/rules.d/. For example,
                            // $ echo ACTION==\"add\", SUBSYSTEM==\"usb-serial\", DRIVER==\"ftdi_sio\", ATTR{latency_timer}=\"1\" > 99-mercurysdk-usb.rules
                            // $ sudo cp ./99-mercurysdk-usb.rules /etc/udev/rules.d/
                            // $ sudo udevadm control --reload-rules
                            // $ sudo udevadm trigger --action=add
                            // $ cat /sys/bus/usb-serial/devices/ttyUSB0/latency_timer
 
+#define LATENCY_TIMER_LOW  1  // msec, latency timer requested from the adapter
+
+#define SPIN_MARGIN_MIN   0.05  // msec, minimum half width of the WAIT_HYBRID spin window
+#define SPIN_WINDOW_MAX   2.0   // msec, maximum width of the WAIT_HYBRID spin window
+
 using namespace mercury;
 
 PortHandlerLinux::PortHandlerLinux(const char *port_name)
   : socket_fd_(-1),
     baudrate_(DEFAULT_BAUDRATE_),
-    packet_start_time_(0.0),
-    packet_timeout_(0.0),
-    tx_time_per_byte(0.0)
+    packet_deadline_(0),
+    tx_time_per_byte(0.0),
+    tx_end_time_(0),
+    latency_timer_(LATENCY_TIMER)
 {
   is_using_ = false;
   setPortName(port_name);
@@ -86,6 +93,7 @@ void PortHandlerLinux::closePort()
 void PortHandlerLinux::clearPort()
 {
   tcflush(socket_fd_, TCIFLUSH);
+  clearRxBuffer();
 }
 
 void PortHandlerLinux::setPortName(const char *port_name)
@@ -132,54 +140,171 @@ int PortHandlerLinux::getBytesAvailable()
 
 int PortHandlerLinux::readPort(uint8_t *packet, int length)
 {
-  return read(socket_fd_, packet, length);
+  int read_length = read(socket_fd_, packet, length);
+  if(read_length <= 0)
+    return read_length;
+
+  int64_t now = MonotonicClock::getTime();
+  if(recorder_ != 0)
+    recorder_->record(TrafficRecorder::DIRECTION_RX, recorder_channel_, now, packet, (uint16_t)read_length);
+
+  // the first status byte after an instruction packet measures the return delay of the responder
+  if(is_awaiting_response_)
+    updateReturnDelay(MonotonicClock::toMsec(now - tx_end_time_));
+
+  return read_length;
 }
 
 int PortHandlerLinux::writePort(uint8_t *packet, int length)
 {
-  return write(socket_fd_, packet, length);
+  int written_length = write(socket_fd_, packet, length);
+  int64_t now = MonotonicClock::getTime();
+  tx_end_time_ = now + MonotonicClock::fromMsec(tx_time_per_byte * (double)length);
+
+  if(recorder_ != 0 && written_length > 0)
+    recorder_->record(TrafficRecorder::DIRECTION_TX, recorder_channel_, now, packet, (uint16_t)written_length);
+
+  return written_length;
+}
+
+bool PortHandlerLinux::waitPort()
+{
+  int64_t now      = MonotonicClock::getTime();
+  int64_t deadline = packet_deadline_;
+  int64_t window_start, window_end;
+
+  if(now >= deadline)
+    return false;
+
+  switch(wait_policy_)
+  {
+    case WAIT_SPIN:
+      window_start  = now;
+      window_end    = deadline;
+      break;
+
+    case WAIT_HYBRID:
+      getSpinWindow(now, &window_start, &window_end);
+      break;
+
+    default:
+      window_start  = deadline;
+      window_end    = deadline;
+      break;
+  }
+
+  // sleep until the spin window opens
+  if(now < window_start)
+  {
+    bool is_readable = pollPort((window_start < deadline ? window_start : deadline) - now);
+    int64_t then = MonotonicClock::getTime();
+    wait_statistics_.block_time += MonotonicClock::toMsec(then - now);
+    now = then;
+    if(is_readable)
+    {
+      wait_statistics_.block_wakeups++;
+      return true;
+    }
+  }
+
+  // spin through the window
+  if(now < window_end && now < deadline)
+  {
+    int64_t spin_start = now;
+    bool is_readable = false;
+    while(now < window_end && now < deadline)
+    {
+      is_readable = pollPort(0);
+      now = MonotonicClock::getTime();
+      if(is_readable)
+        break;
+    }
+    wait_statistics_.spin_time += MonotonicClock::toMsec(now - spin_start);
+    if(is_readable)
+    {
+      wait_statistics_.spin_wakeups++;
+      return true;
+    }
+  }
+
+  // the status packet is late: sleep for the rest of the timeout
+  if(now < deadline)
+  {
+    bool is_readable = pollPort(deadline - now);
+    wait_statistics_.block_time += MonotonicClock::toMsec(MonotonicClock::getTime() - now);
+    if(is_readable)
+    {
+      wait_statistics_.block_wakeups++;
+      return true;
+    }
+  }
+
+  return false;
 }
 
 void PortHandlerLinux::setPacketTimeout(uint16_t packet_length)
 {
-  packet_start_time_  = getCurrentTime();
-  packet_timeout_     = (tx_time_per_byte * (double)packet_length) + (LATENCY_TIMER * 2.0) + 2.0;
+  setPacketTimeout((tx_time_per_byte * (double)packet_length) + (latency_timer_ * 2.0) + 2.0);
 }
 
 void PortHandlerLinux::setPacketTimeout(double msec)
 {
-  packet_start_time_  = getCurrentTime();
-  packet_timeout_     = msec;
+  packet_deadline_ = MonotonicClock::getTime() + MonotonicClock::fromMsec(msec);
 }
 
 bool PortHandlerLinux::isPacketTimeout()
 {
-  //double timeSinceStart = getTimeSinceStart();
-  //printf("timeSinceStart=[%f] packet_timeout_=[%f]\n", timeSinceStart, packet_timeout_);
-  if(getTimeSinceStart() > packet_timeout_)
-  {
-    packet_timeout_ = 0;
-    return true;
-  }
-  return false;
+  return MonotonicClock::getTime() > packet_deadline_;
 }
 
-double PortHandlerLinux::getCurrentTime()
+bool PortHandlerLinux::pollPort(int64_t nsec)
 {
-	struct timespec tv;
-	clock_gettime(CLOCK_REALTIME, &tv);
-	return ((double)tv.tv_sec * 1000.0 + (double)tv.tv_nsec * 0.001 * 0.001);
+  struct pollfd pfd;
+  pfd.fd      = socket_fd_;
+  pfd.events  = POLLIN;
+  pfd.revents = 0;
+
+  struct timespec ts;
+  ts.tv_sec   = (time_t)(nsec / MonotonicClock::NSEC_PER_SEC);
+  ts.tv_nsec  = (long)(nsec % MonotonicClock::NSEC_PER_SEC);
+
+  if(ppoll(&pfd, 1, &ts, NULL) <= 0)
+    return false;
+
+  return (pfd.revents & POLLIN) != 0;
 }
 
-double PortHandlerLinux::getTimeSinceStart()
+void PortHandlerLinux::getSpinWindow(int64_t now, int64_t *window_start, int64_t *window_end)
 {
-  double time;
+  int64_t expected_time, margin;
 
-  time = getCurrentTime() - packet_start_time_;
-  if(time < 0.0)
-    packet_start_time_ = getCurrentTime();
+  if(is_awaiting_response_ == false)
+  {
+    // the status packet is already streaming in, the next bytes are due within a few byte times
+    expected_time = now;
+    margin        = MonotonicClock::fromMsec(tx_time_per_byte * 16.0);
+  }
+  else if(return_delay_[responder_id_] >= 0.0)
+  {
+    // the window is centred on the measured return delay and widened by its jitter
+    expected_time = tx_end_time_ + MonotonicClock::fromMsec(return_delay_[responder_id_]);
+    margin        = MonotonicClock::fromMsec(return_delay_jitter_[responder_id_] * 4.0 + tx_time_per_byte * 2.0);
+  }
+  else
+  {
+    // nothing measured yet, so block and let this response calibrate the window
+    *window_start = packet_deadline_;
+    *window_end   = packet_deadline_;
+    return;
+  }
+
+  if(margin < MonotonicClock::fromMsec(SPIN_MARGIN_MIN))
+    margin = MonotonicClock::fromMsec(SPIN_MARGIN_MIN);
+  if(margin > MonotonicClock::fromMsec(SPIN_WINDOW_MAX / 2.0))
+    margin = MonotonicClock::fromMsec(SPIN_WINDOW_MAX / 2.0);
 
-  return time;
+  *window_start = expected_time - margin;
+  *window_end   = expected_time + margin;
 }
 
 bool PortHandlerLinux::setupPort(int cflag_baud)
@@ -206,10 +331,71 @@ bool PortHandlerLinux::setupPort(int cflag_baud)
   tcflush(socket_fd_, TCIFLUSH);
   tcsetattr(socket_fd_, TCSANOW, &newtio);
 
+  setupLowLatency();
+
   tx_time_per_byte = (1000.0 / (double)baudrate_) * 10.0;
   return true;
 }
 
+void PortHandlerLinux::setupLowLatency()
+{
+  // ask the serial driver to push received bytes to the tty immediately
+  // (not supported by every driver, e.g. pseudo terminals, which is harmless)
+  struct serial_struct ss;
+  if(ioctl(socket_fd_, TIOCGSERIAL, &ss) == 0 && (ss.flags & ASYNC_LOW_LATENCY) == 0)
+  {
+    ss.flags |= ASYNC_LOW_LATENCY;
+    ioctl(socket_fd_, TIOCSSERIAL, &ss);
+  }
+
+  // find the latency timer of the usb serial adapter, following symlinks such as /dev/serial/by-id/*
+  char device_path[PATH_MAX];
+  char sysfs_path[PATH_MAX + 64];
+  if(realpath(port_name_, device_path) == NULL)
+  {
+    strncpy(device_path, port_name_, sizeof(device_path) - 1);
+    device_path[sizeof(device_path) - 1] = 0;
+  }
+  const char *device_name = basename(device_path);
+  snprintf(sysfs_path, sizeof(sysfs_path), "/sys/bus/usb-serial/devices/%s/latency_timer", device_name);
+
+  int latency_timer = readLatencyTimer(sysfs_path);
+  if(latency_timer > LATENCY_TIMER_LOW)
+  {
+    // lower the latency timer when permitted, then read back the value actually in effect
+    int fd = open(sysfs_path, O_WRONLY);
+    if(fd >= 0)
+    {
+      char value[16];
+      int length = snprintf(value, sizeof(value), "%d\n", LATENCY_TIMER_LOW);
+      if(write(fd, value, length) == length)
+        latency_timer = readLatencyTimer(sysfs_path);
+      close(fd);
+    }
+  }
+
+  if(latency_timer >= 0)
+    latency_timer_ = latency_timer;
+  else if(strncmp(device_name, "ttyUSB", 6) == 0)
+    latency_timer_ = LATENCY_TIMER;   // usb serial adapter whose latency timer cannot be read
+  else
+    latency_timer_ = 0;               // not a usb serial adapter (ttyS, ttyACM, pty, ...)
+}
+
+int PortHandlerLinux::readLatencyTimer(const char *sysfs_path)
+{
+  int latency_timer = -1;
+
+  FILE *fp = fopen(sysfs_path, "r");
+  if(fp == NULL)
+    return -1;
+  if(fscanf(fp, "%d", &latency_timer) != 1)
+    latency_timer = -1;
+  fclose(fp);
+
+  return latency_timer;
+}
+
 bool PortHandlerLinux::setCustomBaudrate(int speed)
 {
   // try to set a custom divisor
@@ -0,0 +1,213 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "port_handler_replay.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "port_handler_replay.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "monotonic_clock.h"
+#include "traffic_recorder.h"
+
+#define LATENCY_TIMER   16    // msec, default USB latency timer of PortHandlerLinux
+#define RESYNC_WINDOW   64    // exchanges searched ahead for a write which doesn't match the next one
+
+using namespace mercury;
+
+PortHandlerReplay::PortHandlerReplay(const char *port_name, ReplayMode replay_mode)
+  : PortHandlerScheduled(replay_mode == REPLAY_FAST),
+    replay_mode_(replay_mode),
+    baudrate_(DEFAULT_BAUDRATE_),
+    position_(0),
+    mismatch_count_(0),
+    skipped_count_(0),
+    tx_time_per_byte(0.0)
+{
+  setPortName(port_name);
+}
+
+bool PortHandlerReplay::loadCapture(const char *path, uint8_t channel)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+    return false;
+
+  std::vector<uint8_t> capture;
+  uint8_t buffer[65536];
+  size_t  read_length;
+  while ((read_length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    capture.insert(capture.end(), buffer, buffer + read_length);
+  fclose(file);
+
+  if (capture.size() < sizeof(TrafficRecorder::FileHeader))
+    return false;
+
+  const TrafficRecorder::FileHeader *header = (const TrafficRecorder::FileHeader *)&capture[0];
+  if (memcmp(header->magic, "MCYTRAF", 8) != 0 || header->version != TrafficRecorder::VERSION_)
+    return false;
+
+  data_.clear();
+  exchanges_.clear();
+  chunks_.clear();
+
+  // a file which was not closed keeps its whole capacity, the end in the header is where its records stop
+  uint64_t end    = std::min(header->end.load(std::memory_order_relaxed), (uint64_t)capture.size());
+  uint64_t offset = header->header_size;
+  int64_t  tx_time = 0;
+  while (offset + sizeof(TrafficRecorder::Record) <= end)
+  {
+    const TrafficRecorder::Record *record = (const TrafficRecorder::Record *)&capture[offset];
+    uint32_t size = record->size.load(std::memory_order_acquire);
+    if (size < sizeof(TrafficRecorder::Record) + record->length || offset + size > end)
+      break;
+
+    const uint8_t *bytes = (const uint8_t *)record + sizeof(TrafficRecorder::Record);
+    if (record->channel == channel)
+    {
+      if (record->direction == TrafficRecorder::DIRECTION_TX)
+      {
+        Exchange exchange;
+        exchange.tx_offset  = data_.size();
+        exchange.tx_length  = record->length;
+        exchange.rx_begin   = (uint32_t)chunks_.size();
+        exchange.rx_end     = (uint32_t)chunks_.size();
+        exchanges_.push_back(exchange);
+        tx_time = record->time;
+        data_.insert(data_.end(), bytes, bytes + record->length);
+      }
+      else if (exchanges_.empty() == false)
+      {
+        Chunk chunk;
+        chunk.offset  = data_.size();
+        chunk.length  = record->length;
+        chunk.delay   = std::max(record->time - tx_time, (int64_t)0);
+        chunks_.push_back(chunk);
+        exchanges_.back().rx_end = (uint32_t)chunks_.size();
+        data_.insert(data_.end(), bytes, bytes + record->length);
+      }
+    }
+    offset += size;
+  }
+
+  rewind();
+  return true;
+}
+
+void PortHandlerReplay::rewind()
+{
+  position_       = 0;
+  mismatch_count_ = 0;
+  skipped_count_  = 0;
+  dropAll();
+}
+
+bool PortHandlerReplay::openPort()
+{
+  return setBaudRate(baudrate_);
+}
+
+void PortHandlerReplay::closePort()
+{
+  is_open_ = false;
+  dropAll();
+}
+
+void PortHandlerReplay::setPortName(const char *port_name)
+{
+  strncpy(port_name_, port_name, sizeof(port_name_) - 1);
+  port_name_[sizeof(port_name_) - 1] = 0;
+}
+
+char *PortHandlerReplay::getPortName()
+{
+  return port_name_;
+}
+
+bool PortHandlerReplay::setBaudRate(const int baudrate)
+{
+  closePort();
+
+  baudrate_         = baudrate;
+  tx_time_per_byte  = (1000.0 / (double)baudrate_) * 10.0;
+
+  is_open_ = true;
+  return true;
+}
+
+int PortHandlerReplay::getBaudRate()
+{
+  return baudrate_;
+}
+
+int PortHandlerReplay::writePort(uint8_t *packet, int length)
+{
+  if (is_open_ == false)
+    return -1;
+
+  int64_t now = getTime();
+  if (recorder_ != 0 && length > 0)
+    recorder_->record(TrafficRecorder::DIRECTION_TX, recorder_channel_, now, packet, (uint16_t)length);
+  tx_end_time_ = now + MonotonicClock::fromMsec(tx_time_per_byte * (double)length);
+
+  dropPending(now);
+
+  int index = findExchange(packet, length);
+  if (index < 0)
+  {
+    mismatch_count_++;
+    return length;
+  }
+  skipped_count_ += index - position_;
+  position_       = index + 1;
+
+  // the recorded delays start when the write returned, as the time of the record does
+  const Exchange &exchange = exchanges_[index];
+  for (uint32_t c = exchange.rx_begin; c < exchange.rx_end; c++)
+  {
+    const Chunk &chunk = chunks_[c];
+    scheduleRx(data_.data() + chunk.offset, chunk.length, now + chunk.delay);
+  }
+
+  return length;
+}
+
+void PortHandlerReplay::setPacketTimeout(uint16_t packet_length)
+{
+  setPacketTimeout((tx_time_per_byte * (double)packet_length) + (LATENCY_TIMER * 2.0) + 2.0);
+}
+
+void PortHandlerReplay::setPacketTimeout(double msec)
+{
+  packet_deadline_ = getTime() + MonotonicClock::fromMsec(msec);
+}
+
+int PortHandlerReplay::findExchange(const uint8_t *packet, int length)
+{
+  int last = std::min(position_ + RESYNC_WINDOW, (int)exchanges_.size());
+  for (int index = position_; index < last; index++)
+  {
+    const Exchange &exchange = exchanges_[index];
+    if (exchange.tx_length == length && memcmp(&data_[exchange.tx_offset], packet, length) == 0)
+      return index;
+  }
+  return -1;
+}
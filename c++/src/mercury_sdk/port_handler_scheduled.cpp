@@ -0,0 +1,183 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "port_handler_scheduled.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "port_handler_scheduled.h"
+#endif
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "monotonic_clock.h"
+#include "traffic_recorder.h"
+
+#define SPIN_MARGIN   0.05  // msec, WAIT_HYBRID spins for the last part of a wait
+
+using namespace mercury;
+
+PortHandlerScheduled::PortHandlerScheduled(bool is_clock_virtual)
+  : is_open_(false),
+    virtual_time_(0),
+    tx_end_time_(0),
+    packet_deadline_(0),
+    rx_burst_gap_(0),
+    is_clock_virtual_(is_clock_virtual),
+    rx_read_(0)
+{
+  is_using_ = false;
+}
+
+int64_t PortHandlerScheduled::getTime()
+{
+  if (is_clock_virtual_)
+    return virtual_time_;
+  return MonotonicClock::getTime();
+}
+
+void PortHandlerScheduled::clearPort()
+{
+  rx_read_ += getArrivedCount(getTime());
+  if (rx_read_ == rx_data_.size())
+    dropAll();
+  clearRxBuffer();
+}
+
+int PortHandlerScheduled::getBytesAvailable()
+{
+  return getArrivedCount(getTime());
+}
+
+int PortHandlerScheduled::readPort(uint8_t *packet, int length)
+{
+  if (is_open_ == false)
+    return -1;
+
+  int64_t now = getTime();
+  int read_length = std::min(getArrivedCount(now), length);
+  if (read_length <= 0)
+    return 0;
+
+  memcpy(packet, &rx_data_[rx_read_], read_length);
+  rx_read_ += read_length;
+  if (recorder_ != 0)
+    recorder_->record(TrafficRecorder::DIRECTION_RX, recorder_channel_, now, packet, (uint16_t)read_length);
+  if (rx_read_ == rx_data_.size())
+    dropAll();
+
+  // the first status byte after an instruction packet measures the return delay of the responder
+  if (is_awaiting_response_)
+    updateReturnDelay(MonotonicClock::toMsec(now - tx_end_time_));
+
+  return read_length;
+}
+
+bool PortHandlerScheduled::waitPort()
+{
+  int64_t now = getTime();
+
+  if (getArrivedCount(now) > 0)
+    return true;
+
+  if (is_clock_virtual_)
+  {
+    // without a byte before the deadline, the clock moves just past it so that the packet times out
+    if (rx_read_ >= rx_time_.size() || rx_time_[rx_read_] > packet_deadline_)
+    {
+      virtual_time_ = std::max(now, packet_deadline_ + 1);
+      return false;
+    }
+
+    // the bytes which follow back to back are read at once, as the FIFO of a UART hands them over
+    uint32_t last = rx_read_;
+    while (last + 1 < rx_time_.size() && rx_time_[last + 1] - rx_time_[last] <= rx_burst_gap_ && rx_time_[last + 1] <= packet_deadline_)
+      last++;
+    virtual_time_ = std::max(now, rx_time_[last]);
+    return true;
+  }
+
+  if (now >= packet_deadline_)
+    return false;
+
+  int64_t until = packet_deadline_;
+  if (rx_read_ < rx_time_.size() && rx_time_[rx_read_] < until)
+    until = rx_time_[rx_read_];
+
+  int64_t spin_start = until;
+  if (wait_policy_ == WAIT_SPIN)
+    spin_start = now;
+  else if (wait_policy_ == WAIT_HYBRID)
+    spin_start = until - MonotonicClock::fromMsec(SPIN_MARGIN);
+
+  if (now < spin_start)
+  {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(spin_start - now));
+    int64_t then = MonotonicClock::getTime();
+    wait_statistics_.block_time += MonotonicClock::toMsec(then - now);
+    now = then;
+    if (getArrivedCount(now) > 0)
+    {
+      wait_statistics_.block_wakeups++;
+      return true;
+    }
+  }
+
+  int64_t spin_begin = now;
+  while (now < until)
+    now = MonotonicClock::getTime();
+  wait_statistics_.spin_time += MonotonicClock::toMsec(now - spin_begin);
+
+  if (getArrivedCount(now) == 0)
+    return false;
+
+  wait_statistics_.spin_wakeups++;
+  return true;
+}
+
+bool PortHandlerScheduled::isPacketTimeout()
+{
+  return getTime() > packet_deadline_;
+}
+
+void PortHandlerScheduled::scheduleRx(const uint8_t *data, int length, int64_t time)
+{
+  rx_data_.insert(rx_data_.end(), data, data + length);
+  rx_time_.insert(rx_time_.end(), length, time);
+}
+
+void PortHandlerScheduled::dropPending(int64_t now)
+{
+  uint32_t arrived = rx_read_ + getArrivedCount(now);
+  rx_data_.resize(arrived);
+  rx_time_.resize(arrived);
+}
+
+void PortHandlerScheduled::dropAll()
+{
+  rx_data_.clear();
+  rx_time_.clear();
+  rx_read_ = 0;
+}
+
+int PortHandlerScheduled::getArrivedCount(int64_t now)
+{
+  std::vector<int64_t>::iterator end = std::upper_bound(rx_time_.begin() + rx_read_, rx_time_.end(), now);
+  return (int)(end - (rx_time_.begin() + rx_read_));
+}
@@ -26,6 +26,8 @@
 #define WINDLLEXPORT
 
 #include "port_handler_windows.h"
+#include "monotonic_clock.h"
+#include "traffic_recorder.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -46,8 +48,7 @@ using namespace mercury;
 PortHandlerWindows::PortHandlerWindows(const char *port_name)
   : serial_handle_(INVALID_HANDLE_VALUE),
   baudrate_(DEFAULT_BAUDRATE_),
-  packet_start_time_(0.0),
-  packet_timeout_(0.0),
+  packet_deadline_(0),
   tx_time_per_byte_(0.0)
 {
   is_using_ = false;
@@ -74,6 +75,7 @@ void PortHandlerWindows::closePort()
 void PortHandlerWindows::clearPort()
 {
   PurgeComm(serial_handle_, PURGE_RXABORT | PURGE_RXCLEAR);
+  clearRxBuffer();
 }
 
 void PortHandlerWindows::setPortName(const char *port_name)
@@ -115,6 +117,9 @@ int PortHandlerWindows::readPort(uint8_t *packet, int length)
   if (ReadFile(serial_handle_, packet, (DWORD)length, &dwRead, NULL) == FALSE)
     return -1;
 
+  if (recorder_ != 0 && dwRead > 0)
+    recorder_->record(TrafficRecorder::DIRECTION_RX, recorder_channel_, MonotonicClock::getTime(), packet, (uint16_t)dwRead);
+
   return (int)dwRead;
 }
 
@@ -125,46 +130,32 @@ int PortHandlerWindows::writePort(uint8_t *packet, int length)
   if (WriteFile(serial_handle_, packet, (DWORD)length, &dwWrite, NULL) == FALSE)
     return -1;
 
-  return (int)dwWrite;
-}
+  if (recorder_ != 0 && dwWrite > 0)
+    recorder_->record(TrafficRecorder::DIRECTION_TX, recorder_channel_, MonotonicClock::getTime(), packet, (uint16_t)dwWrite);
 
-void PortHandlerWindows::setPacketTimeout(uint16_t packet_length)
-{
-  packet_start_time_ = getCurrentTime();
-  packet_timeout_ = (tx_time_per_byte_ * (double)packet_length) + (LATENCY_TIMER * 2.0) + 2.0;
+  return (int)dwWrite;
 }
 
-void PortHandlerWindows::setPacketTimeout(double msec)
+bool PortHandlerWindows::waitPort()
 {
-  packet_start_time_ = getCurrentTime();
-  packet_timeout_ = msec;
+  if (wait_policy_ != WAIT_SPIN)
+    Sleep(0);
+  return true;
 }
 
-bool PortHandlerWindows::isPacketTimeout()
+void PortHandlerWindows::setPacketTimeout(uint16_t packet_length)
 {
-  if (getTimeSinceStart() > packet_timeout_)
-  {
-    packet_timeout_ = 0;
-    return true;
-  }
-  return false;
+  setPacketTimeout((tx_time_per_byte_ * (double)packet_length) + (LATENCY_TIMER * 2.0) + 2.0);
 }
 
-double PortHandlerWindows::getCurrentTime()
+void PortHandlerWindows::setPacketTimeout(double msec)
 {
-  QueryPerformanceCounter(&counter_);
-  QueryPerformanceFrequency(&freq_);
-  return (double)counter_.QuadPart / (double)freq_.QuadPart * 1000.0;
+  packet_deadline_ = MonotonicClock::getTime() + MonotonicClock::fromMsec(msec);
 }
 
-double PortHandlerWindows::getTimeSinceStart()
+bool PortHandlerWindows::isPacketTimeout()
 {
-  double time;
-
-  time = getCurrentTime() - packet_start_time_;
-  if (time < 0.0) packet_start_time_ = getCurrentTime();
-
-  return time;
+  return MonotonicClock::getTime() > packet_deadline_;
 }
 
 bool PortHandlerWindows::setupPort(int baudrate)
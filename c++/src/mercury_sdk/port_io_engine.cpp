@@ -0,0 +1,198 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "port_io_engine.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "port_io_engine.h"
+#endif
+
+#include <chrono>
+
+using namespace mercury;
+
+// the queue always holds at least one node, the stub, so producers never touch tail_
+IoQueue::IoQueue()
+  : head_(&stub_),
+    tail_(&stub_),
+    is_waiting_(false)
+{
+}
+
+void IoQueue::link(IoTransaction *transaction)
+{
+  transaction->next_.store(0, std::memory_order_relaxed);
+  IoTransaction *prev = head_.exchange(transaction, std::memory_order_acq_rel);
+  prev->next_.store(transaction, std::memory_order_release);
+}
+
+void IoQueue::push(IoTransaction *transaction)
+{
+  link(transaction);
+
+  // pairs with the fence in wait(): either the consumer sees the transaction, or this sees it waiting
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (is_waiting_.load(std::memory_order_relaxed))
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    condition_.notify_one();
+  }
+}
+
+IoTransaction *IoQueue::pop()
+{
+  IoTransaction *tail = tail_;
+  IoTransaction *next = tail->next_.load(std::memory_order_acquire);
+
+  if (tail == &stub_)
+  {
+    if (next == 0)    // empty
+      return 0;
+    tail_ = next;
+    tail  = next;
+    next  = next->next_.load(std::memory_order_acquire);
+  }
+
+  if (next != 0)
+  {
+    tail_ = next;
+    return tail;
+  }
+
+  // tail is the last node; a producer which has swapped head_ but not linked yet is waited for at the next pop
+  if (tail != head_.load(std::memory_order_acquire))
+    return 0;
+
+  link(&stub_);
+  next = tail->next_.load(std::memory_order_acquire);
+  if (next != 0)
+  {
+    tail_ = next;
+    return tail;
+  }
+  return 0;
+}
+
+IoTransaction *IoQueue::wait(double msec)
+{
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::microseconds((long long)(msec * 1000.0));
+
+  while (true)
+  {
+    IoTransaction *transaction = pop();
+    if (transaction != 0)
+      return transaction;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    is_waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    transaction = pop();
+    if (transaction == 0)
+    {
+      if (msec < 0)
+        condition_.wait(lock);
+      else if (condition_.wait_until(lock, deadline) == std::cv_status::timeout)
+      {
+        is_waiting_.store(false, std::memory_order_relaxed);
+        return pop();
+      }
+    }
+    is_waiting_.store(false, std::memory_order_relaxed);
+
+    if (transaction != 0)
+      return transaction;
+  }
+}
+
+PortIoEngine::PortIoEngine(PortHandler *port, PacketHandler *ph)
+  : port_(port),
+    ph_(ph),
+    is_running_(false),
+    submitting_count_(0)
+{
+}
+
+bool PortIoEngine::start()
+{
+  if (thread_.joinable())
+    return false;
+
+  is_running_ = true;
+  thread_ = std::thread(&PortIoEngine::run, this);
+  return true;
+}
+
+void PortIoEngine::stop()
+{
+  if (thread_.joinable() == false)
+    return;
+
+  // from here on submit() completes the transactions itself, the ones it pushed before are ahead of stop_
+  is_running_.store(false, std::memory_order_seq_cst);
+  while (submitting_count_.load(std::memory_order_acquire) != 0)
+    std::this_thread::yield();
+
+  submission_queue_.push(&stop_);
+  thread_.join();
+}
+
+void PortIoEngine::submit(IoTransaction *transaction, IoQueue *completion_queue)
+{
+  transaction->completion_queue_ = completion_queue;
+  transaction->result_           = COMM_NOT_AVAILABLE;
+
+  // pairs with stop(): either stop() waits until the transaction is queued, or this sees the engine stopped
+  submitting_count_.fetch_add(1, std::memory_order_seq_cst);
+  if (is_running_.load(std::memory_order_seq_cst))
+  {
+    submission_queue_.push(transaction);
+    submitting_count_.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+  submitting_count_.fetch_sub(1, std::memory_order_release);
+
+  // no thread will run it, so it ends here as COMM_NOT_AVAILABLE
+  complete(transaction);
+}
+
+void PortIoEngine::complete(IoTransaction *transaction)
+{
+  // a transaction without a completion queue may be submitted again as soon as onComplete() returns
+  IoQueue *completion_queue = transaction->completion_queue_;
+
+  transaction->onComplete();
+
+  if (completion_queue != 0)
+    completion_queue->push(transaction);
+}
+
+void PortIoEngine::run()
+{
+  while (true)
+  {
+    IoTransaction *transaction = submission_queue_.wait(-1);
+    if (transaction == 0)
+      continue;
+    if (transaction == &stop_)
+      break;
+
+    transaction->result_ = transaction->execute(port_, ph_);
+    complete(transaction);
+  }
+}
@@ -0,0 +1,190 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "prepared_packet.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "prepared_packet.h"
+#endif
+
+#include <string.h>
+
+#include "byte_stuffing.h"
+#include "crc16.h"
+#include "packet_handler.h"
+
+#define PKT_HEADER0             0
+#define PKT_HEADER1             1
+#define PKT_HEADER2             2
+#define PKT_RESERVED            3
+#define PKT_ID                  4
+#define PKT_LENGTH_L            5
+#define PKT_LENGTH_H            6
+#define PKT_INSTRUCTION         7
+#define PKT_PARAMETER0          8
+
+#define TXPACKET_MAX_LEN    PortHandler::TX_PACKET_LENGTH_
+#define RXPACKET_MAX_LEN    PortHandler::RX_PACKET_LENGTH_
+
+using namespace mercury;
+
+PreparedPacket::PreparedPacket()
+  : packet_length_(0),
+    rx_length_(0),
+    id_(0),
+    instruction_(0),
+    is_stuffed_(false)
+{
+}
+
+int PreparedPacket::prepare(uint8_t id, uint8_t instruction, const uint8_t *param, uint16_t param_length, uint16_t rx_length)
+{
+  packet_length_  = 0;
+  id_             = id;
+  instruction_    = instruction;
+  rx_length_      = rx_length;
+
+  param_.assign(param, param + param_length);
+
+  return frame();
+}
+
+int PreparedPacket::preparePing(uint8_t id)
+{
+  // HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST ERROR MODEL_L MODEL_H FIRMWARE CRC16_L CRC16_H
+  return prepare(id, INST_PING, 0, 0, 14);
+}
+
+int PreparedPacket::prepareRead(uint8_t id, uint16_t address, uint16_t length)
+{
+  uint8_t param[4] = { MCY_LOBYTE(address), MCY_HIBYTE(address), MCY_LOBYTE(length), MCY_HIBYTE(length) };
+
+  return prepare(id, INST_READ, param, 4, (uint16_t)(length + 11));
+}
+
+int PreparedPacket::prepareSyncRead(uint16_t start_address, uint16_t data_length, const uint8_t *id_list, uint16_t id_count)
+{
+  uint8_t head[4] = { MCY_LOBYTE(start_address), MCY_HIBYTE(start_address), MCY_LOBYTE(data_length), MCY_HIBYTE(data_length) };
+
+  param_.assign(head, head + 4);
+  param_.insert(param_.end(), id_list, id_list + id_count);
+
+  packet_length_  = 0;
+  id_             = BROADCAST_ID;
+  instruction_    = INST_SYNC_READ;
+  rx_length_      = (uint16_t)((11 + data_length) * id_count);
+
+  return frame();
+}
+
+int PreparedPacket::prepareFastSyncRead(uint16_t start_address, uint16_t data_length, const uint8_t *id_list, uint16_t id_count)
+{
+  uint8_t head[4] = { MCY_LOBYTE(start_address), MCY_HIBYTE(start_address), MCY_LOBYTE(data_length), MCY_HIBYTE(data_length) };
+
+  packet_length_  = 0;
+
+  // 8: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST, 4: ERROR ID CRC16_L CRC16_H of each Mercury
+  uint32_t rx_length = 8 + (uint32_t)(data_length + 4) * id_count;
+  if (rx_length > RXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  param_.assign(head, head + 4);
+  param_.insert(param_.end(), id_list, id_list + id_count);
+
+  id_             = BROADCAST_ID;
+  instruction_    = INST_FAST_SYNC_READ;
+  rx_length_      = (uint16_t)rx_length;
+
+  return frame();
+}
+
+int PreparedPacket::changeParam(uint16_t offset, const uint8_t *data, uint16_t length)
+{
+  uint16_t param_length = (uint16_t)param_.size();
+
+  if (isPrepared() == false || (uint32_t)offset + length > param_length)
+    return COMM_NOT_AVAILABLE;
+
+  // the CRC16 of the changed bits, over the bytes from the first change on
+  uint16_t crc_change = 0;
+  bool is_changed = false;
+  for (uint16_t i = 0; i < length; i++)
+  {
+    uint8_t change = param_[offset + i] ^ data[i];
+    crc_change = Crc16::update(crc_change, &change, 1);
+    param_[offset + i] = data[i];
+    if (change != 0)
+      is_changed = true;
+  }
+
+  if (is_changed == false)
+    return COMM_SUCCESS;
+
+  // stuffed bytes move the bytes after them, so such a packet is framed again
+  uint32_t begin = (offset < 2) ? 0 : offset - 2;
+  uint32_t end = (uint32_t)offset + length + 2;
+  if (end > param_length)
+    end = param_length;
+  if (is_stuffed_ == true || ByteStuffing::find(&param_[begin], end - begin) < end - begin)
+    return frame();
+
+  memcpy(&packet_[PKT_PARAMETER0 + offset], data, length);
+
+  uint16_t crc_position = packet_length_ - 2;
+  uint16_t crc = MCY_MAKEWORD(packet_[crc_position], packet_[crc_position + 1]);
+  crc ^= Crc16::extend(crc_change, param_length - offset - length);
+  packet_[crc_position]     = MCY_LOBYTE(crc);
+  packet_[crc_position + 1] = MCY_HIBYTE(crc);
+
+  return COMM_SUCCESS;
+}
+
+int PreparedPacket::frame()
+{
+  uint16_t param_length = (uint16_t)param_.size();
+
+  packet_length_  = 0;
+  is_stuffed_     = false;
+
+  // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H, and one byte for each FF FF FD at most
+  if (param_length + 10 + (param_length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  packet_.resize(param_length + 10 + (param_length / 3));
+
+  // byte stuffing
+  uint16_t index = PKT_PARAMETER0 + (uint16_t)ByteStuffing::stuff(param_.data(), param_length, &packet_[PKT_PARAMETER0]);
+  is_stuffed_ = (index != PKT_PARAMETER0 + param_length);
+
+  uint16_t length = index - PKT_PARAMETER0 + 3;   // 3: INST CRC16_L CRC16_H
+
+  packet_[PKT_HEADER0]      = 0xFF;
+  packet_[PKT_HEADER1]      = 0xFF;
+  packet_[PKT_HEADER2]      = 0xFD;
+  packet_[PKT_RESERVED]     = 0x00;
+  packet_[PKT_ID]           = id_;
+  packet_[PKT_LENGTH_L]     = MCY_LOBYTE(length);
+  packet_[PKT_LENGTH_H]     = MCY_HIBYTE(length);
+  packet_[PKT_INSTRUCTION]  = instruction_;
+
+  uint16_t crc = Crc16::update(0, &packet_[0], index);
+  packet_[index++] = MCY_LOBYTE(crc);
+  packet_[index++] = MCY_HIBYTE(crc);
+
+  packet_length_ = index;
+  return COMM_SUCCESS;
+}
@@ -38,11 +38,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <debug_config.h>
 
-#define TXPACKET_MAX_LEN    (1*1024)
-#define RXPACKET_MAX_LEN    (1*1024)
+#include "byte_stuffing.h"
+#include "crc16.h"
+#include "status_packet_parser.h"
+#include "transaction_metrics.h"
+
+#define TXPACKET_MAX_LEN    PortHandler::TX_PACKET_LENGTH_
+#define RXPACKET_MAX_LEN    PortHandler::RX_PACKET_LENGTH_
 
 ///////////////// for Protocol 2.0 Packet /////////////////
 #define PKT_HEADER0             0
@@ -69,6 +75,17 @@
 
 using namespace mercury;
 
+// the status packet of a single Mercury ends the round trip
+static void endTransaction(PortHandler *port, uint8_t id, int result)
+{
+  TransactionMetrics *metrics = port->getMetrics();
+  if (metrics == 0)
+    return;
+
+  metrics->endStatus(id, result);
+  metrics->endTransaction(result);
+}
+
 Protocol2PacketHandler *Protocol2PacketHandler::unique_instance_ = new Protocol2PacketHandler();
 
 Protocol2PacketHandler::Protocol2PacketHandler() { }
@@ -149,132 +166,55 @@ const char *Protocol2PacketHandler::getRxPacketError(uint8_t error)
 
 unsigned short Protocol2PacketHandler::updateCRC(uint16_t crc_accum, uint8_t *data_blk_ptr, uint16_t data_blk_size)
 {
-  uint16_t i;
-  static const uint16_t crc_table[256] = {0x0000,
-  0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
-  0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027,
-  0x0022, 0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D,
-  0x8077, 0x0072, 0x0050, 0x8055, 0x805F, 0x005A, 0x804B,
-  0x004E, 0x0044, 0x8041, 0x80C3, 0x00C6, 0x00CC, 0x80C9,
-  0x00D8, 0x80DD, 0x80D7, 0x00D2, 0x00F0, 0x80F5, 0x80FF,
-  0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1, 0x00A0, 0x80A5,
-  0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1, 0x8093,
-  0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
-  0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197,
-  0x0192, 0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE,
-  0x01A4, 0x81A1, 0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB,
-  0x01FE, 0x01F4, 0x81F1, 0x81D3, 0x01D6, 0x01DC, 0x81D9,
-  0x01C8, 0x81CD, 0x81C7, 0x01C2, 0x0140, 0x8145, 0x814F,
-  0x014A, 0x815B, 0x015E, 0x0154, 0x8151, 0x8173, 0x0176,
-  0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162, 0x8123,
-  0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
-  0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104,
-  0x8101, 0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D,
-  0x8317, 0x0312, 0x0330, 0x8335, 0x833F, 0x033A, 0x832B,
-  0x032E, 0x0324, 0x8321, 0x0360, 0x8365, 0x836F, 0x036A,
-  0x837B, 0x037E, 0x0374, 0x8371, 0x8353, 0x0356, 0x035C,
-  0x8359, 0x0348, 0x834D, 0x8347, 0x0342, 0x03C0, 0x83C5,
-  0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1, 0x83F3,
-  0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
-  0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7,
-  0x03B2, 0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E,
-  0x0384, 0x8381, 0x0280, 0x8285, 0x828F, 0x028A, 0x829B,
-  0x029E, 0x0294, 0x8291, 0x82B3, 0x02B6, 0x02BC, 0x82B9,
-  0x02A8, 0x82AD, 0x82A7, 0x02A2, 0x82E3, 0x02E6, 0x02EC,
-  0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2, 0x02D0, 0x82D5,
-  0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1, 0x8243,
-  0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
-  0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264,
-  0x8261, 0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E,
-  0x0234, 0x8231, 0x8213, 0x0216, 0x021C, 0x8219, 0x0208,
-  0x820D, 0x8207, 0x0202 };
-
-  for (uint16_t j = 0; j < data_blk_size; j++)
-  {
-    i = ((uint16_t)(crc_accum >> 8) ^ *data_blk_ptr++) & 0xFF;
-    crc_accum = (crc_accum << 8) ^ crc_table[i];
-  }
-
-  return crc_accum;
+  return Crc16::update(crc_accum, data_blk_ptr, data_blk_size);
 }
 
 void Protocol2PacketHandler::addStuffing(uint8_t *packet)
 {
   int packet_length_in = MCY_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]);
-  int packet_length_out = packet_length_in;
   
   if (packet_length_in < 8) // INSTRUCTION, ADDR_L, ADDR_H, CRC16_L, CRC16_H + FF FF FD
     return;
 
-  uint8_t *packet_ptr;
-  uint16_t packet_length_before_crc = packet_length_in - 2;
-  for (uint16_t i = 3; i < packet_length_before_crc; i++)
-  {
-    packet_ptr = &packet[i+PKT_INSTRUCTION-2];
-    if (packet_ptr[0] == 0xFF && packet_ptr[1] == 0xFF && packet_ptr[2] == 0xFD)
-      packet_length_out++;
-  }
-  
-  if (packet_length_in == packet_length_out)  // no stuffing required
+  // the parameter lies between INSTRUCTION and CRC16
+  uint8_t *param = &packet[PKT_PARAMETER0];
+  uint32_t param_length = packet_length_in - 3;   // 3: INSTRUCTION CRC16_L CRC16_H
+
+  if (ByteStuffing::find(param, param_length) == param_length)  // no stuffing required
     return;
-  
-  uint16_t out_index  = packet_length_out + 6 - 2;  // last index before crc
-  uint16_t in_index   = packet_length_in + 6 - 2;   // last index before crc
-  while (out_index != in_index)
-  {
-    if (packet[in_index] == 0xFD && packet[in_index-1] == 0xFF && packet[in_index-2] == 0xFF)
-    {
-      packet[out_index--] = 0xFD; // byte stuffing
-      if (out_index != in_index)
-      {
-        packet[out_index--] = packet[in_index--]; // FD
-        packet[out_index--] = packet[in_index--]; // FF
-        packet[out_index--] = packet[in_index--]; // FF
-      }
-    }
-    else
-    {
-      packet[out_index--] = packet[in_index--];
-    }
-  }
 
+  uint8_t param_in[TXPACKET_MAX_LEN];
+  memcpy(param_in, param, param_length);
+  uint32_t stuffing_count = ByteStuffing::stuff(param_in, param_length, param) - param_length;
+
+  int packet_length_out = packet_length_in + stuffing_count;
   packet[PKT_LENGTH_L] = MCY_LOBYTE(packet_length_out);
   packet[PKT_LENGTH_H] = MCY_HIBYTE(packet_length_out);
 
   return;
 }
 
-void Protocol2PacketHandler::removeStuffing(uint8_t *packet)
+int Protocol2PacketHandler::txPacket(PortHandler *port, uint8_t *txpacket)
 {
-  int i = 0, index = 0;
-  int packet_length_in = MCY_MAKEWORD(packet[PKT_LENGTH_L], packet[PKT_LENGTH_H]);
-  int packet_length_out = packet_length_in;
+  // only one thread can claim the port
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
 
-  index = PKT_INSTRUCTION;
-  for (i = 0; i < packet_length_in - 2; i++)  // except CRC
-  {
-    if (packet[i+PKT_INSTRUCTION] == 0xFD && packet[i+PKT_INSTRUCTION+1] == 0xFD && packet[i+PKT_INSTRUCTION-1] == 0xFF && packet[i+PKT_INSTRUCTION-2] == 0xFF)
-    {   
-      packet_length_out--;
-      i++;
-    }
-    packet[index++] = packet[i+PKT_INSTRUCTION];
-  }
-  packet[index++] = packet[PKT_INSTRUCTION+packet_length_in-2];
-  packet[index++] = packet[PKT_INSTRUCTION+packet_length_in-1];
+  int result = sendPacket(port, txpacket);
+  if (result != COMM_SUCCESS)
+    port->is_using_ = false;
 
-  packet[PKT_LENGTH_L] = MCY_LOBYTE(packet_length_out);
-  packet[PKT_LENGTH_H] = MCY_HIBYTE(packet_length_out);
+  return result;
 }
 
-int Protocol2PacketHandler::txPacket(PortHandler *port, uint8_t *txpacket)
+// the port is held by the caller, who releases it
+int Protocol2PacketHandler::sendPacket(PortHandler *port, uint8_t *txpacket)
 {
   uint16_t total_packet_length   = 0;
   uint16_t written_packet_length = 0;
 
-  if (port->is_using_)
-    return COMM_PORT_BUSY;
-  port->is_using_ = true;
+  if (port->getMetrics() != 0)
+    port->getMetrics()->startPacket();
 
   // byte stuffing for header
   addStuffing(txpacket);
@@ -283,10 +223,7 @@ int Protocol2PacketHandler::txPacket(PortHandler *port, uint8_t *txpacket)
   total_packet_length = MCY_MAKEWORD(txpacket[PKT_LENGTH_L], txpacket[PKT_LENGTH_H]) + 7;
   // 7: HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H
   if (total_packet_length > TXPACKET_MAX_LEN)
-  {
-    port->is_using_ = false;
     return COMM_TX_ERROR;
-  }
 
   // make packet header
   txpacket[PKT_HEADER0]   = 0xFF;
@@ -312,122 +249,35 @@ int Protocol2PacketHandler::txPacket(PortHandler *port, uint8_t *txpacket)
   port->clearPort();
   written_packet_length = port->writePort(txpacket, total_packet_length);
   if (total_packet_length != written_packet_length)
-  {
-    port->is_using_ = false;
     return COMM_TX_FAIL;
-  }
+
+  if (port->getMetrics() != 0)
+    port->getMetrics()->beginTransaction(txpacket, total_packet_length);
 
   return COMM_SUCCESS;
 }
 
 int Protocol2PacketHandler::rxPacket(PortHandler *port, uint8_t *rxpacket)
 {
-  int     result         = COMM_TX_FAIL;
-
-  uint16_t rx_length     = 0;
-  uint16_t wait_length   = 11; // minimum length (HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H INST ERROR CRC16_L CRC16_H)
+  int result = receivePacket(port, rxpacket);
 
-  while(true)
-  {
-    rx_length += port->readPort(&rxpacket[rx_length], wait_length - rx_length);
-    if (rx_length >= wait_length)
-    {
-      uint16_t idx = 0;
-
-      // find packet header
-      for (idx = 0; idx < (rx_length - 3); idx++)
-      {
-        if ((rxpacket[idx] == 0xFF) && (rxpacket[idx+1] == 0xFF) && (rxpacket[idx+2] == 0xFD) && (rxpacket[idx+3] != 0xFD))
-          break;
-      }
+  port->is_using_ = false;
 
-      if (idx == 0)   // found at the beginning of the packet
-      {
-        if (rxpacket[PKT_RESERVED] != 0x00 ||
-           rxpacket[PKT_ID] > 0xFC ||
-           MCY_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) > RXPACKET_MAX_LEN ||
-           rxpacket[PKT_INSTRUCTION] != 0x55)
-        {
-          // remove the first byte in the packet
-          for (uint16_t s = 0; s < rx_length - 1; s++)
-            rxpacket[s] = rxpacket[1 + s];
-
-          rx_length -= 1;
-          continue;
-        }
+  return result;
+}
 
-        // re-calculate the exact length of the rx packet
-        if (wait_length != MCY_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) + PKT_LENGTH_H + 1)
-        {
-          wait_length = MCY_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) + PKT_LENGTH_H + 1;
-          continue;
-        } 
-
-        if (rx_length < wait_length)
-        {
-          // check timeout
-          if (port->isPacketTimeout() == true)
-          {
-            if (rx_length == 0)
-            {
-              result = COMM_RX_TIMEOUT;
-            }
-            else
-            {
-              result = COMM_RX_CORRUPT;
-            }
-            break;
-          }
-          else
-          {
-            continue;
-          }
-        }
-
-        // verify CRC16
-        uint16_t crc = MCY_MAKEWORD(rxpacket[wait_length-2], rxpacket[wait_length-1]);
-        if (updateCRC(0, rxpacket, wait_length - 2) == crc)
-        {
-          result = COMM_SUCCESS;
-        }
-        else
-        {
-          result = COMM_RX_CORRUPT;
-        }
-        break;
-      }
-      else
-      {
-        // remove unnecessary packets
-        for (uint16_t s = 0; s < rx_length - idx; s++)
-          rxpacket[s] = rxpacket[idx + s];
+// the port is held by the caller, who releases it
+int Protocol2PacketHandler::receivePacket(PortHandler *port, uint8_t *rxpacket)
+{
+  int     result         = COMM_TX_FAIL;
 
-        rx_length -= idx;
-      }
-    }
-    else
-    {
-      // check timeout
-      if (port->isPacketTimeout() == true)
-      {
-        if (rx_length == 0)
-        {
-          result = COMM_RX_TIMEOUT;
-        }
-        else
-        {
-          result = COMM_RX_CORRUPT;
-        }
-        break;
-      }
-    }
-#if defined(__linux__) || defined(__APPLE__)
-    usleep(0);
-#elif defined(_WIN32) || defined(_WIN64)
-    Sleep(0);
-#endif
-  }
+  // bytes are fed to the parser as they arrive, it keeps its place between reads
+  // so that every received byte is examined once
+  StatusPacketParser parser(rxpacket, RXPACKET_MAX_LEN);
 
+  // sleep until more bytes arrive or the packet timeout expires
+  while ((result = rxPacketNoWait(port, &parser)) == COMM_RX_WAITING)
+    port->waitPort();
 
 #ifdef DEBUG_RX_PACKET
     int total_packet_length = 7 + rxpacket[5];
@@ -438,31 +288,73 @@ int Protocol2PacketHandler::rxPacket(PortHandler *port, uint8_t *rxpacket)
     printf ("\n");
 #endif
 
-  port->is_using_ = false;
+  return result;
+}
 
-  if (result == COMM_SUCCESS)
-    removeStuffing(rxpacket);
+int Protocol2PacketHandler::rxPacketNoWait(PortHandler *port, StatusPacketParser *parser)
+{
+  while(true)
+  {
+    int consumed = 0;
+    int parsed = parser->parse(port->getRxData(), port->getRxLength(), &consumed);
 
-  return result;
+    // bytes of the following packets stay in the receive buffer
+    port->consumeRx(consumed);
+
+    if (parsed == StatusPacketParser::PARSE_PACKET)
+      return COMM_SUCCESS;
+    else if (parsed == StatusPacketParser::PARSE_CRC_ERROR)
+    {
+      if (port->getMetrics() != 0)
+        port->getMetrics()->countCrcError(port->getMetrics()->getTransactionId());
+      return COMM_RX_CORRUPT;
+    }
+
+    // read everything the port has, and give up the turn only if nothing new has arrived
+    if (port->fillRxBuffer() > 0)
+      continue;
+
+    // check timeout
+    if (port->isPacketTimeout() == true)
+    {
+      if (parser->getReceivedLength() == 0)
+        return COMM_RX_TIMEOUT;
+      return COMM_RX_CORRUPT;
+    }
+
+    return COMM_RX_WAITING;
+  }
 }
 
 // NOT for BulkRead / SyncRead instruction
 int Protocol2PacketHandler::txRxPacket(PortHandler *port, uint8_t *txpacket, uint8_t *rxpacket, uint8_t *error)
+{
+  // only one thread can claim the port
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  int result = transferPacket(port, txpacket, rxpacket, error);
+
+  port->is_using_ = false;
+
+  return result;
+}
+
+// the port is held by the caller, who releases it once the status packet has been copied out
+int Protocol2PacketHandler::transferPacket(PortHandler *port, uint8_t *txpacket, uint8_t *rxpacket, uint8_t *error)
 {
   int result = COMM_TX_FAIL;
 
   // tx packet
-  result = txPacket(port, txpacket);
+  result = sendPacket(port, txpacket);
   if (result != COMM_SUCCESS)
     return result;
 
   if (txpacket[PKT_ID] == BROADCAST_ID || txpacket[PKT_INSTRUCTION] == INST_ACTION)
-  {
-    port->is_using_ = false;
     return result;
-  }
 
   // set packet timeout
+  port->setResponderId(txpacket[PKT_ID]);
   if (txpacket[PKT_INSTRUCTION] == INST_READ)
   {
     port->setPacketTimeout((uint16_t)(MCY_MAKEWORD(txpacket[PKT_PARAMETER0+2], txpacket[PKT_PARAMETER0+3]) + 11));
@@ -475,7 +367,7 @@ int Protocol2PacketHandler::txRxPacket(PortHandler *port, uint8_t *txpacket, uin
 
   // rx packet
   do {
-    result = rxPacket(port, rxpacket);
+    result = receivePacket(port, rxpacket);
   } while (result == COMM_SUCCESS && txpacket[PKT_ID] != rxpacket[PKT_ID]);
 
   if (result == COMM_SUCCESS && txpacket[PKT_ID] == rxpacket[PKT_ID])
@@ -484,6 +376,8 @@ int Protocol2PacketHandler::txRxPacket(PortHandler *port, uint8_t *txpacket, uin
       *error = (uint8_t)rxpacket[PKT_ERROR];
   }
 
+  endTransaction(port, txpacket[PKT_ID], result);
+
   return result;
 }
 
@@ -497,7 +391,7 @@ int Protocol2PacketHandler::ping(PortHandler *port, uint8_t id, uint16_t *model_
   int result                 = COMM_TX_FAIL;
 
   uint8_t txpacket[10]        = {0};
-  uint8_t rxpacket[14]        = {0};
+  uint8_t *rxpacket           = port->getRxPacket();
 
   if (id >= BROADCAST_ID)
     return COMM_NOT_AVAILABLE;
@@ -507,10 +401,40 @@ int Protocol2PacketHandler::ping(PortHandler *port, uint8_t id, uint16_t *model_
   txpacket[PKT_LENGTH_H]      = 0;
   txpacket[PKT_INSTRUCTION]   = INST_PING;
 
-  result = txRxPacket(port, txpacket, rxpacket, error);
+  // the status packet lands in the buffer of the port, it is read before the port is released
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  result = transferPacket(port, txpacket, rxpacket, error);
   if (result == COMM_SUCCESS && model_number != 0)
     *model_number = MCY_MAKEWORD(rxpacket[PKT_PARAMETER0+1], rxpacket[PKT_PARAMETER0+2]);
 
+  port->is_using_ = false;
+
+  return result;
+}
+
+int Protocol2PacketHandler::pingTx(PortHandler *port, uint8_t id)
+{
+  int result                 = COMM_TX_FAIL;
+
+  uint8_t txpacket[10]        = {0};
+
+  if (id >= BROADCAST_ID)
+    return COMM_NOT_AVAILABLE;
+
+  txpacket[PKT_ID]            = id;
+  txpacket[PKT_LENGTH_L]      = 3;
+  txpacket[PKT_LENGTH_H]      = 0;
+  txpacket[PKT_INSTRUCTION]   = INST_PING;
+
+  result = txPacket(port, txpacket);
+
+  // set packet timeout
+  if (result == COMM_SUCCESS)
+    port->setPacketTimeout((uint16_t)14);
+    // HEADER0 HEADER1 HEADER2 RESERVED ID LENGTH_L LENGTH_H INST ERROR MODEL_L MODEL_H FW_VERSION CRC16_L CRC16_H
+
   return result;
 }
 
@@ -536,21 +460,26 @@ int Protocol2PacketHandler::broadcastPing(PortHandler *port, std::vector<uint8_t
 
   result = txPacket(port, txpacket);
   if (result != COMM_SUCCESS)
-  {
-    port->is_using_ = false;
     return result;
-  }
 
   // set rx timeout
   port->setPacketTimeout(((double)wait_length * tx_time_per_byte) + (3.0 * (double)MAX_ID) + 16.0);
 
   while(1)
   {
-    rx_length += port->readPort(&rxpacket[rx_length], wait_length - rx_length);
+    int read_length = port->readPort(&rxpacket[rx_length], wait_length - rx_length);
+    rx_length += read_length;
+    if (port->getMetrics() != 0 && read_length > 0)
+      port->getMetrics()->countRx(read_length);
     if (port->isPacketTimeout() == true)
       break;
+    port->waitPort();
   }
 
+  // every Mercury answers within the timeout, which is waited for in full
+  if (port->getMetrics() != 0)
+    port->getMetrics()->endTransaction(rx_length == 0 ? COMM_RX_TIMEOUT : COMM_SUCCESS);
+
   port->is_using_ = false;
 
   if (rx_length == 0)
@@ -625,7 +554,7 @@ int Protocol2PacketHandler::action(PortHandler *port, uint8_t id)
 int Protocol2PacketHandler::reboot(PortHandler *port, uint8_t id, uint8_t *error)
 {
   uint8_t txpacket[10]        = {0};
-  uint8_t rxpacket[11]        = {0};
+  uint8_t *rxpacket           = port->getRxPacket();
 
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = 3;
@@ -638,7 +567,7 @@ int Protocol2PacketHandler::reboot(PortHandler *port, uint8_t id, uint8_t *error
 int Protocol2PacketHandler::clearMultiTurn(PortHandler *port, uint8_t id, uint8_t *error)
 {
   uint8_t txpacket[15]        = {0};
-  uint8_t rxpacket[11]        = {0};
+  uint8_t *rxpacket           = port->getRxPacket();
 
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = 8;
@@ -656,7 +585,7 @@ int Protocol2PacketHandler::clearMultiTurn(PortHandler *port, uint8_t id, uint8_
 int Protocol2PacketHandler::factoryReset(PortHandler *port, uint8_t id, uint8_t option, uint8_t *error)
 {
   uint8_t txpacket[11]        = {0};
-  uint8_t rxpacket[11]        = {0};
+  uint8_t *rxpacket           = port->getRxPacket();
 
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = 4;
@@ -697,15 +626,15 @@ int Protocol2PacketHandler::readTx(PortHandler *port, uint8_t id, uint16_t addre
 int Protocol2PacketHandler::readRx(PortHandler *port, uint8_t id, uint16_t length, uint8_t *data, uint8_t *error)
 {
   int result                  = COMM_TX_FAIL;
-  uint8_t *rxpacket           = (uint8_t *)malloc(RXPACKET_MAX_LEN);
-  
-  if (rxpacket == NULL)
-    return result;
-  
+  uint8_t *rxpacket           = port->getRxPacket();
+
+  port->setResponderId(id);
   do {
-    result = rxPacket(port, rxpacket);
+    result = receivePacket(port, rxpacket);
   } while (result == COMM_SUCCESS && rxpacket[PKT_ID] != id);
 
+  endTransaction(port, id, result);
+
   if (result == COMM_SUCCESS && rxpacket[PKT_ID] == id)
   {
     if (error != 0)
@@ -717,7 +646,9 @@ int Protocol2PacketHandler::readRx(PortHandler *port, uint8_t id, uint16_t lengt
     }
   }
 
-  free(rxpacket);
+  // the port was held since readTx()
+  port->is_using_ = false;
+
   return result;
 }
 
@@ -726,16 +657,10 @@ int Protocol2PacketHandler::readTxRx(PortHandler *port, uint8_t id, uint16_t add
   int result                  = COMM_TX_FAIL;
 
   uint8_t txpacket[14]        = {0};
-  uint8_t *rxpacket           = (uint8_t *)malloc(RXPACKET_MAX_LEN);
+  uint8_t *rxpacket           = port->getRxPacket();
 
-  if (rxpacket == NULL)
-    return result;
-  
   if (id >= BROADCAST_ID)
-  {
-    free(rxpacket);
     return COMM_NOT_AVAILABLE;
-  }
 
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = 7;
@@ -746,19 +671,21 @@ int Protocol2PacketHandler::readTxRx(PortHandler *port, uint8_t id, uint16_t add
   txpacket[PKT_PARAMETER0+2]  = (uint8_t)MCY_LOBYTE(length);
   txpacket[PKT_PARAMETER0+3]  = (uint8_t)MCY_HIBYTE(length);
 
-  result = txRxPacket(port, txpacket, rxpacket, error);
+  // the status packet lands in the buffer of the port, it is read before the port is released
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  result = transferPacket(port, txpacket, rxpacket, error);
   if (result == COMM_SUCCESS)
   {
-    if (error != 0)
-      *error = (uint8_t)rxpacket[PKT_ERROR];
-
     for (uint16_t s = 0; s < length; s++)
     {
       data[s] = rxpacket[PKT_PARAMETER0 + 1 + s];
     }
   }
 
-  free(rxpacket);
+  port->is_using_ = false;
+
   return result;
 }
 
@@ -829,10 +756,14 @@ int Protocol2PacketHandler::writeTxOnly(PortHandler *port, uint8_t id, uint16_t
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));
-  
-  if (txpacket == NULL)
-    return result;
+  uint8_t *txpacket           = port->getTxPacket();
+
+  if (length + 12 + (length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
 
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(length+5);
@@ -844,10 +775,46 @@ int Protocol2PacketHandler::writeTxOnly(PortHandler *port, uint8_t id, uint16_t
   for (uint16_t s = 0; s < length; s++)
     txpacket[PKT_PARAMETER0+2+s] = data[s];
 
-  result = txPacket(port, txpacket);
+  result = sendPacket(port, txpacket);
   port->is_using_ = false;
 
-  free(txpacket);
+  return result;
+}
+
+int Protocol2PacketHandler::writeTx(PortHandler *port, uint8_t id, uint16_t address, uint16_t length, uint8_t *data)
+{
+  int result                  = COMM_TX_FAIL;
+
+  uint8_t *txpacket           = port->getTxPacket();
+
+  if (id >= BROADCAST_ID)
+    return COMM_NOT_AVAILABLE;
+
+  if (length + 12 + (length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  txpacket[PKT_ID]            = id;
+  txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(length+5);
+  txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(length+5);
+  txpacket[PKT_INSTRUCTION]   = INST_WRITE;
+  txpacket[PKT_PARAMETER0+0]  = (uint8_t)MCY_LOBYTE(address);
+  txpacket[PKT_PARAMETER0+1]  = (uint8_t)MCY_HIBYTE(address);
+
+  for (uint16_t s = 0; s < length; s++)
+    txpacket[PKT_PARAMETER0+2+s] = data[s];
+
+  result = sendPacket(port, txpacket);
+
+  // set packet timeout, the port stays claimed for the status packet
+  if (result == COMM_SUCCESS)
+    port->setPacketTimeout((uint16_t)11);
+  else
+    port->is_using_ = false;
+
   return result;
 }
 
@@ -855,12 +822,15 @@ int Protocol2PacketHandler::writeTxRx(PortHandler *port, uint8_t id, uint16_t ad
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));
-  uint8_t rxpacket[11]        = {0};
+  uint8_t *txpacket           = port->getTxPacket();
+
+  if (length + 12 + (length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
 
-  if (txpacket == NULL)
-    return result;
-  
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(length+5);
   txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(length+5);
@@ -871,9 +841,9 @@ int Protocol2PacketHandler::writeTxRx(PortHandler *port, uint8_t id, uint16_t ad
   for (uint16_t s = 0; s < length; s++)
     txpacket[PKT_PARAMETER0+2+s] = data[s];
 
-  result = txRxPacket(port, txpacket, rxpacket, error);
+  result = transferPacket(port, txpacket, port->getRxPacket(), error);
+  port->is_using_ = false;
 
-  free(txpacket);
   return result;
 }
 
@@ -914,11 +884,15 @@ int Protocol2PacketHandler::regWriteTxOnly(PortHandler *port, uint8_t id, uint16
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));
+  uint8_t *txpacket           = port->getTxPacket();
 
-  if (txpacket == NULL)
-    return result;
+  if (length + 12 + (length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
   
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(length+5);
   txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(length+5);
@@ -929,10 +903,9 @@ int Protocol2PacketHandler::regWriteTxOnly(PortHandler *port, uint8_t id, uint16
   for (uint16_t s = 0; s < length; s++)
     txpacket[PKT_PARAMETER0+2+s] = data[s];
 
-  result = txPacket(port, txpacket);
+  result = sendPacket(port, txpacket);
   port->is_using_ = false;
 
-  free(txpacket);
   return result;
 }
 
@@ -940,12 +913,15 @@ int Protocol2PacketHandler::regWriteTxRx(PortHandler *port, uint8_t id, uint16_t
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(length + 12 + (length / 3));
-  uint8_t rxpacket[11]        = {0};
+  uint8_t *txpacket           = port->getTxPacket();
+
+  if (length + 12 + (length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
 
-  if (txpacket == NULL)
-    return result;
-  
   txpacket[PKT_ID]            = id;
   txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(length+5);
   txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(length+5);
@@ -956,9 +932,9 @@ int Protocol2PacketHandler::regWriteTxRx(PortHandler *port, uint8_t id, uint16_t
   for (uint16_t s = 0; s < length; s++)
     txpacket[PKT_PARAMETER0+2+s] = data[s];
 
-  result = txRxPacket(port, txpacket, rxpacket, error);
+  result = transferPacket(port, txpacket, port->getRxPacket(), error);
+  port->is_using_ = false;
 
-  free(txpacket);
   return result;
 }
 
@@ -966,12 +942,16 @@ int Protocol2PacketHandler::syncReadTx(PortHandler *port, uint16_t start_address
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 14 + (param_length / 3));
+  uint8_t *txpacket           = port->getTxPacket();
   // 14: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
 
-  if (txpacket == NULL)
-    return result;
-  
+  if (param_length + 14 + (param_length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
@@ -984,11 +964,385 @@ int Protocol2PacketHandler::syncReadTx(PortHandler *port, uint16_t start_address
   for (uint16_t s = 0; s < param_length; s++)
     txpacket[PKT_PARAMETER0+4+s] = param[s];
 
-  result = txPacket(port, txpacket);
+  result = sendPacket(port, txpacket);
   if (result == COMM_SUCCESS)
     port->setPacketTimeout((uint16_t)((11 + data_length) * param_length));
+  else
+    port->is_using_ = false;
+
+  return result;
+}
+
+int Protocol2PacketHandler::syncReadRx(PortHandler *port, uint16_t data_length, uint8_t *id_list, uint16_t id_count, uint8_t **data_list, uint8_t **error_list, int *result_list)
+{
+  return readStatusRx(port, id_list, id_count, data_length, 0, data_list, error_list, result_list);
+}
+
+// the data of each Mercury is data_length_list[i], or data_length when there is no list
+int Protocol2PacketHandler::readStatusRx(PortHandler *port, uint8_t *id_list, uint16_t id_count, uint16_t data_length, uint16_t *data_length_list, uint8_t **data_list, uint8_t **error_list, int *result_list)
+{
+  int result                  = COMM_SUCCESS;
+  uint16_t waiting            = id_count;
+  uint16_t next               = 0;    // the Mercurys answer in the order of id_list
+  TransactionMetrics *metrics = port->getMetrics();
+
+  // the packet timeout set by syncReadTx() / bulkReadTx() covers the (11 + data length) bytes of every status packet,
+  // all of them are parsed from the receive buffer in a single pass
+  StatusPacketParser parser(port->getRxPacket(), RXPACKET_MAX_LEN);
+
+  for (uint16_t i = 0; i < id_count; i++)
+    result_list[i] = COMM_RX_WAITING;
+
+  // only the first status packet follows the return delay, the others stream in right behind it
+  if (id_count > 0)
+    port->setResponderId(id_list[0]);
+
+  while (waiting > 0)
+  {
+    int consumed = 0;
+    int parsed = parser.parse(port->getRxData(), port->getRxLength(), &consumed);
+    port->consumeRx(consumed);
+
+    if (parsed != StatusPacketParser::PARSE_INCOMPLETE)
+    {
+      uint8_t *rxpacket = parser.getPacket();
+
+      // find the ID, a packet from an ID which is not waiting is ignored
+      uint16_t i = next;
+      for (uint16_t n = 0; n < id_count; n++, i++)
+      {
+        if (i == id_count)
+          i = 0;
+        if (id_list[i] == rxpacket[PKT_ID] && result_list[i] == COMM_RX_WAITING)
+          break;
+      }
+      if (i == id_count || id_list[i] != rxpacket[PKT_ID] || result_list[i] != COMM_RX_WAITING)
+        continue;
+
+      uint16_t length = (data_length_list != 0) ? data_length_list[i] : data_length;
+      if (parsed == StatusPacketParser::PARSE_PACKET &&
+          MCY_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]) == length + 4)
+      {
+        if (error_list != 0)
+          *error_list[i] = rxpacket[PKT_ERROR];
+        for (uint16_t s = 0; s < length; s++)
+          data_list[i][s] = rxpacket[PKT_PARAMETER0 + 1 + s];
+        result_list[i] = COMM_SUCCESS;
+      }
+      else
+      {
+        if (metrics != 0 && parsed == StatusPacketParser::PARSE_CRC_ERROR)
+          metrics->countCrcError(id_list[i]);
+        result_list[i] = COMM_RX_CORRUPT;
+      }
+
+      // each Mercury has its own round trip, until its status packet
+      if (metrics != 0)
+        metrics->endStatus(id_list[i], result_list[i]);
+
+      waiting--;
+      next = i + 1;
+      continue;
+    }
+
+    // read everything the port has, and sleep only if nothing new has arrived
+    if (port->fillRxBuffer() > 0)
+      continue;
+
+    if (port->isPacketTimeout() == true)
+      break;
+
+    port->waitPort();
+  }
+
+  // the Mercury expected next is the one whose packet was cut short, if any
+  bool is_cut_short = parser.isInPacket();
+  for (uint16_t n = 0, i = next; n < id_count; n++, i++)
+  {
+    if (i >= id_count)
+      i = 0;
+    if (result_list[i] == COMM_RX_WAITING)
+    {
+      result_list[i] = is_cut_short ? COMM_RX_CORRUPT : COMM_RX_TIMEOUT;
+      is_cut_short = false;
+      if (metrics != 0)
+        metrics->endStatus(id_list[i], result_list[i]);
+    }
+  }
+
+  for (uint16_t i = 0; i < id_count; i++)
+  {
+    if (result_list[i] != COMM_SUCCESS)
+    {
+      result = result_list[i];
+      break;
+    }
+  }
+
+  if (metrics != 0)
+    metrics->endTransaction(result);
+
+  // the port was held since the instruction packet, its receive buffer has been copied out
+  port->is_using_ = false;
+
+  return result;
+}
+
+int Protocol2PacketHandler::fastSyncReadTx(PortHandler *port, uint16_t start_address, uint16_t data_length, uint8_t *param, uint16_t param_length)
+{
+  int result                  = COMM_TX_FAIL;
+
+  uint8_t *txpacket           = port->getTxPacket();
+  // 14: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
+
+  if (param_length + 14 + (param_length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // 8: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST, 4: ERROR ID CRC16_L CRC16_H of each Mercury
+  uint32_t rx_length          = 8 + (uint32_t)(data_length + 4) * param_length;
+  if (rx_length > RXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  txpacket[PKT_ID]            = BROADCAST_ID;
+  txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
+  txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
+  txpacket[PKT_INSTRUCTION]   = INST_FAST_SYNC_READ;
+  txpacket[PKT_PARAMETER0+0]  = MCY_LOBYTE(start_address);
+  txpacket[PKT_PARAMETER0+1]  = MCY_HIBYTE(start_address);
+  txpacket[PKT_PARAMETER0+2]  = MCY_LOBYTE(data_length);
+  txpacket[PKT_PARAMETER0+3]  = MCY_HIBYTE(data_length);
+
+  for (uint16_t s = 0; s < param_length; s++)
+    txpacket[PKT_PARAMETER0+4+s] = param[s];
+
+  result = sendPacket(port, txpacket);
+  if (result == COMM_SUCCESS)
+    port->setPacketTimeout((uint16_t)rx_length);
+  else
+    port->is_using_ = false;
+
+  return result;
+}
+
+int Protocol2PacketHandler::fastSyncReadRx(PortHandler *port, uint16_t data_length, uint8_t *id_list, uint16_t id_count, uint8_t **data_list, uint8_t **error_list, int *result_list)
+{
+  return fastReadRx(port, id_list, id_count, data_length, 0, data_list, error_list, result_list);
+}
+
+int Protocol2PacketHandler::fastBulkReadTx(PortHandler *port, uint8_t *param, uint16_t param_length)
+{
+  int result                  = COMM_TX_FAIL;
+
+  uint8_t *txpacket           = port->getTxPacket();
+  // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H
+
+  if (param_length + 10 + (param_length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // 8: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST, 4: ERROR ID CRC16_L CRC16_H of each Mercury
+  uint32_t rx_length          = 8;
+  for (uint16_t i = 0; i < param_length; i += 5)
+    rx_length += MCY_MAKEWORD(param[i+3], param[i+4]) + 4;
+  if (rx_length > RXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  txpacket[PKT_ID]            = BROADCAST_ID;
+  txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
+  txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
+  txpacket[PKT_INSTRUCTION]   = INST_FAST_BULK_READ;
+
+  for (uint16_t s = 0; s < param_length; s++)
+    txpacket[PKT_PARAMETER0+s] = param[s];
+
+  result = sendPacket(port, txpacket);
+  if (result == COMM_SUCCESS)
+    port->setPacketTimeout((uint16_t)rx_length);
+  else
+    port->is_using_ = false;
+
+  return result;
+}
+
+int Protocol2PacketHandler::fastBulkReadRx(PortHandler *port, uint8_t *id_list, uint16_t id_count, uint16_t *data_length_list, uint8_t **data_list, uint8_t **error_list, int *result_list)
+{
+  return fastReadRx(port, id_list, id_count, 0, data_length_list, data_list, error_list, result_list);
+}
+
+// the data of each Mercury is data_length_list[i], or data_length when there is no list
+int Protocol2PacketHandler::fastReadRx(PortHandler *port, uint8_t *id_list, uint16_t id_count, uint16_t data_length, uint16_t *data_length_list, uint8_t **data_list, uint8_t **error_list, int *result_list)
+{
+  int result                  = COMM_TX_FAIL;
+  int parsed                  = StatusPacketParser::PARSE_INCOMPLETE;
+  uint8_t *rxpacket           = port->getRxPacket();
+
+  StatusPacketParser parser(rxpacket, RXPACKET_MAX_LEN);
+
+  // the first Mercury starts the status packet, the others append to it
+  if (id_count > 0)
+    port->setResponderId(id_list[0]);
+
+  while(true)
+  {
+    int consumed = 0;
+    parsed = parser.parse(port->getRxData(), port->getRxLength(), &consumed);
+    port->consumeRx(consumed);
+
+    // packets of single Mercurys are not part of the answer
+    if (parsed != StatusPacketParser::PARSE_INCOMPLETE && rxpacket[PKT_ID] == BROADCAST_ID)
+      break;
+    if (parsed != StatusPacketParser::PARSE_INCOMPLETE)
+      continue;
+
+    // read everything the port has, and sleep only if nothing new has arrived
+    if (port->fillRxBuffer() > 0)
+      continue;
+
+    if (port->isPacketTimeout() == true)
+      break;
+
+    port->waitPort();
+  }
+
+  if (parsed == StatusPacketParser::PARSE_INCOMPLETE)
+    result = (parser.getReceivedLength() == 0) ? COMM_RX_TIMEOUT : COMM_RX_CORRUPT;
+  else if (parsed == StatusPacketParser::PARSE_CRC_ERROR)
+    result = COMM_RX_CORRUPT;
+  else
+    result = COMM_SUCCESS;
+
+  TransactionMetrics *metrics = port->getMetrics();
+  if (metrics != 0 && parsed == StatusPacketParser::PARSE_CRC_ERROR)
+    metrics->countCrcError(BROADCAST_ID);
+
+  // ERROR ID DATA CRC16_L CRC16_H of each Mercury follow the instruction,
+  // the CRC after the last one is the CRC of the packet
+  uint16_t packet_length      = MCY_MAKEWORD(rxpacket[PKT_LENGTH_L], rxpacket[PKT_LENGTH_H]);
+  uint16_t expected_length    = 1;
+  for (uint16_t i = 0; i < id_count; i++)
+    expected_length += (data_length_list != 0 ? data_length_list[i] : data_length) + 4;
+
+  if (result == COMM_SUCCESS && packet_length != expected_length)
+    result = COMM_RX_CORRUPT;
+
+  uint16_t idx = PKT_PARAMETER0;
+  for (uint16_t i = 0; i < id_count; i++)
+  {
+    uint16_t length = (data_length_list != 0) ? data_length_list[i] : data_length;
+
+    if (result != COMM_SUCCESS)
+    {
+      result_list[i] = result;
+    }
+    else if (rxpacket[idx+1] != id_list[i])
+    {
+      result_list[i] = COMM_RX_CORRUPT;
+    }
+    else
+    {
+      if (error_list != 0)
+        *error_list[i] = rxpacket[idx];
+      for (uint16_t s = 0; s < length; s++)
+        data_list[i][s] = rxpacket[idx + 2 + s];
+      result_list[i] = COMM_SUCCESS;
+    }
+    idx += length + 4;
+
+    if (metrics != 0)
+      metrics->endStatus(id_list[i], result_list[i]);
+  }
+
+  for (uint16_t i = 0; i < id_count; i++)
+  {
+    if (result_list[i] != COMM_SUCCESS)
+    {
+      result = result_list[i];
+      break;
+    }
+  }
+
+  if (metrics != 0)
+    metrics->endTransaction(result);
+
+  // the port was held since the instruction packet, its receive buffer has been copied out
+  port->is_using_ = false;
+
+  return result;
+}
+
+int Protocol2PacketHandler::bulkReadTx(PortHandler *port, uint8_t *param, uint16_t param_length)
+{
+  int result                  = COMM_TX_FAIL;
+
+  uint8_t *txpacket           = port->getTxPacket();
+  // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H
+
+  if (param_length + 10 + (param_length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  txpacket[PKT_ID]            = BROADCAST_ID;
+  txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
+  txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
+  txpacket[PKT_INSTRUCTION]   = INST_BULK_READ;
+
+  for (uint16_t s = 0; s < param_length; s++)
+    txpacket[PKT_PARAMETER0+s] = param[s];
+
+  result = sendPacket(port, txpacket);
+  if (result == COMM_SUCCESS)
+  {
+    uint32_t wait_length = 0;
+    for (uint16_t i = 0; i < param_length; i += 5)
+      wait_length += MCY_MAKEWORD(param[i+3], param[i+4]) + 11;
+    port->setPacketTimeout((uint16_t)wait_length);
+  }
+  else
+    port->is_using_ = false;
+
+  return result;
+}
+
+int Protocol2PacketHandler::bulkReadRx(PortHandler *port, uint8_t *id_list, uint16_t id_count, uint16_t *data_length_list, uint8_t **data_list, uint8_t **error_list, int *result_list)
+{
+  return readStatusRx(port, id_list, id_count, 0, data_length_list, data_list, error_list, result_list);
+}
+
+int Protocol2PacketHandler::bulkWriteTxOnly(PortHandler *port, uint8_t *param, uint16_t param_length)
+{
+  int result                  = COMM_TX_FAIL;
+
+  uint8_t *txpacket           = port->getTxPacket();
+  // 10: HEADER0 HEADER1 HEADER2 RESERVED ID LEN_L LEN_H INST CRC16_L CRC16_H
+
+  if (param_length + 10 + (param_length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  txpacket[PKT_ID]            = BROADCAST_ID;
+  txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
+  txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(param_length + 3); // 3: INST CRC16_L CRC16_H
+  txpacket[PKT_INSTRUCTION]   = INST_BULK_WRITE;
+
+  for (uint16_t s = 0; s < param_length; s++)
+    txpacket[PKT_PARAMETER0+s] = param[s];
+
+  result = sendPacket(port, txpacket);
+  port->is_using_ = false;
 
-  free(txpacket);
   return result;
 }
 
@@ -996,11 +1350,15 @@ int Protocol2PacketHandler::syncWriteTxOnly(PortHandler *port, uint16_t start_ad
 {
   int result                  = COMM_TX_FAIL;
 
-  uint8_t *txpacket           = (uint8_t *)malloc(param_length + 14 + (param_length / 3));
+  uint8_t *txpacket           = port->getTxPacket();
+
+  if (param_length + 14 + (param_length / 3) > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // the packet is built in the buffer of the port, so the port is claimed first
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
 
-  if (txpacket == NULL)
-    return result;
-  
   txpacket[PKT_ID]            = BROADCAST_ID;
   txpacket[PKT_LENGTH_L]      = MCY_LOBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
   txpacket[PKT_LENGTH_H]      = MCY_HIBYTE(param_length + 7); // 7: INST START_ADDR_L START_ADDR_H DATA_LEN_L DATA_LEN_H CRC16_L CRC16_H
@@ -1013,9 +1371,69 @@ int Protocol2PacketHandler::syncWriteTxOnly(PortHandler *port, uint16_t start_ad
   for (uint16_t s = 0; s < param_length; s++)
     txpacket[PKT_PARAMETER0+4+s] = param[s];
 
-  result = txRxPacket(port, txpacket, 0, 0);
+  result = sendPacket(port, txpacket);
+  port->is_using_ = false;
+
+  return result;
+}
+
+// writes a framed packet, the port stays in use when it succeeds
+int Protocol2PacketHandler::writePacket(PortHandler *port, uint8_t *packet, uint16_t length)
+{
+  if (length > TXPACKET_MAX_LEN)
+    return COMM_TX_ERROR;
+
+  // only one thread can claim the port
+  if (port->is_using_.exchange(true))
+    return COMM_PORT_BUSY;
+
+  if (port->getMetrics() != 0)
+    port->getMetrics()->startPacket();
+
+  // tx packet
+  port->clearPort();
+  int written_packet_length = port->writePort(packet, length);
+  if (written_packet_length != length)
+  {
+    port->is_using_ = false;
+    return COMM_TX_FAIL;
+  }
+
+  if (port->getMetrics() != 0)
+    port->getMetrics()->beginTransaction(packet, length);
+
+  return COMM_SUCCESS;
+}
+
+int Protocol2PacketHandler::framedPacketTxOnly(PortHandler *port, uint8_t *packet, uint16_t length)
+{
+  int result = writePacket(port, packet, length);
+  if (result == COMM_SUCCESS)
+    port->is_using_ = false;
+
+  return result;
+}
+
+int Protocol2PacketHandler::txPreparedPacket(PortHandler *port, PreparedPacket *packet)
+{
+  if (packet->isPrepared() == false)
+    return COMM_NOT_AVAILABLE;
+
+  int result = writePacket(port, packet->getPacket(), packet->getPacketLength());
+  if (result != COMM_SUCCESS)
+    return result;
+
+  if (packet->getRxLength() == 0)
+  {
+    port->is_using_ = false;
+    return result;
+  }
+
+  // set packet timeout
+  if (packet->getId() != BROADCAST_ID)
+    port->setResponderId(packet->getId());
+  port->setPacketTimeout(packet->getRxLength());
 
-  free(txpacket);
   return result;
 }
 
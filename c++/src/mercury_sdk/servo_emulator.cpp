@@ -0,0 +1,214 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "servo_emulator.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "servo_emulator.h"
+#endif
+
+#include <string.h>
+
+#define ERRNUM_DATA_RANGE       4       // Data range error
+#define ERRNUM_DATA_LENGTH      5       // Data length error
+#define ERRNUM_ACCESS           7       // Access error
+
+#define DEFAULT_ID              1
+#define DEFAULT_BAUDNUM         3       // 1 Mbps
+#define DEFAULT_RETURN_DELAY    50      // 100 usec
+#define POSITION_PER_TURN       4096
+
+using namespace mercury;
+
+static const int baudrate_table[] = { 9600, 57600, 115200, 1000000, 2000000, 3000000, 4000000, 4500000 };
+
+ServoEmulator::ServoEmulator(uint8_t id, uint16_t model_number)
+  : model_number_(model_number),
+    is_synchronisation_required_(false),
+    reg_address_(0),
+    reg_length_(0)
+{
+  memset(table_, 0, sizeof(table_));
+  setDefaults(0, CONTROL_TABLE_SIZE_);
+  table_[ADDR_ID] = id;
+}
+
+uint16_t ServoEmulator::getModelNumber()
+{
+  return (uint16_t)(table_[ADDR_MODEL_NUMBER] | (table_[ADDR_MODEL_NUMBER + 1] << 8));
+}
+
+int ServoEmulator::getBaudRate()
+{
+  if (table_[ADDR_BAUDRATE] >= sizeof(baudrate_table) / sizeof(baudrate_table[0]))
+    return 0;
+  return baudrate_table[table_[ADDR_BAUDRATE]];
+}
+
+void ServoEmulator::setSynchronisationRequired(bool is_required)
+{
+  is_synchronisation_required_ = is_required;
+  if (is_required)
+    table_[ADDR_HARDWARE_STATUS] |= 0x02;
+  else
+    table_[ADDR_HARDWARE_STATUS] &= ~0x02;
+}
+
+uint8_t ServoEmulator::read(uint16_t address, uint16_t length, uint8_t *data)
+{
+  if (address + length > CONTROL_TABLE_SIZE_)
+    return ERRNUM_ACCESS;
+
+  memcpy(data, &table_[address], length);
+  return 0;
+}
+
+uint8_t ServoEmulator::write(uint16_t address, uint16_t length, const uint8_t *data)
+{
+  if (address + length > CONTROL_TABLE_SIZE_)
+    return ERRNUM_ACCESS;
+
+  // read only bytes, and the EEPROM area while the torque holds the servo
+  for (uint16_t a = address; a < address + length; a++)
+  {
+    if (a < ADDR_ID
+        || (a >= ADDR_PRESENT_POSITION && a < ADDR_PRESENT_POSITION + 4)
+        || a == ADDR_HARDWARE_STATUS
+        || (a < ADDR_CONTROL_ENABLE && isTorqueEnabled()))
+      return ERRNUM_ACCESS;
+  }
+  if (address <= ADDR_BAUDRATE && address + length > ADDR_BAUDRATE
+      && data[ADDR_BAUDRATE - address] >= sizeof(baudrate_table) / sizeof(baudrate_table[0]))
+    return ERRNUM_DATA_RANGE;
+
+  memcpy(&table_[address], data, length);
+  applyWrite(address, length);
+  return 0;
+}
+
+uint8_t ServoEmulator::regWrite(uint16_t address, uint16_t length, const uint8_t *data)
+{
+  if (address + length > CONTROL_TABLE_SIZE_)
+    return ERRNUM_ACCESS;
+
+  reg_address_ = address;
+  reg_length_  = length;
+  memcpy(reg_data_, data, length);
+  return 0;
+}
+
+uint8_t ServoEmulator::action()
+{
+  if (reg_length_ == 0)
+    return 0;
+
+  uint16_t length = reg_length_;
+  reg_length_ = 0;
+  return write(reg_address_, length, reg_data_);
+}
+
+void ServoEmulator::reboot()
+{
+  setDefaults(ADDR_CONTROL_ENABLE, CONTROL_TABLE_SIZE_);
+  reg_length_ = 0;
+}
+
+uint8_t ServoEmulator::factoryReset(uint8_t option)
+{
+  if (option != 0xFF && option != 0x01 && option != 0x02)
+    return ERRNUM_DATA_RANGE;
+
+  uint8_t id        = table_[ADDR_ID];
+  uint8_t baudnum   = table_[ADDR_BAUDRATE];
+
+  setDefaults(0, CONTROL_TABLE_SIZE_);
+  reg_length_ = 0;
+
+  if (option != 0xFF)
+    table_[ADDR_ID] = id;
+  if (option == 0x02)
+    table_[ADDR_BAUDRATE] = baudnum;
+  return 0;
+}
+
+uint8_t ServoEmulator::clear(const uint8_t *param, uint16_t length)
+{
+  static const uint8_t clear_multi_turn[5] = { 0x01, 0x44, 0x58, 0x4C, 0x22 };
+
+  if (length != sizeof(clear_multi_turn))
+    return ERRNUM_DATA_LENGTH;
+  if (memcmp(param, clear_multi_turn, sizeof(clear_multi_turn)) != 0)
+    return ERRNUM_DATA_RANGE;
+
+  int32_t position = getValue(ADDR_PRESENT_POSITION) % POSITION_PER_TURN;
+  if (position < 0)
+    position += POSITION_PER_TURN;
+  setValue(ADDR_PRESENT_POSITION, 4, (uint32_t)position);
+  setValue(ADDR_GOAL_POSITION, 4, (uint32_t)position);
+  return 0;
+}
+
+void ServoEmulator::setDefaults(uint16_t begin, uint16_t end)
+{
+  uint8_t defaults[CONTROL_TABLE_SIZE_];
+
+  memset(defaults, 0, sizeof(defaults));
+  defaults[ADDR_MODEL_NUMBER]       = (uint8_t)(model_number_ & 0xFF);
+  defaults[ADDR_MODEL_NUMBER + 1]   = (uint8_t)(model_number_ >> 8);
+  defaults[ADDR_FIRMWARE_VERSION]   = FIRMWARE_VERSION_;
+  defaults[ADDR_ID]                 = DEFAULT_ID;
+  defaults[ADDR_BAUDRATE]           = DEFAULT_BAUDNUM;
+  defaults[ADDR_RETURN_DELAY_TIME]  = DEFAULT_RETURN_DELAY;
+  defaults[ADDR_OPERATING_MODE]     = 3;    // position control
+  if (is_synchronisation_required_)
+    defaults[ADDR_HARDWARE_STATUS]  = 0x02;
+
+  // the servo doesn't move, so the present position is kept
+  memcpy(&defaults[ADDR_PRESENT_POSITION], &table_[ADDR_PRESENT_POSITION], 4);
+
+  memcpy(&table_[begin], &defaults[begin], end - begin);
+}
+
+void ServoEmulator::setValue(uint16_t address, uint16_t length, uint32_t value)
+{
+  for (uint16_t s = 0; s < length; s++)
+    table_[address + s] = (uint8_t)(value >> (8 * s));
+}
+
+int32_t ServoEmulator::getValue(uint16_t address)
+{
+  return (int32_t)((uint32_t)table_[address] | ((uint32_t)table_[address + 1] << 8)
+                 | ((uint32_t)table_[address + 2] << 16) | ((uint32_t)table_[address + 3] << 24));
+}
+
+// the effects of a write which the servo carries out at once
+void ServoEmulator::applyWrite(uint16_t address, uint16_t length)
+{
+  if (address <= ADDR_CONTROL_ENABLE && address + length > ADDR_CONTROL_ENABLE)
+  {
+    // 0x02 runs the synchronisation, which the emulated servo finishes immediately
+    if (table_[ADDR_CONTROL_ENABLE] == 0x02)
+    {
+      table_[ADDR_HARDWARE_STATUS] &= ~0x02;
+      table_[ADDR_CONTROL_ENABLE] = 0;
+    }
+  }
+
+  // the emulated servo reaches its goal as soon as it is given, while the torque is enabled
+  if (isTorqueEnabled())
+    memcpy(&table_[ADDR_PRESENT_POSITION], &table_[ADDR_GOAL_POSITION], 4);
+}
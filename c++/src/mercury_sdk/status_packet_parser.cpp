@@ -0,0 +1,283 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "status_packet_parser.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "status_packet_parser.h"
+#endif
+
+#include <string.h>
+
+#include "byte_stuffing.h"
+#include "crc16.h"
+#include "packet_handler.h"
+
+#define PKT_RESERVED            3
+#define PKT_ID                  4
+#define PKT_LENGTH_L            5
+#define PKT_LENGTH_H            6
+#define PKT_INSTRUCTION         7
+#define PKT_ERROR               8
+#define PKT_PARAMETER0          9   // first byte of the data in a status packet
+
+#define MIN_PACKET_LENGTH       4   // LENGTH of a status packet without parameters (INST ERROR CRC16_L CRC16_H)
+
+using namespace mercury;
+
+StatusPacketParser::StatusPacketParser(uint8_t *packet, uint16_t capacity)
+  : packet_(packet),
+    capacity_(capacity)
+{
+  reset();
+}
+
+void StatusPacketParser::reset()
+{
+  state_            = STATE_HEADER0;
+  index_            = 0;
+  body_remaining_   = 0;
+  crc_              = 0;
+  stuffing_window_  = 0;
+  received_length_  = 0;
+  skipped_length_   = 0;
+}
+
+int StatusPacketParser::parse(const uint8_t *data, int length, int *consumed)
+{
+  int used = 0;
+  int result = PARSE_INCOMPLETE;
+
+  while (used < length && result == PARSE_INCOMPLETE)
+  {
+    int n = parseBytes(data + used, length - used);
+    if (n < 0)
+    {
+      // the packet is complete, -n bytes were used for it
+      n = -n;
+      result = (MCY_MAKEWORD(packet_[index_ - 2], packet_[index_ - 1]) == crc_) ? PARSE_PACKET : PARSE_CRC_ERROR;
+    }
+    used += n;
+  }
+
+  received_length_ += used;
+  if (consumed != 0)
+    *consumed = used;
+  return result;
+}
+
+uint8_t StatusPacketParser::getId()
+{
+  return packet_[PKT_ID];
+}
+
+uint8_t StatusPacketParser::getError()
+{
+  return packet_[PKT_ERROR];
+}
+
+uint8_t *StatusPacketParser::getParameter()
+{
+  return &packet_[PKT_PARAMETER0];
+}
+
+uint16_t StatusPacketParser::getParameterLength()
+{
+  return (uint16_t)(index_ - PKT_PARAMETER0 - 2);   // 2: CRC16_L CRC16_H
+}
+
+// returns the number of bytes used, negated when they completed a packet
+int StatusPacketParser::parseBytes(const uint8_t *data, int length)
+{
+  int i = 0;
+
+  while (i < length)
+  {
+    uint8_t b = data[i];
+
+    switch (state_)
+    {
+      case STATE_HEADER0:
+      {
+        // everything up to the next 0xFF is noise
+        const uint8_t *header = (const uint8_t *)memchr(data + i, 0xFF, length - i);
+        if (header == NULL)
+        {
+          skipped_length_ += length - i;
+          return length;
+        }
+        skipped_length_ += (uint32_t)(header - (data + i));
+        i = (int)(header - data) + 1;
+        state_ = STATE_HEADER1;
+        break;
+      }
+
+      case STATE_HEADER1:
+        i++;
+        if (b == 0xFF)
+        {
+          state_ = STATE_HEADER2;
+        }
+        else
+        {
+          skipped_length_ += 2;
+          state_ = STATE_HEADER0;
+        }
+        break;
+
+      case STATE_HEADER2:
+        i++;
+        if (b == 0xFD)
+        {
+          packet_[0] = 0xFF;
+          packet_[1] = 0xFF;
+          packet_[2] = 0xFD;
+          index_ = PKT_RESERVED;
+          state_ = STATE_RESERVED;
+        }
+        else if (b == 0xFF)
+        {
+          // FF FF FF: the header may start at the second byte
+          skipped_length_ += 1;
+        }
+        else
+        {
+          skipped_length_ += 3;
+          state_ = STATE_HEADER0;
+        }
+        break;
+
+      case STATE_RESERVED:
+        i++;
+        packet_[index_++] = b;
+        if (b == 0x00)
+          state_ = STATE_ID;
+        else
+          resync();
+        break;
+
+      case STATE_ID:
+        i++;
+        packet_[index_++] = b;
+        if (b <= MAX_ID || b == BROADCAST_ID)   // Fast Sync / Bulk Read answer with the broadcast ID
+          state_ = STATE_LENGTH_L;
+        else
+          resync();
+        break;
+
+      case STATE_LENGTH_L:
+        i++;
+        packet_[index_++] = b;
+        state_ = STATE_LENGTH_H;
+        break;
+
+      case STATE_LENGTH_H:
+      {
+        i++;
+        packet_[index_++] = b;
+
+        uint16_t packet_length = MCY_MAKEWORD(packet_[PKT_LENGTH_L], packet_[PKT_LENGTH_H]);
+        if (packet_length < MIN_PACKET_LENGTH || packet_length > capacity_ - (PKT_LENGTH_H + 1))
+        {
+          resync();
+          break;
+        }
+
+        body_remaining_   = packet_length - 2;
+        crc_              = Crc16::update(0, packet_, PKT_INSTRUCTION);
+        stuffing_window_  = ((uint32_t)packet_[PKT_LENGTH_L] << 8) | packet_[PKT_LENGTH_H];
+        state_            = STATE_BODY;
+        break;
+      }
+
+      case STATE_BODY:
+      {
+        if (index_ == PKT_INSTRUCTION && b != INST_STATUS)
+        {
+          i++;
+          packet_[index_++] = b;
+          resync();
+          break;
+        }
+
+        uint16_t n = (length - i < body_remaining_) ? (uint16_t)(length - i) : body_remaining_;
+        crc_ = Crc16::update(crc_, data + i, n);
+        copyBody(data + i, n);
+        i += n;
+
+        body_remaining_ -= n;
+        if (body_remaining_ == 0)
+        {
+          body_remaining_ = 2;
+          state_ = STATE_CRC;
+        }
+        break;
+      }
+
+      case STATE_CRC:
+        i++;
+        packet_[index_++] = b;
+        if (--body_remaining_ == 0)
+        {
+          // the length field describes the packet without stuffing from here on
+          uint16_t packet_length = index_ - (PKT_LENGTH_H + 1);
+          packet_[PKT_LENGTH_L] = MCY_LOBYTE(packet_length);
+          packet_[PKT_LENGTH_H] = MCY_HIBYTE(packet_length);
+          state_ = STATE_HEADER0;
+          return -i;
+        }
+        break;
+    }
+  }
+
+  return i;
+}
+
+void StatusPacketParser::resync()
+{
+  // FF FF FD was not the start of a status packet, the bytes after it are searched again
+  uint8_t pending[PKT_INSTRUCTION + 1];
+  int     pending_length = index_ - PKT_RESERVED;
+
+  memcpy(pending, packet_ + PKT_RESERVED, pending_length);
+  skipped_length_ += PKT_RESERVED;
+  state_ = STATE_HEADER0;
+  index_ = 0;
+
+  // too short to complete a packet
+  parseBytes(pending, pending_length);
+}
+
+void StatusPacketParser::copyBody(const uint8_t *data, uint16_t length)
+{
+  // FF FF FD FD on the wire carries FF FF FD, the last 0xFD is the stuffing.
+  // The first bytes may follow FF FF FD of an earlier call, which the window holds
+  uint16_t i = 0;
+  for (; i < length && i < 3; i++)
+  {
+    if (data[i] != 0xFD || (stuffing_window_ & 0xFFFFFF) != 0xFFFFFD)
+      packet_[index_++] = data[i];
+    stuffing_window_ = (stuffing_window_ << 8) | data[i];
+  }
+  if (i == length)
+    return;
+
+  // the others can only follow FF FF FD of this call
+  index_ += ByteStuffing::unstuff(data, i, length, packet_ + index_);
+
+  stuffing_window_ = ((uint32_t)data[length - 3] << 16) | ((uint32_t)data[length - 2] << 8) | data[length - 1];
+}
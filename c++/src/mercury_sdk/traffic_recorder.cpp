@@ -0,0 +1,122 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "traffic_recorder.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "traffic_recorder.h"
+#endif
+
+#include "monotonic_clock.h"
+
+using namespace mercury;
+
+static_assert(sizeof(TrafficRecorder::FileHeader) == 64, "the file header has a fixed layout");
+static_assert(sizeof(TrafficRecorder::Record) == 16, "the record header has a fixed layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the file is shared through lock free atomics");
+
+TrafficRecorder::TrafficRecorder()
+  : base_(0),
+    header_(0),
+    capacity_(0),
+    fd_(-1)
+{
+}
+
+TrafficRecorder::~TrafficRecorder()
+{
+  close();
+}
+
+bool TrafficRecorder::open(const char *path, uint64_t capacity)
+{
+  close();
+
+#if defined(__linux__)
+  if (capacity < MIN_CAPACITY_)
+    capacity = MIN_CAPACITY_;
+
+  fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0)
+    return false;
+
+  // allocate the blocks now, so that a full disk cannot fault a write into the mapping later
+  if (posix_fallocate(fd_, 0, (off_t)capacity) != 0 && ftruncate(fd_, (off_t)capacity) != 0)
+  {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  void *base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (base == MAP_FAILED)
+  {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  struct timespec realtime;
+  clock_gettime(CLOCK_REALTIME, &realtime);
+
+  base_     = (uint8_t *)base;
+  capacity_ = capacity;
+
+  FileHeader *header = (FileHeader *)base_;
+  memcpy(header->magic, "MCYTRAF", 8);
+  header->version         = VERSION_;
+  header->header_size     = sizeof(FileHeader);
+  header->capacity        = capacity;
+  header->start_time      = MonotonicClock::getTime();
+  header->start_realtime  = (int64_t)realtime.tv_sec * MonotonicClock::NSEC_PER_SEC + realtime.tv_nsec;
+  header->end.store(sizeof(FileHeader), std::memory_order_relaxed);
+  header->dropped_count.store(0, std::memory_order_relaxed);
+  header->reserved        = 0;
+
+  header_ = header;
+  return true;
+#else
+  (void)path;
+  (void)capacity;
+  return false;
+#endif
+}
+
+void TrafficRecorder::close()
+{
+#if defined(__linux__)
+  if (header_ == 0)
+    return;
+
+  uint64_t end = header_->end.load(std::memory_order_acquire);
+  header_ = 0;
+
+  munmap(base_, capacity_);
+  // the header holds the end of the records, so a file which cannot be cut only keeps its zero filled tail
+  int result = ftruncate(fd_, (off_t)end);
+  (void)result;
+  ::close(fd_);
+
+  base_     = 0;
+  capacity_ = 0;
+  fd_       = -1;
+#endif
+}
@@ -0,0 +1,237 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+#include "transaction_metrics.h"
+#elif defined(_WIN32) || defined(_WIN64)
+#define WINDLLEXPORT
+#include "transaction_metrics.h"
+#endif
+
+#include <string.h>
+
+#include "monotonic_clock.h"
+#include "packet_handler.h"
+
+#define PKT_ID                  4
+#define PKT_INSTRUCTION         7
+
+using namespace mercury;
+
+TransactionMetrics::TransactionMetrics()
+  : type_(TRANSACTION_OTHER),
+    id_(0),
+    start_time_(0),
+    trace_callback_(0),
+    trace_user_data_(0)
+{
+  memset(&timing_, 0, sizeof(timing_));
+  for (int id = 0; id < 256; id++)
+    servos_[id].store(0, std::memory_order_relaxed);
+  clear();
+}
+
+TransactionMetrics::~TransactionMetrics()
+{
+  for (int id = 0; id < 256; id++)
+    delete servos_[id].load(std::memory_order_relaxed);
+}
+
+TransactionMetrics::TransactionType TransactionMetrics::getTransactionType(uint8_t instruction)
+{
+  switch (instruction)
+  {
+    case INST_PING:           return TRANSACTION_PING;
+    case INST_READ:           return TRANSACTION_READ;
+    case INST_WRITE:          return TRANSACTION_WRITE;
+    case INST_REG_WRITE:      return TRANSACTION_REG_WRITE;
+    case INST_ACTION:         return TRANSACTION_ACTION;
+    case INST_FACTORY_RESET:  return TRANSACTION_FACTORY_RESET;
+    case INST_REBOOT:         return TRANSACTION_REBOOT;
+    case INST_CLEAR:          return TRANSACTION_CLEAR;
+    case INST_SYNC_READ:      return TRANSACTION_SYNC_READ;
+    case INST_SYNC_WRITE:     return TRANSACTION_SYNC_WRITE;
+    case INST_FAST_SYNC_READ: return TRANSACTION_FAST_SYNC_READ;
+    case INST_BULK_READ:      return TRANSACTION_BULK_READ;
+    case INST_BULK_WRITE:     return TRANSACTION_BULK_WRITE;
+    case INST_FAST_BULK_READ: return TRANSACTION_FAST_BULK_READ;
+    default:                  return TRANSACTION_OTHER;
+  }
+}
+
+const char *TransactionMetrics::getTransactionName(TransactionType type)
+{
+  switch (type)
+  {
+    case TRANSACTION_PING:            return "Ping";
+    case TRANSACTION_READ:            return "Read";
+    case TRANSACTION_WRITE:           return "Write";
+    case TRANSACTION_REG_WRITE:       return "RegWrite";
+    case TRANSACTION_ACTION:          return "Action";
+    case TRANSACTION_FACTORY_RESET:   return "FactoryReset";
+    case TRANSACTION_REBOOT:          return "Reboot";
+    case TRANSACTION_CLEAR:           return "Clear";
+    case TRANSACTION_SYNC_READ:       return "SyncRead";
+    case TRANSACTION_SYNC_WRITE:      return "SyncWrite";
+    case TRANSACTION_FAST_SYNC_READ:  return "FastSyncRead";
+    case TRANSACTION_BULK_READ:       return "BulkRead";
+    case TRANSACTION_BULK_WRITE:      return "BulkWrite";
+    case TRANSACTION_FAST_BULK_READ:  return "FastBulkRead";
+    default:                          return "Other";
+  }
+}
+
+void TransactionMetrics::clear()
+{
+  for (int t = 0; t < TRANSACTION_TYPE_COUNT; t++)
+  {
+    TypeMetrics &type = types_[t];
+    type.latency.clear();
+    type.transaction_count.store(0, std::memory_order_relaxed);
+    type.timeout_count.store(0, std::memory_order_relaxed);
+    type.corrupt_count.store(0, std::memory_order_relaxed);
+  }
+
+  for (int id = 0; id < 256; id++)
+  {
+    ServoMetrics *servo = servos_[id].load(std::memory_order_relaxed);
+    if (servo == 0)
+      continue;
+    servo->latency.clear();
+    servo->status_count.store(0, std::memory_order_relaxed);
+    servo->timeout_count.store(0, std::memory_order_relaxed);
+    servo->corrupt_count.store(0, std::memory_order_relaxed);
+    servo->crc_error_count.store(0, std::memory_order_relaxed);
+  }
+
+  tx_bytes_.store(0, std::memory_order_relaxed);
+  rx_bytes_.store(0, std::memory_order_relaxed);
+}
+
+void TransactionMetrics::beginTransaction(const uint8_t *packet, uint16_t length)
+{
+  start_time_ = MonotonicClock::getTime();
+  add(tx_bytes_, length);
+
+  if (length <= PKT_INSTRUCTION)
+  {
+    type_ = TRANSACTION_OTHER;
+    id_   = 0;
+  }
+  else
+  {
+    type_ = getTransactionType(packet[PKT_INSTRUCTION]);
+    id_   = packet[PKT_ID];
+  }
+  add(types_[type_].transaction_count, 1);
+
+  if (trace_callback_ == 0)
+    return;
+
+  // a packet handler which didn't mark the build has the packet ready when it writes it
+  if (timing_.build_time == 0)
+    timing_.build_time = start_time_;
+  timing_.type          = type_;
+  timing_.id            = id_;
+  timing_.tx_length     = length;
+  timing_.rx_length     = 0;
+  timing_.write_time    = start_time_;
+  timing_.first_rx_time = 0;
+  timing_.last_rx_time  = 0;
+
+  // nothing answers these packets, so their transaction ends here
+  bool is_read = (type_ == TRANSACTION_PING || type_ == TRANSACTION_READ || type_ == TRANSACTION_SYNC_READ ||
+                  type_ == TRANSACTION_FAST_SYNC_READ || type_ == TRANSACTION_BULK_READ || type_ == TRANSACTION_FAST_BULK_READ);
+  if (type_ == TRANSACTION_SYNC_WRITE || type_ == TRANSACTION_BULK_WRITE || type_ == TRANSACTION_ACTION ||
+      (id_ == BROADCAST_ID && is_read == false))
+    trace(COMM_SUCCESS, start_time_);
+}
+
+void TransactionMetrics::endStatus(uint8_t id, int result)
+{
+  ServoMetrics *servo = getServo(id);
+  add(servo->status_count, 1);
+
+  if (result == COMM_SUCCESS)
+    servo->latency.record(MonotonicClock::getTime() - start_time_);
+  else if (result == COMM_RX_TIMEOUT)
+    add(servo->timeout_count, 1);
+  else if (result == COMM_RX_CORRUPT)
+    add(servo->corrupt_count, 1);
+}
+
+void TransactionMetrics::endTransaction(int result)
+{
+  TypeMetrics &type = types_[type_];
+  int64_t now = MonotonicClock::getTime();
+
+  if (result == COMM_SUCCESS)
+    type.latency.record(now - start_time_);
+  else if (result == COMM_RX_TIMEOUT)
+    add(type.timeout_count, 1);
+  else if (result == COMM_RX_CORRUPT)
+    add(type.corrupt_count, 1);
+
+  if (trace_callback_ != 0)
+    trace(result, now);
+}
+
+void TransactionMetrics::countCrcError(uint8_t id)
+{
+  add(getServo(id)->crc_error_count, 1);
+}
+
+TransactionMetrics::ServoMetrics *TransactionMetrics::getServo(uint8_t id)
+{
+  ServoMetrics *servo = servos_[id].load(std::memory_order_acquire);
+  if (servo != 0)
+    return servo;
+
+  // the readers see the metrics only once they are complete
+  servo = new ServoMetrics();
+  servo->status_count.store(0, std::memory_order_relaxed);
+  servo->timeout_count.store(0, std::memory_order_relaxed);
+  servo->corrupt_count.store(0, std::memory_order_relaxed);
+  servo->crc_error_count.store(0, std::memory_order_relaxed);
+
+  // the port moves between threads, so the slot is published once, whoever comes first
+  ServoMetrics *published = 0;
+  if (servos_[id].compare_exchange_strong(published, servo, std::memory_order_acq_rel, std::memory_order_acquire) == false)
+  {
+    delete servo;
+    return published;
+  }
+  return servo;
+}
+
+void TransactionMetrics::traceRx(int length)
+{
+  int64_t now = MonotonicClock::getTime();
+  if (timing_.first_rx_time == 0)
+    timing_.first_rx_time = now;
+  timing_.last_rx_time  = now;
+  timing_.rx_length    += (uint32_t)length;
+}
+
+void TransactionMetrics::trace(int result, int64_t parse_time)
+{
+  timing_.result      = result;
+  timing_.parse_time  = parse_time;
+  trace_callback_(&timing_, trace_user_data_);
+
+  // the next build is marked by its packet handler, or set by TransactionMetrics::beginTransaction()
+  timing_.build_time  = 0;
+}
@@ -0,0 +1,269 @@
+/*******************************************************************************
+* Copyright (C) 2021 <Robot Articulation/code@robotarticulation.com> 
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "virtual_bus.h"
+#include "monotonic_clock.h"
+
+using namespace mercury;
+
+VirtualBus::VirtualBus()
+  : master_fd_(-1),
+    slave_fd_(-1),
+    stop_fd_(-1),
+    is_timed_(false),
+    packet_count_(0)
+{
+  port_name_[0] = 0;
+}
+
+VirtualBus::~VirtualBus()
+{
+  close();
+}
+
+bool VirtualBus::open()
+{
+  close();
+
+  master_fd_ = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (master_fd_ < 0)
+    return false;
+
+  if (grantpt(master_fd_) != 0 || unlockpt(master_fd_) != 0 || ptsname_r(master_fd_, port_name_, sizeof(port_name_)) != 0)
+  {
+    close();
+    return false;
+  }
+
+  // raw until a port handler sets the slave up
+  slave_fd_ = ::open(port_name_, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  stop_fd_  = eventfd(0, EFD_NONBLOCK);
+  if (slave_fd_ < 0 || stop_fd_ < 0)
+  {
+    close();
+    return false;
+  }
+
+  struct termios tio;
+  tcgetattr(slave_fd_, &tio);
+  cfmakeraw(&tio);
+  cfsetspeed(&tio, B1000000);
+  tcsetattr(slave_fd_, TCSANOW, &tio);
+
+  bus_.clearPort();
+  bus_.clearResponses();
+  packet_count_ = 0;
+  return true;
+}
+
+void VirtualBus::close()
+{
+  stop();
+
+  if (master_fd_ != -1)
+    ::close(master_fd_);
+  if (slave_fd_ != -1)
+    ::close(slave_fd_);
+  if (stop_fd_ != -1)
+    ::close(stop_fd_);
+
+  master_fd_    = -1;
+  slave_fd_     = -1;
+  stop_fd_      = -1;
+  port_name_[0] = 0;
+}
+
+bool VirtualBus::start()
+{
+  if (master_fd_ == -1)
+    return false;
+  if (thread_.joinable())
+    return true;
+
+  thread_ = std::thread(&VirtualBus::run, this);
+  return true;
+}
+
+void VirtualBus::stop()
+{
+  if (thread_.joinable() == false)
+    return;
+
+  // the thread has to be joined whatever happens, or the next start() finds it joinable
+  // and the destructor of std::thread terminates the process
+  uint64_t one = 1;
+  while (write(stop_fd_, &one, sizeof(one)) < 0 && errno == EINTR)
+    continue;
+  thread_.join();
+
+  // drain the eventfd for the next start
+  uint64_t count;
+  if (read(stop_fd_, &count, sizeof(count)) < 0)
+    count = 0;
+}
+
+void VirtualBus::run()
+{
+  uint8_t buffer[PortHandler::TX_PACKET_LENGTH_];
+
+  struct pollfd pfd[2];
+  pfd[0].fd       = master_fd_;
+  pfd[0].events   = POLLIN;
+  pfd[1].fd       = stop_fd_;
+  pfd[1].events   = POLLIN;
+
+  while (true)
+  {
+    pfd[0].revents = 0;
+    pfd[1].revents = 0;
+    if (poll(pfd, 2, -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    if (pfd[1].revents & POLLIN)
+      break;
+    if ((pfd[0].revents & POLLIN) == 0)
+      continue;
+
+    int length = read(master_fd_, buffer, sizeof(buffer));
+    if (length <= 0)
+      continue;
+
+    // the bytes are taken to have started on the wire when they were read
+    int64_t now = MonotonicClock::getTime();
+    bus_.setBaudRate(getSlaveBaudRate());
+    int64_t byte_time = MonotonicClock::NSEC_PER_SEC * 10 / bus_.getBaudRate();
+
+    packet_count_ += bus_.receive(buffer, length);
+    respond(now + byte_time * length, byte_time);
+  }
+}
+
+// the status packets follow the instruction packet as PortHandlerEmulator schedules them
+void VirtualBus::respond(int64_t rx_end_time, int64_t byte_time)
+{
+  int64_t time = rx_end_time;
+
+  const uint8_t *data = bus_.getResponseData();
+  for (int i = 0; i < bus_.getResponseCount(); i++)
+  {
+    const BusEmulator::Response &response = bus_.getResponse(i);
+
+    if (is_timed_)
+    {
+      time += (int64_t)(response.delay * (double)MonotonicClock::NSEC_PER_USEC) + byte_time * response.length;
+
+      struct timespec ts;
+      ts.tv_sec   = (time_t)(time / MonotonicClock::NSEC_PER_SEC);
+      ts.tv_nsec  = (long)(time % MonotonicClock::NSEC_PER_SEC);
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) { }
+    }
+
+    if (writeMaster(data + response.offset, response.length) == false)
+      break;
+  }
+
+  bus_.clearResponses();
+}
+
+bool VirtualBus::writeMaster(const uint8_t *data, uint32_t length)
+{
+  while (length > 0)
+  {
+    int written = write(master_fd_, data, length);
+    if (written < 0)
+    {
+      if (errno != EAGAIN && errno != EINTR)
+        return false;
+
+      // the tty buffer of the slave is full until the port handler reads
+      struct pollfd pfd;
+      pfd.fd      = master_fd_;
+      pfd.events  = POLLOUT;
+      pfd.revents = 0;
+      poll(&pfd, 1, 100);
+      continue;
+    }
+    data   += written;
+    length -= written;
+  }
+  return true;
+}
+
+int VirtualBus::getSlaveBaudRate()
+{
+  struct termios tio;
+  if (tcgetattr(master_fd_, &tio) != 0)
+    return PortHandler::DEFAULT_BAUDRATE_;
+
+  switch (cfgetospeed(&tio))
+  {
+    case B9600:
+      return 9600;
+    case B19200:
+      return 19200;
+    case B38400:
+      return 38400;
+    case B57600:
+      return 57600;
+    case B115200:
+      return 115200;
+    case B230400:
+      return 230400;
+    case B460800:
+      return 460800;
+    case B500000:
+      return 500000;
+    case B576000:
+      return 576000;
+    case B921600:
+      return 921600;
+    case B1000000:
+      return 1000000;
+    case B1152000:
+      return 1152000;
+    case B1500000:
+      return 1500000;
+    case B2000000:
+      return 2000000;
+    case B2500000:
+      return 2500000;
+    case B3000000:
+      return 3000000;
+    case B3500000:
+      return 3500000;
+    case B4000000:
+      return 4000000;
+    default:
+      return PortHandler::DEFAULT_BAUDRATE_;
+  }
+}
+
+#endif